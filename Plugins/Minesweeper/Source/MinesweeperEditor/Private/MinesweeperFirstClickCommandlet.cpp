@@ -0,0 +1,190 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperFirstClickCommandlet.h"
+#include "MinesweeperGenerateCommandlet.h"
+#include "MinesweeperEditorModule.h"
+#include "MinesweeperBoardGenerator.h"
+#include "MinesweeperFirstClick.h"
+#include "MinesweeperBot.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperFirstClickCommandletPrivate
+{
+	/** Games simulated per task, small enough to spread the cells of a small board over every core. */
+	static const int32 GamesPerChunk = 100;
+
+	/** Maps a cell to the cell representing it under the reflections of the board, and the diagonal of square boards. */
+	int32 GetRepresentativeCell(const FMinesweeperDifficulty& InDifficulty, const int32 InCellIndex)
+	{
+		int32 cellX = InCellIndex % InDifficulty.Width;
+		int32 cellY = InCellIndex / InDifficulty.Width;
+		cellX = FMath::Min(cellX, InDifficulty.Width - 1 - cellX);
+		cellY = FMath::Min(cellY, InDifficulty.Height - 1 - cellY);
+		if (InDifficulty.Width == InDifficulty.Height && cellX > cellY)
+		{
+			Swap(cellX, cellY);
+		}
+		return (InDifficulty.Width * cellY) + cellX;
+	}
+}
+
+
+
+
+UMinesweeperFirstClickCommandlet::UMinesweeperFirstClickCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+
+int32 UMinesweeperFirstClickCommandlet::Main(const FString& Params)
+{
+	using namespace MinesweeperFirstClickCommandletPrivate;
+
+	FString difficultiesText = TEXT("Beginner,Intermediate,Expert,Max,8x8x10,24x24x99");
+	FParse::Value(*Params, TEXT("Difficulties="), difficultiesText, false);
+
+	int32 numGames = 2000;
+	FParse::Value(*Params, TEXT("Games="), numGames);
+	numGames = FMath::Max(numGames, 1);
+
+	int32 baseSeed = 0;
+	FParse::Value(*Params, TEXT("Seed="), baseSeed);
+
+	FString outputFilename = FMinesweeperFirstClickTable::GetDefaultFilename();
+	FParse::Value(*Params, TEXT("Output="), outputFilename);
+
+	const bool bUseGuessSearch = !FParse::Param(*Params, TEXT("NoGuessSearch"));
+
+	TArray<FString> difficultyNames;
+	difficultiesText.ParseIntoArray(difficultyNames, TEXT(","));
+
+	TArray<FMinesweeperDifficulty> difficulties;
+	for (const FString& difficultyName : difficultyNames)
+	{
+		FMinesweeperDifficulty difficulty;
+		if (!UMinesweeperGenerateCommandlet::ParseDifficulty(difficultyName, difficulty))
+		{
+			UE_LOG(LogMinesweeperEditor, Error, TEXT("Invalid difficulty '%s'. Use Beginner, Intermediate, Expert, Max or WidthxHeightxMines."), *difficultyName);
+			return 1;
+		}
+		difficulties.Add(difficulty);
+	}
+
+	const int32 numThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+	const int32 chunksPerCell = FMath::DivideAndRoundUp(numGames, GamesPerChunk);
+
+	TArray<FMinesweeperFirstClickEntry> entries;
+
+	for (const FMinesweeperDifficulty& difficulty : difficulties)
+	{
+		// cells that are reflections of each other win equally often, so only one of each is played
+		TArray<int32> cells;
+		for (int32 cellIndex = 0; cellIndex < difficulty.TotalCells(); ++cellIndex)
+		{
+			if (GetRepresentativeCell(difficulty, cellIndex) == cellIndex)
+			{
+				cells.Add(cellIndex);
+			}
+		}
+
+		TArray<int32> chunkWins;
+		chunkWins.SetNumZeroed(cells.Num() * chunksPerCell);
+
+		const double startTime = FPlatformTime::Seconds();
+
+		// every cell plays the same seeds, the wins of a chunk are only written by its task
+		ParallelFor(chunkWins.Num(), [&](const int32 InChunkIndex)
+			{
+				const int32 cellIndex = cells[InChunkIndex / chunksPerCell];
+				const int32 startGame = (InChunkIndex % chunksPerCell) * GamesPerChunk;
+				const int32 endGame = FMath::Min(startGame + GamesPerChunk, numGames);
+
+				FMinesweeperBot bot;
+				bot.SetUseGuessSearch(bUseGuessSearch);
+
+				FMinesweeperBoard board;
+				TArray<int32> candidates;
+
+				for (int32 gameIndex = startGame; gameIndex < endGame; ++gameIndex)
+				{
+					FMinesweeperGenerationParams params;
+					params.Difficulty = difficulty;
+					params.FirstClickIndex = cellIndex;
+					params.Seed = baseSeed + gameIndex;
+
+					FMinesweeperRandomStream randStream = FMinesweeperBoardGenerator::MakeAttemptStream(params, 0);
+					FMinesweeperBoardGenerator::PlaceMines(board, difficulty, cellIndex, false, randStream, candidates);
+					board.ComputeOpenings();
+
+					if (bot.Play(board, cellIndex).bWon)
+					{
+						++chunkWins[InChunkIndex];
+					}
+				}
+			});
+
+		const double seconds = FMath::Max(FPlatformTime::Seconds() - startTime, SMALL_NUMBER);
+
+		// most wins, then the likelier opening, then the lowest index
+		TArray<int32> cellWins;
+		cellWins.SetNumZeroed(cells.Num());
+		int32 bestSlot = 0;
+		for (int32 slot = 0; slot < cells.Num(); ++slot)
+		{
+			for (int32 chunk = 0; chunk < chunksPerCell; ++chunk)
+			{
+				cellWins[slot] += chunkWins[(slot * chunksPerCell) + chunk];
+			}
+
+			if (cellWins[slot] > cellWins[bestSlot] || (cellWins[slot] == cellWins[bestSlot]
+				&& FMinesweeperFirstClickTable::ComputeOpeningProbability(difficulty, cells[slot]) > FMinesweeperFirstClickTable::ComputeOpeningProbability(difficulty, cells[bestSlot])))
+			{
+				bestSlot = slot;
+			}
+		}
+
+		FMinesweeperFirstClickEntry& entry = entries.AddDefaulted_GetRef();
+		entry.Width = difficulty.Width;
+		entry.Height = difficulty.Height;
+		entry.MineCount = difficulty.MineCount;
+		entry.BestCellIndex = (uint16)cells[bestSlot];
+		entry.OpeningCellIndex = (uint16)FMinesweeperFirstClickTable::FindBestOpeningCell(difficulty);
+		entry.WinRate = (float)cellWins[bestSlot] / numGames;
+		entry.BestCellOpeningProbability = FMinesweeperFirstClickTable::ComputeOpeningProbability(difficulty, entry.BestCellIndex);
+		entry.OpeningCellOpeningProbability = FMinesweeperFirstClickTable::ComputeOpeningProbability(difficulty, entry.OpeningCellIndex);
+		entry.NumGamesPerCell = numGames;
+
+		const int32 centerSlot = cells.IndexOfByKey(GetRepresentativeCell(difficulty, (difficulty.Width * (difficulty.Height / 2)) + (difficulty.Width / 2)));
+		const double standardError = FMath::Sqrt(entry.WinRate * (1.0 - entry.WinRate) / numGames);
+
+		UE_LOG(LogMinesweeperEditor, Display, TEXT("%dx%d %d mines: best first click (%d, %d) wins %.2f%% +- %.2f and opens %.1f%%, center wins %.2f%%, corner opens %.1f%%. %d cells x %d games in %.1f s on %d cores."),
+			difficulty.Width, difficulty.Height, difficulty.MineCount,
+			entry.BestCellIndex % difficulty.Width, entry.BestCellIndex / difficulty.Width, entry.WinRate * 100.0, standardError * 100.0, entry.BestCellOpeningProbability * 100.0,
+			(double)cellWins[centerSlot] / numGames * 100.0, entry.OpeningCellOpeningProbability * 100.0,
+			cells.Num(), numGames, seconds, numThreads);
+	}
+
+	if (!FMinesweeperFirstClickTable::Save(outputFilename, entries))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogMinesweeperEditor, Display, TEXT("Wrote %d first clicks to '%s'."), entries.Num(), *outputFilename);
+	return 0;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,159 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperGenerateCommandlet.h"
+#include "MinesweeperEditorModule.h"
+#include "MinesweeperStatics.h"
+#include "MinesweeperBoardGenerator.h"
+#include "MinesweeperBoardMetrics.h"
+#include "MinesweeperBoardRating.h"
+#include "MinesweeperPuzzleDatabase.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "Misc/Paths.h"
+#include <atomic>
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+UMinesweeperGenerateCommandlet::UMinesweeperGenerateCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+
+int32 UMinesweeperGenerateCommandlet::Main(const FString& Params)
+{
+	FString difficultiesText = TEXT("Beginner,Intermediate,Expert");
+	FParse::Value(*Params, TEXT("Difficulties="), difficultiesText, false);
+
+	int32 numBoards = 100000;
+	FParse::Value(*Params, TEXT("Count="), numBoards);
+	numBoards = FMath::Max(numBoards, 1);
+
+	int32 baseSeed = 0;
+	FParse::Value(*Params, TEXT("Seed="), baseSeed);
+
+	FString outputFilename = FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("Minesweeper"), TEXT("Puzzles.mspz"));
+	FParse::Value(*Params, TEXT("Output="), outputFilename);
+
+	const EMinesweeperGenerationMode generationMode = FParse::Param(*Params, TEXT("NoGuess")) ? EMinesweeperGenerationMode::NoGuess : EMinesweeperGenerationMode::Random;
+
+	TArray<FString> difficultyNames;
+	difficultiesText.ParseIntoArray(difficultyNames, TEXT(","));
+
+	TArray<FMinesweeperDifficulty> difficulties;
+	for (const FString& difficultyName : difficultyNames)
+	{
+		FMinesweeperDifficulty difficulty;
+		if (!ParseDifficulty(difficultyName, difficulty))
+		{
+			UE_LOG(LogMinesweeperEditor, Error, TEXT("Invalid difficulty '%s'. Use Beginner, Intermediate, Expert, Max or WidthxHeightxMines."), *difficultyName);
+			return 1;
+		}
+		difficulties.Add(difficulty);
+	}
+
+	// the calling thread works alongside the task graph workers in ParallelFor
+	const int32 numThreads = FTaskGraphInterface::Get().GetNumWorkerThreads() + 1;
+
+	// many more chunks than threads, no-guess boards vary a lot in generation time
+	const int32 numChunks = FMath::Min(numThreads * 16, numBoards);
+
+	FMinesweeperPuzzleDatabaseWriter databaseWriter;
+
+	for (const FMinesweeperDifficulty& difficulty : difficulties)
+	{
+		const int32 sectionIndex = databaseWriter.AddSection(difficulty, numBoards);
+		const int32 firstClickIndex = (difficulty.Width * (difficulty.Height / 2)) + (difficulty.Width / 2);
+
+		std::atomic<int32> numNoGuess(0);
+		std::atomic<int64> totalThreeBV(0);
+		std::atomic<int64> totalGuesses(0);
+
+		// largest enumerated component of each chunk, only written by its task
+		TArray<int32> chunkMaxComponentSizes;
+		chunkMaxComponentSizes.SetNumZeroed(numChunks);
+
+		const double startTime = FPlatformTime::Seconds();
+
+		ParallelFor(numChunks, [&](const int32 InChunkIndex)
+			{
+				const int32 startIndex = (int32)(((int64)numBoards * InChunkIndex) / numChunks);
+				const int32 endIndex = (int32)(((int64)numBoards * (InChunkIndex + 1)) / numChunks);
+
+				FMinesweeperBoard board;
+				FMinesweeperBoardRater rater;
+
+				for (int32 recordIndex = startIndex; recordIndex < endIndex; ++recordIndex)
+				{
+					FMinesweeperGenerationParams params;
+					params.Difficulty = difficulty;
+					params.FirstClickIndex = firstClickIndex;
+					params.Seed = baseSeed + recordIndex;
+					params.Mode = generationMode;
+					params.NumWorkers = 1; // parallel across boards, not within a board
+
+					const FMinesweeperGenerationResult result = FMinesweeperBoardGenerator::Generate(params, board);
+
+					const bool bNoGuess = generationMode == EMinesweeperGenerationMode::NoGuess
+						? result.bSuccess
+						: FMinesweeperBoardGenerator::IsSolvableWithoutGuessing(board, firstClickIndex);
+
+					FMinesweeperBoardMetrics metrics = FMinesweeperBoardMetrics::Compute(board);
+					metrics.ZiNi = FMinesweeperBoardMetrics::EstimateZiNi(board);
+
+					// rated here so matchmaking can pick boards by solver effort without analyzing them at runtime
+					const FMinesweeperBoardRating rating = rater.Rate(board, firstClickIndex);
+
+					databaseWriter.WriteRecord(sectionIndex, recordIndex, board, metrics, rating, firstClickIndex, params.Seed, bNoGuess);
+
+					if (bNoGuess) ++numNoGuess;
+					totalThreeBV += metrics.ThreeBV;
+					totalGuesses += rating.Guesses;
+					chunkMaxComponentSizes[InChunkIndex] = FMath::Max(chunkMaxComponentSizes[InChunkIndex], rating.MaxComponentSize);
+				}
+			});
+
+		const double seconds = FMath::Max(FPlatformTime::Seconds() - startTime, SMALL_NUMBER);
+
+		UE_LOG(LogMinesweeperEditor, Display, TEXT("%dx%d %d mines: %d boards in %.2f s, %.0f boards/s, %.0f boards/s per core on %d cores, %d no-guess, mean 3BV %.1f, mean guesses %.2f, largest component %d"),
+			difficulty.Width, difficulty.Height, difficulty.MineCount, numBoards, seconds,
+			numBoards / seconds, numBoards / seconds / numThreads, numThreads,
+			numNoGuess.load(), (double)totalThreeBV.load() / numBoards, (double)totalGuesses.load() / numBoards, FMath::Max(chunkMaxComponentSizes));
+	}
+
+	if (!databaseWriter.Save(outputFilename))
+	{
+		return 1;
+	}
+
+	UE_LOG(LogMinesweeperEditor, Display, TEXT("Wrote %d sections to '%s'."), databaseWriter.NumSections(), *outputFilename);
+	return 0;
+}
+
+
+bool UMinesweeperGenerateCommandlet::ParseDifficulty(const FString& InText, FMinesweeperDifficulty& OutDifficulty)
+{
+	if (InText.Equals(TEXT("Beginner"), ESearchCase::IgnoreCase)) { OutDifficulty = UMinesweeperStatics::BeginnerDifficulty(); return true; }
+	if (InText.Equals(TEXT("Intermediate"), ESearchCase::IgnoreCase)) { OutDifficulty = UMinesweeperStatics::IntermediateDifficulty(); return true; }
+	if (InText.Equals(TEXT("Expert"), ESearchCase::IgnoreCase)) { OutDifficulty = UMinesweeperStatics::ExpertDifficulty(); return true; }
+	if (InText.Equals(TEXT("Max"), ESearchCase::IgnoreCase)) { OutDifficulty = UMinesweeperStatics::MaxDifficulty(); return true; }
+
+	TArray<FString> parts;
+	if (InText.ParseIntoArray(parts, TEXT("x")) != 3) return false;
+
+	OutDifficulty = FMinesweeperDifficulty(FCString::Atoi(*parts[0]), FCString::Atoi(*parts[1]), FCString::Atoi(*parts[2]));
+	return OutDifficulty.Width >= UMinesweeperGame::MinGridSize && OutDifficulty.Height >= UMinesweeperGame::MinGridSize
+		&& OutDifficulty.TotalCells() <= MAX_uint16 && OutDifficulty.MineCount >= 1 && OutDifficulty.MineCount < OutDifficulty.TotalCells();
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
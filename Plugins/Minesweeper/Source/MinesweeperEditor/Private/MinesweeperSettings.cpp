@@ -97,6 +97,12 @@ void UMinesweeperSettings::ResetToDefaults()
 
 	LastDifficulty = SMinesweeperWindow::DefaultDifficulty;
 
+	GenerationMode = EMinesweeperGenerationMode::Random;
+
+	EndlessMineDensity = 0.16f;
+
+	AutoFirstClick = false;
+
 	VisualTheme = UMinesweeperStatics::DefaultVisualTheme();
 	/*CellDrawSize = UMinesweeperStatics::DefaultCellDrawSize();
 	ClosedCellTexture = TSoftObjectPtr<UTexture2D>(UMinesweeperStatics::DefaultClosedCellTexture());
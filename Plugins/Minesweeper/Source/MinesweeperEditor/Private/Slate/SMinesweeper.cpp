@@ -262,15 +262,28 @@ bool SMinesweeper::IsGameActive() const
 
 void SMinesweeper::StartNewGame(const FMinesweeperDifficulty& InDifficulty)
 {
+	const UMinesweeperSettings* settings = UMinesweeperSettings::GetConst();
+
+	Game->SetGenerationMode(settings->GenerationMode);
+	Game->SetEndlessMineDensity(settings->EndlessMineDensity);
 	Game->SetupGame(InDifficulty);
 
-	const UMinesweeperSettings* settings = UMinesweeperSettings::GetConst();
 	GridWidget->SetupGridCanvas(Game.Get(), settings->VisualTheme);
+
+	if (settings->AutoFirstClick && Game->OpenRecommendedFirstClick())
+	{
+		GridWidget->UpdateResource();
+	}
 }
 
 void SMinesweeper::RestartGame()
 {
 	Game->RestartGame();
+
+	if (UMinesweeperSettings::GetConst()->AutoFirstClick)
+	{
+		Game->OpenRecommendedFirstClick();
+	}
 	GridWidget->UpdateResource();
 }
 
@@ -624,11 +624,16 @@ int32 SMinesweeperWindow::OnGameOverCallback(const bool InWon, const float InTim
 {
 	LastHighScoreRank = -1;
 
-	if (InWon && UMinesweeperStatics::IsExpertDifficulty(GameWidget->GetGame()->GetDifficulty()))
+	UMinesweeperGame* game = GameWidget->GetGame();
+
+	if (InWon && UMinesweeperStatics::IsExpertDifficulty(game->GetDifficulty()))
 	{
 		// calculate high score
-		// less time is higher score, less clicks is higher score
-		int32 score = FMath::FloorToInt32(((float)MaxScore / InTime) + ((float)MaxScore / (float)InClicks));
+		// less time is higher score, less clicks is higher score, harder boards weigh both by their 3BV relative to an average Expert board
+		// scores recorded before boards were rated hold no 3BV and are on the scale of an average board, unrated boards count as one
+		const int32 threeBV = game->GetBoardMetrics().ThreeBV;
+		const float boardWeight = threeBV > 0 ? (float)threeBV / ExpectedExpertThreeBV : 1.0f;
+		int32 score = FMath::FloorToInt32((((float)MaxScore / InTime) + ((float)MaxScore / (float)InClicks)) * boardWeight);
 
 		// check for new high score
 		for (int32 rank = 0; rank < Settings->HighScores.Num(); ++rank)
@@ -643,7 +648,7 @@ int32 SMinesweeperWindow::OnGameOverCallback(const bool InWon, const float InTim
 		// insert the new high score into the list and remove the last rank if we have a new high score
 		if (LastHighScoreRank > -1)
 		{
-			Settings->HighScores.Insert(FMinesweeperHighScore(Settings->LastPlayerName, score, InTime, InClicks), LastHighScoreRank);
+			Settings->HighScores.Insert(FMinesweeperHighScore(Settings->LastPlayerName, score, InTime, InClicks, threeBV), LastHighScoreRank);
 			Settings->HighScores.RemoveAt(Settings->HighScores.Num() - 1);
 
 			HighScoresList->SetHighScores(&Settings->HighScores);
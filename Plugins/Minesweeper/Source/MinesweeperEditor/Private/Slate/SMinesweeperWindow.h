@@ -47,6 +47,9 @@ public:
 	/** Max score used in high score calculation. */
 	static const int32 MaxScore = 1000000;
 
+	/** Mean 3BV of random Expert boards. High scores are weighed by the 3BV of their board over this, so an average board scores as before boards were rated. */
+	static constexpr float ExpectedExpertThreeBV = 172.0f;
+
 
 private:
 	/** Settings saved to disk. */
@@ -0,0 +1,29 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MinesweeperFirstClickCommandlet.generated.h"
+
+
+
+
+/**
+ * Simulates bot games from every first click cell of each difficulty and writes the cell with the best win rate to the first click
+ * table shipped with the plugin, see FMinesweeperFirstClickTable. Runs headless:
+ *
+ * UnrealEditor-Cmd <Project> -run=MinesweeperFirstClick [-Difficulties=Beginner,Intermediate,Expert,Max,8x8x10,24x24x99] [-Games=2000] [-Seed=0] [-NoGuessSearch] [-Output=<File>]
+ */
+UCLASS()
+class MINESWEEPEREDITOR_API UMinesweeperFirstClickCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMinesweeperFirstClickCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+};
@@ -0,0 +1,32 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "MinesweeperDifficulty.h"
+#include "MinesweeperGenerateCommandlet.generated.h"
+
+
+
+
+/**
+ * Generates boards in bulk and writes them with their metrics and solver effort ratings into a puzzle database file. Runs headless:
+ *
+ * UnrealEditor-Cmd <Project> -run=MinesweeperGenerate -Difficulties=Beginner,Intermediate,Expert,16x16x40 -Count=1000000 [-NoGuess] [-Seed=0] [-Output=<File>]
+ */
+UCLASS()
+class MINESWEEPEREDITOR_API UMinesweeperGenerateCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UMinesweeperGenerateCommandlet();
+
+	//~ Begin UCommandlet Interface
+	virtual int32 Main(const FString& Params) override;
+	//~ End UCommandlet Interface
+
+	/** Parses a preset name or a WidthxHeightxMines difficulty whose cells fit puzzle records. */
+	static bool ParseDifficulty(const FString& InText, FMinesweeperDifficulty& OutDifficulty);
+
+};
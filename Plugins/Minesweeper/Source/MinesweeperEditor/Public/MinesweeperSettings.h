@@ -6,6 +6,7 @@
 #include "MinesweeperEditorModule.h"
 #include "MinesweeperDifficulty.h"
 #include "MinesweeperVisualTheme.h"
+#include "MinesweeperBoardGenerator.h"
 #include "MinesweeperSettings.generated.h"
 
 class UTexture2D;
@@ -38,9 +39,13 @@ struct MINESWEEPEREDITOR_API FMinesweeperHighScore
 	UPROPERTY(Config, EditAnywhere, Category = "HighScore")
 		int32 Clicks = 0;
 
+	/** 3BV of the board the high score was achieved on. 0 for scores recorded before boards were rated, which rank as if on a board of average 3BV. */
+	UPROPERTY(Config, EditAnywhere, Category = "HighScore")
+		int32 ThreeBV = 0;
+
 	FMinesweeperHighScore() { }
-	FMinesweeperHighScore(const FString& InName, const int32 InScore, const float InTime, const int32 InClicks = 0)
-		: Name(InName), Score(InScore), Time(InTime), Clicks(InClicks) { }
+	FMinesweeperHighScore(const FString& InName, const int32 InScore, const float InTime, const int32 InClicks = 0, const int32 InThreeBV = 0)
+		: Name(InName), Score(InScore), Time(InTime), Clicks(InClicks), ThreeBV(InThreeBV) { }
 };
 
 
@@ -113,6 +118,22 @@ public:
 			Tooltip = "The last saved difficulty settings that were entered for the game."))
 		FMinesweeperDifficulty LastDifficulty;
 
+	UPROPERTY(Config, EditAnywhere, Category = "General", Meta = (
+			DisplayName = "Generation Mode",
+			Tooltip = "How mines are placed for new games. No Guess only deals boards that can be cleared by logic from the first click."))
+		EMinesweeperGenerationMode GenerationMode;
+
+	UPROPERTY(Config, EditAnywhere, Category = "General", Meta = (
+			DisplayName = "Endless Mine Density",
+			Tooltip = "Fraction of cells holding a mine in Endless games, which ignore the mine count of the difficulty.",
+			ClampMin = "0.12", ClampMax = "0.5"))
+		float EndlessMineDensity;
+
+	UPROPERTY(Config, EditAnywhere, Category = "General", Meta = (
+			DisplayName = "Auto First Click",
+			Tooltip = "Opens the first click with the best simulated win rate as soon as a new game starts."))
+		bool AutoFirstClick;
+
 
 	UPROPERTY(Config, EditAnywhere, AdvancedDisplay, Category = "General", Meta = (
 			DisplayName = "Visual Theme",
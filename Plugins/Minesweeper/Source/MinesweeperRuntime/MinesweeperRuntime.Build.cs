@@ -40,5 +40,9 @@ public class MinesweeperRuntime : ModuleRules
 			}
         );
 
+
+		// first click table written by the MinesweeperFirstClick commandlet, staged so packaged games read it too
+		RuntimeDependencies.Add("$(PluginDir)/Resources/FirstClicks.msfc");
+
     }
 }
@@ -0,0 +1,920 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperRuntimeModule.h"
+#include "MinesweeperStatics.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperBoardGenerator.h"
+#include "MinesweeperBoardMetrics.h"
+#include "MinesweeperBoardRating.h"
+#include "MinesweeperStats.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperMaskSolver.h"
+#include "MinesweeperSweep.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperGuess.h"
+#include "MinesweeperFirstClick.h"
+#include "MinesweeperBot.h"
+#include "MinesweeperGame.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include "HAL/IConsoleManager.h"
+#include "UObject/Package.h"
+#include <atomic>
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperBenchmarks
+{
+	struct FPresetDifficulty
+	{
+		const TCHAR* Name;
+		FMinesweeperDifficulty Difficulty;
+	};
+
+	/** Beginner through the max grid size supported by the game. */
+	TArray<FPresetDifficulty> GetPresetDifficulties()
+	{
+		return {
+			{ TEXT("Beginner"), UMinesweeperStatics::BeginnerDifficulty() },
+			{ TEXT("Intermediate"), UMinesweeperStatics::IntermediateDifficulty() },
+			{ TEXT("Expert"), UMinesweeperStatics::ExpertDifficulty() },
+			{ TEXT("Max"), UMinesweeperStatics::MaxDifficulty() }
+		};
+	}
+
+	int32 ParseIntArg(const TArray<FString>& InArgs, const int32 InArgIndex, const int32 InDefaultValue)
+	{
+		return InArgs.IsValidIndex(InArgIndex) ? FCString::Atoi(*InArgs[InArgIndex]) : InDefaultValue;
+	}
+
+
+	/** Minesweeper.Benchmark.Generation [NumBoards] [NoGuess] */
+	void BenchmarkGeneration(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 100), 1);
+		const bool bNoGuess = ParseIntArg(InArgs, 1, 1) != 0;
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Generation benchmark: %d %s boards per difficulty."), numBoards, bNoGuess ? TEXT("no-guess") : TEXT("random"));
+
+		for (const FPresetDifficulty& preset : GetPresetDifficulties())
+		{
+			FMinesweeperLatencyTracker latencyTracker(numBoards);
+			FMinesweeperBoard board;
+
+			int64 totalAttempts = 0;
+			int32 numSucceeded = 0;
+			double totalSeconds = 0.0;
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+				params.Seed = boardIndex;
+				params.Mode = bNoGuess ? EMinesweeperGenerationMode::NoGuess : EMinesweeperGenerationMode::Random;
+
+				const FMinesweeperGenerationResult result = FMinesweeperBoardGenerator::Generate(params, board);
+
+				totalAttempts += result.Attempts;
+				totalSeconds += result.Seconds;
+				if (result.bSuccess) ++numSucceeded;
+				latencyTracker.AddSample(result.Seconds);
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %10.0f attempts/s, p50 %8.3f ms, p99 %8.3f ms, %d/%d succeeded"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				totalSeconds > 0.0 ? totalAttempts / totalSeconds : 0.0,
+				latencyTracker.GetPercentile(50.0f) * 1000.0, latencyTracker.GetPercentile(99.0f) * 1000.0,
+				numSucceeded, numBoards);
+		}
+	}
+
+
+	/** Minesweeper.Benchmark.Metrics [NumBoards] */
+	void BenchmarkMetrics(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 10000), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Metrics benchmark: 3BV and ZiNi of %d random boards per difficulty."), numBoards);
+
+		for (const FPresetDifficulty& preset : GetPresetDifficulties())
+		{
+			TArray<FMinesweeperBoard> boards;
+			boards.SetNum(numBoards);
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, boards[boardIndex]);
+			}
+
+			TArray<FMinesweeperBoardMetrics> metrics;
+			metrics.SetNum(numBoards);
+
+			double startTime = FPlatformTime::Seconds();
+			FMinesweeperBoardMetrics::ComputeBatch(boards, metrics, false, 1);
+			const double threeBVSeconds = FPlatformTime::Seconds() - startTime;
+
+			startTime = FPlatformTime::Seconds();
+			FMinesweeperBoardMetrics::ComputeBatch(boards, metrics, true, 1);
+			const double singleWorkerSeconds = FPlatformTime::Seconds() - startTime;
+
+			startTime = FPlatformTime::Seconds();
+			FMinesweeperBoardMetrics::ComputeBatch(boards, metrics, true);
+			const double allWorkersSeconds = FPlatformTime::Seconds() - startTime;
+
+			int64 totalThreeBV = 0;
+			int64 totalZiNi = 0;
+			for (const FMinesweeperBoardMetrics& boardMetrics : metrics)
+			{
+				totalThreeBV += boardMetrics.ThreeBV;
+				totalZiNi += boardMetrics.ZiNi;
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: 3BV only %10.0f boards/s, 3BV+ZiNi %10.0f boards/s on 1 worker, %10.0f boards/s on all workers, mean 3BV %.1f, mean ZiNi %.1f"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				threeBVSeconds > 0.0 ? numBoards / threeBVSeconds : 0.0,
+				singleWorkerSeconds > 0.0 ? numBoards / singleWorkerSeconds : 0.0,
+				allWorkersSeconds > 0.0 ? numBoards / allWorkersSeconds : 0.0,
+				(double)totalThreeBV / numBoards, (double)totalZiNi / numBoards);
+		}
+	}
+
+
+	/** Opens the first click and every cell the solver proves safe, flagging proven mines, until the solver has to guess. */
+	void PlayUntilStuck(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex, FMinesweeperSolver& OutSolver, FMinesweeperFrontier& OutFrontier)
+	{
+		OutSolver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+		OutFrontier.Init(InBoard.Width, InBoard.Height);
+
+		for (int32 cellIndex = InFirstClickIndex; cellIndex != INDEX_NONE; cellIndex = OutSolver.PopSafeCell())
+		{
+			OutSolver.RevealCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			OutFrontier.OpenCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			OutSolver.Solve();
+		}
+
+		for (const int32 mineIndex : OutSolver.GetKnownMines())
+		{
+			OutFrontier.SetFlagged(mineIndex, true);
+		}
+	}
+
+
+	/** Minesweeper.Benchmark.Probability [NumBoards] */
+	void BenchmarkProbability(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Probability benchmark: exact mine probabilities where logic gets stuck on %d random boards per difficulty."), numBoards);
+
+		for (const FPresetDifficulty& preset : GetPresetDifficulties())
+		{
+			FMinesweeperLatencyTracker latencyTracker(numBoards);
+			FMinesweeperBoard board;
+			FMinesweeperSolver solver;
+			FMinesweeperFrontier frontier;
+			FMinesweeperProbabilityEngine probabilityEngine;
+
+			int32 numPositions = 0;
+			int64 totalFrontierCells = 0;
+			int32 largestComponent = 0;
+			double totalSeconds = 0.0;
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, board);
+				PlayUntilStuck(board, params.FirstClickIndex, solver, frontier);
+				if (frontier.NumOpenedCells() == board.Num() - board.MineCount) continue; // solved without guessing
+
+				const FMinesweeperProbabilityResult result = probabilityEngine.Compute(frontier, board.MineCount);
+				if (!result.bSuccess) continue;
+
+				++numPositions;
+				totalFrontierCells += result.NumFrontierCells;
+				largestComponent = FMath::Max(largestComponent, result.LargestComponent);
+				totalSeconds += result.Seconds;
+				latencyTracker.AddSample(result.Seconds);
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %5d positions, mean %8.3f ms, p50 %8.3f ms, p99 %8.3f ms, mean frontier %.1f cells, largest component %d cells"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount, numPositions,
+				numPositions > 0 ? totalSeconds / numPositions * 1000.0 : 0.0,
+				latencyTracker.GetPercentile(50.0f) * 1000.0, latencyTracker.GetPercentile(99.0f) * 1000.0,
+				numPositions > 0 ? (double)totalFrontierCells / numPositions : 0.0, largestComponent);
+		}
+	}
+
+
+	/**
+	 * Plays a board with a solver until every safe cell is open. Whenever the solver is stuck the next safe cell it knows nothing about
+	 * is opened for it, as if a guess came off, so the whole board is worked through. Returns the number of such reveals.
+	 */
+	template <typename SolverType>
+	int32 SolveWithReveals(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex, SolverType& OutSolver)
+	{
+		OutSolver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+
+		int32 numReveals = 0;
+		int32 nextRevealIndex = 0;
+		int32 cellIndex = InFirstClickIndex;
+
+		while (cellIndex != INDEX_NONE)
+		{
+			OutSolver.RevealCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			OutSolver.Solve();
+
+			cellIndex = OutSolver.PopSafeCell();
+			if (cellIndex != INDEX_NONE) continue;
+
+			// cells only ever leave the unknown state, so the scan picks up where it stopped last time
+			while (nextRevealIndex < InBoard.Num() && (InBoard.HasMine(nextRevealIndex) || OutSolver.GetCellState(nextRevealIndex) != FMinesweeperSolver::Unknown))
+			{
+				++nextRevealIndex;
+			}
+			if (nextRevealIndex < InBoard.Num())
+			{
+				cellIndex = nextRevealIndex;
+				++numReveals;
+			}
+		}
+		return numReveals;
+	}
+
+
+	/** Minesweeper.Benchmark.Solver [NumBoards] */
+	void BenchmarkSolver(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Solver benchmark: scalar and bit mask solvers working through %d random boards per difficulty."), numBoards);
+
+		// beyond the game's own limits on purpose, the solvers are plain data and dense frontiers are where the masks should pay off
+		const TArray<FPresetDifficulty> presets = {
+			{ TEXT("Expert"), UMinesweeperStatics::ExpertDifficulty() },
+			{ TEXT("Dense"), FMinesweeperDifficulty(30, 30, 225) },
+			{ TEXT("Large"), FMinesweeperDifficulty(100, 100, 2000) }
+		};
+
+		for (const FPresetDifficulty& preset : presets)
+		{
+			const int32 firstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+
+			TArray<FMinesweeperBoard> boards;
+			boards.SetNum(numBoards);
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = firstClickIndex;
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, boards[boardIndex]);
+			}
+
+			FMinesweeperSolver scalarSolver;
+			int64 scalarReveals = 0;
+			double startTime = FPlatformTime::Seconds();
+			for (const FMinesweeperBoard& board : boards)
+			{
+				scalarReveals += SolveWithReveals(board, firstClickIndex, scalarSolver);
+			}
+			const double scalarSeconds = FPlatformTime::Seconds() - startTime;
+
+			FMinesweeperMaskSolver maskSolver;
+			int64 maskReveals = 0;
+			startTime = FPlatformTime::Seconds();
+			for (const FMinesweeperBoard& board : boards)
+			{
+				maskReveals += SolveWithReveals(board, firstClickIndex, maskSolver);
+			}
+			const double maskSeconds = FPlatformTime::Seconds() - startTime;
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %4d mines: scalar %10.0f boards/s %.2f reveals, masks %10.0f boards/s %.2f reveals, %.2fx"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				scalarSeconds > 0.0 ? numBoards / scalarSeconds : 0.0, (double)scalarReveals / numBoards,
+				maskSeconds > 0.0 ? numBoards / maskSeconds : 0.0, (double)maskReveals / numBoards,
+				maskSeconds > 0.0 ? scalarSeconds / maskSeconds : 0.0);
+		}
+	}
+
+
+	/** Computes exact probabilities of a position with one engine and returns the seconds taken, 0 if the engine failed. */
+	double TimeCompute(FMinesweeperProbabilityEngine& InEngine, const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const int32 InNumRepeats)
+	{
+		const double startTime = FPlatformTime::Seconds();
+		for (int32 repeat = 0; repeat < InNumRepeats; ++repeat)
+		{
+			if (!InEngine.Compute(InFrontier, InMineCount, 1).bSuccess) return 0.0;
+		}
+		return (FPlatformTime::Seconds() - startTime) / InNumRepeats;
+	}
+
+
+	void BenchmarkMaskEnumeration(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 300), 1);
+		const int32 numRepeats = FMath::Max(ParseIntArg(InArgs, 1, 5), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Mask enumeration benchmark: scalar and bit mask component enumeration where logic gets stuck on %d random boards per difficulty, %d repeats each."), numBoards, numRepeats);
+
+		const TArray<FPresetDifficulty> presets = {
+			{ TEXT("Expert"), UMinesweeperStatics::ExpertDifficulty() },
+			{ TEXT("Dense"), FMinesweeperDifficulty(30, 30, 225) },
+			{ TEXT("Large"), FMinesweeperDifficulty(100, 100, 2000) }
+		};
+
+		for (const FPresetDifficulty& preset : presets)
+		{
+			FMinesweeperBoard board;
+			FMinesweeperSolver solver;
+			FMinesweeperFrontier frontier;
+
+			// the cache would hide the enumeration after the first repeat
+			FMinesweeperProbabilityEngine scalarEngine;
+			scalarEngine.SetUseComponentCache(false);
+			FMinesweeperProbabilityEngine maskEngine;
+			maskEngine.SetUseComponentCache(false);
+			maskEngine.SetUseMaskEnumeration(true);
+
+			int32 numPositions = 0;
+			double scalarSeconds = 0.0;
+			double maskSeconds = 0.0;
+			float maxDifference = 0.0f;
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, board);
+				PlayUntilStuck(board, params.FirstClickIndex, solver, frontier);
+				if (frontier.NumOpenedCells() == board.Num() - board.MineCount) continue; // solved without guessing
+
+				const double scalarTime = TimeCompute(scalarEngine, frontier, board.MineCount, numRepeats);
+				const double maskTime = TimeCompute(maskEngine, frontier, board.MineCount, numRepeats);
+				if (scalarTime <= 0.0 || maskTime <= 0.0) continue;
+
+				++numPositions;
+				scalarSeconds += scalarTime;
+				maskSeconds += maskTime;
+				for (const int32 cellIndex : frontier.GetClosedCells().GetCells())
+				{
+					maxDifference = FMath::Max(maxDifference, FMath::Abs(scalarEngine.GetMineProbability(cellIndex) - maskEngine.GetMineProbability(cellIndex)));
+				}
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %4d mines: %5d positions, scalar %8.3f ms, masks %8.3f ms, %.2fx, max difference %g"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount, numPositions,
+				numPositions > 0 ? scalarSeconds / numPositions * 1000.0 : 0.0, numPositions > 0 ? maskSeconds / numPositions * 1000.0 : 0.0,
+				maskSeconds > 0.0 ? scalarSeconds / maskSeconds : 0.0, maxDifference);
+		}
+	}
+
+
+	/** Totals of boards worked through by SolveWithEnumeration(). */
+	struct FEnumerationTotals
+	{
+		int64 NumEnumerations = 0;
+		int64 NumReveals = 0;
+		int64 NumPatternLookups = 0;
+		int64 NumPatternHits = 0;
+		double Seconds = 0.0;
+	};
+
+	/**
+	 * Plays a board until every safe cell is open, the way a bot that never guesses blindly would. Whenever the solver is stuck, exact
+	 * probabilities are enumerated and a cell with no chance of a mine is opened. Only when there is none the next safe cell the solver
+	 * knows nothing about is opened for it.
+	 */
+	void SolveWithEnumeration(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex, FMinesweeperSolver& OutSolver, FMinesweeperFrontier& OutFrontier,
+		FMinesweeperProbabilityEngine& OutProbabilityEngine, FEnumerationTotals& OutTotals)
+	{
+		const double startTime = FPlatformTime::Seconds();
+
+		OutSolver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+		OutFrontier.Init(InBoard.Width, InBoard.Height);
+
+		const int32 safeCellCount = InBoard.Num() - InBoard.MineCount;
+		int32 nextRevealIndex = 0;
+		int32 cellIndex = InFirstClickIndex;
+
+		while (cellIndex != INDEX_NONE)
+		{
+			OutSolver.RevealCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			OutFrontier.OpenCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			OutSolver.Solve();
+
+			cellIndex = OutSolver.PopSafeCell();
+			if (cellIndex != INDEX_NONE || OutFrontier.NumOpenedCells() == safeCellCount) continue;
+
+			for (const int32 mineIndex : OutSolver.GetKnownMines())
+			{
+				OutFrontier.SetFlagged(mineIndex, true);
+			}
+
+			++OutTotals.NumEnumerations;
+			if (OutProbabilityEngine.Compute(OutFrontier, InBoard.MineCount, 1).bSuccess)
+			{
+				for (const int32 closedIndex : OutFrontier.GetClosedCells().GetCells())
+				{
+					if (OutProbabilityEngine.GetMineProbability(closedIndex) <= 0.0f)
+					{
+						cellIndex = closedIndex;
+						break;
+					}
+				}
+			}
+			if (cellIndex != INDEX_NONE) continue;
+
+			while (nextRevealIndex < InBoard.Num() && (InBoard.HasMine(nextRevealIndex) || OutSolver.GetCellState(nextRevealIndex) != FMinesweeperSolver::Unknown))
+			{
+				++nextRevealIndex;
+			}
+			if (nextRevealIndex < InBoard.Num())
+			{
+				cellIndex = nextRevealIndex;
+				++OutTotals.NumReveals;
+			}
+		}
+
+		OutTotals.NumPatternLookups += OutSolver.NumPatternLookups();
+		OutTotals.NumPatternHits += OutSolver.NumPatternHits();
+		OutTotals.Seconds += FPlatformTime::Seconds() - startTime;
+	}
+
+
+	/** Minesweeper.Benchmark.Patterns [NumBoards] */
+	void BenchmarkPatterns(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Pattern benchmark: %d random boards per difficulty solved with and without line patterns, enumerating exact probabilities when stuck."), numBoards);
+
+		for (const FPresetDifficulty& preset : GetPresetDifficulties())
+		{
+			const int32 firstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+
+			FMinesweeperBoard board;
+			FMinesweeperSolver solver;
+			FMinesweeperFrontier frontier;
+			FMinesweeperProbabilityEngine probabilityEngine;
+
+			FEnumerationTotals withoutPatterns;
+			FEnumerationTotals withPatterns;
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = firstClickIndex;
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, board);
+
+				solver.SetUsePatterns(false);
+				SolveWithEnumeration(board, firstClickIndex, solver, frontier, probabilityEngine, withoutPatterns);
+
+				solver.SetUsePatterns(true);
+				SolveWithEnumeration(board, firstClickIndex, solver, frontier, probabilityEngine, withPatterns);
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %.2f -> %.2f enumerations per board, %5.1f%% pattern hit rate, %10.0f -> %10.0f boards/s, %.2fx"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				(double)withoutPatterns.NumEnumerations / numBoards, (double)withPatterns.NumEnumerations / numBoards,
+				withPatterns.NumPatternLookups > 0 ? (double)withPatterns.NumPatternHits / withPatterns.NumPatternLookups * 100.0 : 0.0,
+				withoutPatterns.Seconds > 0.0 ? numBoards / withoutPatterns.Seconds : 0.0,
+				withPatterns.Seconds > 0.0 ? numBoards / withPatterns.Seconds : 0.0,
+				withPatterns.Seconds > 0.0 ? withoutPatterns.Seconds / withPatterns.Seconds : 0.0);
+		}
+	}
+
+
+	/** Minesweeper.Benchmark.Sweep [NumBoards] */
+	void BenchmarkSweep(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 100), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Sweep benchmark: trivial move sweeps of %d half played random boards per difficulty."), numBoards);
+
+		const TArray<FPresetDifficulty> presets = {
+			{ TEXT("Expert"), UMinesweeperStatics::ExpertDifficulty() },
+			{ TEXT("Max"), UMinesweeperStatics::MaxDifficulty() },
+			{ TEXT("Huge"), FMinesweeperDifficulty(1000, 1000, 160000) }
+		};
+
+		for (const FPresetDifficulty& preset : presets)
+		{
+			FMinesweeperBoard board;
+			FMinesweeperSweep sweep;
+			TArray<uint8> opened, numbers, flagged, sums;
+
+			int64 totalCells = 0;
+			int64 numSafeCells = 0;
+			int64 numMineCells = 0;
+			int64 numWrongCells = 0;
+			double sweepSeconds = 0.0;
+			double vectorSeconds = 0.0;
+			double scalarSeconds = 0.0;
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, board);
+
+				// a position as a player might leave it, with about 60% of the safe cells open and half of the mines flagged
+				opened.SetNumZeroed(board.Num());
+				numbers.SetNumZeroed(board.Num());
+				flagged.SetNumZeroed(board.Num());
+				sums.SetNumUninitialized(board.Num());
+				for (int32 cellIndex = 0; cellIndex < board.Num(); ++cellIndex)
+				{
+					const uint64 roll = MinesweeperRandom::CombineKey((uint64)boardIndex, (uint64)cellIndex) % 10;
+					if (board.HasMine(cellIndex))
+					{
+						flagged[cellIndex] = roll < 5 ? 1 : 0;
+					}
+					else if (roll < 6)
+					{
+						opened[cellIndex] = 1;
+						numbers[cellIndex] = (uint8)board.GetNeighborMineCount(cellIndex);
+					}
+				}
+
+				double startTime = FPlatformTime::Seconds();
+				sweep.Sweep(board.Width, board.Height, opened, numbers, flagged);
+				sweepSeconds += FPlatformTime::Seconds() - startTime;
+
+				startTime = FPlatformTime::Seconds();
+				FMinesweeperSweep::SumNeighbors(board.Mines.GetData(), board.Width, board.Height, sums.GetData());
+				vectorSeconds += FPlatformTime::Seconds() - startTime;
+
+				startTime = FPlatformTime::Seconds();
+				FMinesweeperSweep::SumNeighbors(board.Mines.GetData(), board.Width, board.Height, sums.GetData(), false);
+				scalarSeconds += FPlatformTime::Seconds() - startTime;
+
+				// the flags are all correct here, so every cell the sweep reports must match the board
+				for (const int32 cellIndex : sweep.GetSafeCells())
+				{
+					if (board.HasMine(cellIndex)) ++numWrongCells;
+				}
+				for (const int32 cellIndex : sweep.GetMineCells())
+				{
+					if (!board.HasMine(cellIndex)) ++numWrongCells;
+				}
+
+				totalCells += board.Num();
+				numSafeCells += sweep.GetSafeCells().Num();
+				numMineCells += sweep.GetMineCells().Num();
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %4dx%-4d %6d mines: sweep %8.1f Mcells/s, stencil %8.1f Mcells/s vector %8.1f Mcells/s scalar, %.1f safe and %.1f mine cells per board, %lld wrong"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				sweepSeconds > 0.0 ? totalCells / sweepSeconds / 1000000.0 : 0.0,
+				vectorSeconds > 0.0 ? totalCells / vectorSeconds / 1000000.0 : 0.0,
+				scalarSeconds > 0.0 ? totalCells / scalarSeconds / 1000000.0 : 0.0,
+				(double)numSafeCells / numBoards, (double)numMineCells / numBoards, numWrongCells);
+		}
+	}
+
+
+	/** Totals of the games played by one worker. */
+	struct FBotTotals
+	{
+		int32 NumGames = 0;
+		int32 NumWins = 0;
+		int64 NumMoves = 0;
+		int64 NumGuesses = 0;
+		double PlaySeconds = 0.0;
+
+		void Add(const FMinesweeperBotResult& InResult)
+		{
+			++NumGames;
+			if (InResult.bWon) ++NumWins;
+			NumMoves += InResult.NumMoves;
+			NumGuesses += InResult.NumGuesses;
+			PlaySeconds += InResult.Seconds;
+		}
+
+		void Add(const FBotTotals& InOther)
+		{
+			NumGames += InOther.NumGames;
+			NumWins += InOther.NumWins;
+			NumMoves += InOther.NumMoves;
+			NumGuesses += InOther.NumGuesses;
+			PlaySeconds += InOther.PlaySeconds;
+		}
+	};
+
+
+	/** Minesweeper.Benchmark.Bot [NumGames] [GameObject] [FirstClick] */
+	void BenchmarkBot(const TArray<FString>& InArgs)
+	{
+		const int32 numGames = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+		const bool bUseGameObject = ParseIntArg(InArgs, 1, 0) != 0;
+		const bool bUseFirstClickTable = ParseIntArg(InArgs, 2, 0) != 0;
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Bot benchmark: %d random games per difficulty %s, first click %s."), numGames,
+			bUseGameObject ? TEXT("through a game object on the game thread") : TEXT("on the board core across all workers"),
+			bUseFirstClickTable ? TEXT("from the first click table") : TEXT("in the center"));
+
+		for (const FPresetDifficulty& preset : GetPresetDifficulties())
+		{
+			const int32 firstClickIndex = bUseFirstClickTable ? FMinesweeperFirstClickTable::Get().Find(preset.Difficulty).CellIndex
+				: (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+			const double startTime = FPlatformTime::Seconds();
+
+			FBotTotals totals;
+			if (bUseGameObject)
+			{
+				// game objects can only be used on the game thread, so these games run one after another
+				UMinesweeperGame* game = NewObject<UMinesweeperGame>(GetTransientPackage());
+				game->SetGenerationMode(EMinesweeperGenerationMode::Random);
+
+				for (int32 gameIndex = 0; gameIndex < numGames; ++gameIndex)
+				{
+					game->SetGridRandomSeed(gameIndex);
+					game->SetupGame(preset.Difficulty);
+					totals.Add(FMinesweeperBot::PlayGame(game, firstClickIndex % preset.Difficulty.Width, firstClickIndex / preset.Difficulty.Width));
+				}
+			}
+			else
+			{
+				const int32 numWorkers = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+
+				TArray<FBotTotals> workerTotals;
+				workerTotals.SetNum(numWorkers);
+				std::atomic<int32> nextGame(0);
+
+				// boards are placed by the workers too, so games per second covers the whole core from mine placement to the last move
+				ParallelFor(numWorkers, [&](const int32 InWorkerIndex)
+					{
+						FMinesweeperBot bot;
+						FMinesweeperBoard board;
+						TArray<int32> candidates;
+
+						for (int32 gameIndex = nextGame.fetch_add(1); gameIndex < numGames; gameIndex = nextGame.fetch_add(1))
+						{
+							FMinesweeperGenerationParams params;
+							params.Difficulty = preset.Difficulty;
+							params.FirstClickIndex = firstClickIndex;
+							params.Seed = gameIndex;
+
+							FMinesweeperRandomStream randStream = FMinesweeperBoardGenerator::MakeAttemptStream(params, 0);
+							FMinesweeperBoardGenerator::PlaceMines(board, preset.Difficulty, firstClickIndex, false, randStream, candidates);
+							board.ComputeOpenings();
+
+							workerTotals[InWorkerIndex].Add(bot.Play(board, firstClickIndex));
+						}
+					});
+
+				for (const FBotTotals& worker : workerTotals)
+				{
+					totals.Add(worker);
+				}
+			}
+
+			const double totalSeconds = FPlatformTime::Seconds() - startTime;
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %5.1f%% won, %10.0f games/s, %8.2f us/move, %.1f moves and %.2f guesses per game"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				totals.NumGames > 0 ? (double)totals.NumWins / totals.NumGames * 100.0 : 0.0,
+				totalSeconds > 0.0 ? totals.NumGames / totalSeconds : 0.0,
+				totals.NumMoves > 0 ? totals.PlaySeconds / totals.NumMoves * 1000000.0 : 0.0,
+				totals.NumGames > 0 ? (double)totals.NumMoves / totals.NumGames : 0.0,
+				totals.NumGames > 0 ? (double)totals.NumGuesses / totals.NumGames : 0.0);
+		}
+	}
+
+	/** Minesweeper.Benchmark.Guess [NumGames] [Depth] [MaxNodes] */
+	void BenchmarkGuess(const TArray<FString>& InArgs)
+	{
+		const int32 numGames = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+
+		FMinesweeperGuessSettings guessSettings;
+		guessSettings.Depth = FMath::Max(ParseIntArg(InArgs, 1, guessSettings.Depth), 0);
+		guessSettings.MaxNodes = FMath::Max(ParseIntArg(InArgs, 2, 0), 0);
+
+		// a node budget alone makes runs on different machines and loads play the same moves
+		FString budgetText = FString::Printf(TEXT("%.0f ms"), guessSettings.BudgetSeconds * 1000.0);
+		if (guessSettings.MaxNodes > 0)
+		{
+			guessSettings.BudgetSeconds = MAX_dbl;
+			budgetText = FString::Printf(TEXT("%lld nodes per candidate"), guessSettings.MaxNodes);
+		}
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Guess benchmark: %d random games per difficulty, each played by the lowest mine probability and by a depth %d guess search within %s."),
+			numGames, guessSettings.Depth, *budgetText);
+
+		// max size boards are lost to their first guesses either way
+		TArray<FPresetDifficulty> presets = GetPresetDifficulties();
+		presets.SetNum(3);
+
+		for (const FPresetDifficulty& preset : presets)
+		{
+			const int32 firstClickIndex = (preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2);
+			const int32 numWorkers = FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+
+			// both bots play the same boards, so boards won by only one of them measure the difference without the luck of the draw
+			TArray<FBotTotals> lowestTotals, searchTotals;
+			TArray<int32> searchOnlyWins, lowestOnlyWins;
+			lowestTotals.SetNum(numWorkers);
+			searchTotals.SetNum(numWorkers);
+			searchOnlyWins.SetNumZeroed(numWorkers);
+			lowestOnlyWins.SetNumZeroed(numWorkers);
+			std::atomic<int32> nextGame(0);
+
+			ParallelFor(numWorkers, [&](const int32 InWorkerIndex)
+				{
+					FMinesweeperBot lowestBot, searchBot;
+					lowestBot.SetUseGuessSearch(false);
+					searchBot.SetGuessSettings(guessSettings);
+
+					FMinesweeperBoard board;
+					TArray<int32> candidates;
+
+					for (int32 gameIndex = nextGame.fetch_add(1); gameIndex < numGames; gameIndex = nextGame.fetch_add(1))
+					{
+						FMinesweeperGenerationParams params;
+						params.Difficulty = preset.Difficulty;
+						params.FirstClickIndex = firstClickIndex;
+						params.Seed = gameIndex;
+
+						FMinesweeperRandomStream randStream = FMinesweeperBoardGenerator::MakeAttemptStream(params, 0);
+						FMinesweeperBoardGenerator::PlaceMines(board, preset.Difficulty, firstClickIndex, false, randStream, candidates);
+						board.ComputeOpenings();
+
+						const FMinesweeperBotResult lowestResult = lowestBot.Play(board, firstClickIndex);
+						const FMinesweeperBotResult searchResult = searchBot.Play(board, firstClickIndex);
+						lowestTotals[InWorkerIndex].Add(lowestResult);
+						searchTotals[InWorkerIndex].Add(searchResult);
+						if (searchResult.bWon && !lowestResult.bWon) ++searchOnlyWins[InWorkerIndex];
+						if (lowestResult.bWon && !searchResult.bWon) ++lowestOnlyWins[InWorkerIndex];
+					}
+				});
+
+			FBotTotals lowest, search;
+			int32 numSearchOnlyWins = 0, numLowestOnlyWins = 0;
+			for (int32 workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+			{
+				lowest.Add(lowestTotals[workerIndex]);
+				search.Add(searchTotals[workerIndex]);
+				numSearchOnlyWins += searchOnlyWins[workerIndex];
+				numLowestOnlyWins += lowestOnlyWins[workerIndex];
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %5.1f%% won by lowest probability, %5.1f%% by search (%+.1f points, %d boards won only by search, %d only by lowest), %.2f ms per game searching"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				(double)lowest.NumWins / numGames * 100.0, (double)search.NumWins / numGames * 100.0,
+				(double)(search.NumWins - lowest.NumWins) / numGames * 100.0, numSearchOnlyWins, numLowestOnlyWins,
+				(search.PlaySeconds - lowest.PlaySeconds) / numGames * 1000.0);
+		}
+	}
+
+
+	/** Minesweeper.Benchmark.Rating [NumBoards] */
+	void BenchmarkRating(const TArray<FString>& InArgs)
+	{
+		const int32 numBoards = FMath::Max(ParseIntArg(InArgs, 0, 1000), 1);
+
+		UE_LOG(LogMinesweeperRuntime, Display, TEXT("Rating benchmark: solver effort of %d random boards per difficulty."), numBoards);
+
+		// max size boards need hundreds of guesses each and rate no differently from one another
+		TArray<FPresetDifficulty> presets = GetPresetDifficulties();
+		presets.SetNum(3);
+
+		for (const FPresetDifficulty& preset : presets)
+		{
+			TArray<FMinesweeperBoard> boards;
+			TArray<int32> firstClickIndices;
+			boards.SetNum(numBoards);
+			firstClickIndices.Init((preset.Difficulty.Width * (preset.Difficulty.Height / 2)) + (preset.Difficulty.Width / 2), numBoards);
+
+			for (int32 boardIndex = 0; boardIndex < numBoards; ++boardIndex)
+			{
+				FMinesweeperGenerationParams params;
+				params.Difficulty = preset.Difficulty;
+				params.FirstClickIndex = firstClickIndices[boardIndex];
+				params.Seed = boardIndex;
+
+				FMinesweeperBoardGenerator::Generate(params, boards[boardIndex]);
+			}
+
+			TArray<FMinesweeperBoardRating> ratings;
+			ratings.SetNum(numBoards);
+
+			double startTime = FPlatformTime::Seconds();
+			FMinesweeperBoardRater::RateBatch(boards, firstClickIndices, ratings, 1);
+			const double singleWorkerSeconds = FPlatformTime::Seconds() - startTime;
+
+			startTime = FPlatformTime::Seconds();
+			FMinesweeperBoardRater::RateBatch(boards, firstClickIndices, ratings);
+			const double allWorkersSeconds = FPlatformTime::Seconds() - startTime;
+
+			int64 totalGuesses = 0;
+			int32 numNoGuess = 0;
+			int32 maxComponentSize = 0;
+			int32 depthCounts[FMinesweeperBoardRating::EnumerationDepth + 1] = { };
+			for (const FMinesweeperBoardRating& rating : ratings)
+			{
+				totalGuesses += rating.Guesses;
+				if (rating.Guesses == 0) ++numNoGuess;
+				maxComponentSize = FMath::Max(maxComponentSize, rating.MaxComponentSize);
+				++depthCounts[FMath::Clamp(rating.DeductionDepth, 0, (int32)FMinesweeperBoardRating::EnumerationDepth)];
+			}
+
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("  %-12s %3dx%-3d %3d mines: %8.0f boards/s on 1 worker, %8.0f boards/s on all workers, mean guesses %.2f, %d without guessing, largest component %d, depth 1-5: %d %d %d %d %d"),
+				preset.Name, preset.Difficulty.Width, preset.Difficulty.Height, preset.Difficulty.MineCount,
+				singleWorkerSeconds > 0.0 ? numBoards / singleWorkerSeconds : 0.0,
+				allWorkersSeconds > 0.0 ? numBoards / allWorkersSeconds : 0.0,
+				(double)totalGuesses / numBoards, numNoGuess, maxComponentSize,
+				depthCounts[1], depthCounts[2], depthCounts[3], depthCounts[4], depthCounts[5]);
+		}
+	}
+}
+
+
+static FAutoConsoleCommand GMinesweeperBenchmarkGenerationCommand(
+	TEXT("Minesweeper.Benchmark.Generation"),
+	TEXT("Generates boards for Beginner through max size and logs attempts per second and p50/p99 latency. Usage: Minesweeper.Benchmark.Generation [NumBoards=100] [NoGuess=1]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkGeneration)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkMetricsCommand(
+	TEXT("Minesweeper.Benchmark.Metrics"),
+	TEXT("Computes 3BV and ZiNi for random boards of Beginner through max size and logs boards per second on one and all workers. Usage: Minesweeper.Benchmark.Metrics [NumBoards=10000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkMetrics)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkProbabilityCommand(
+	TEXT("Minesweeper.Benchmark.Probability"),
+	TEXT("Plays random boards of Beginner through max size by logic until stuck and logs the latency of exact mine probabilities. Usage: Minesweeper.Benchmark.Probability [NumBoards=1000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkProbability)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkSolverCommand(
+	TEXT("Minesweeper.Benchmark.Solver"),
+	TEXT("Works through random Expert, dense and large boards with the scalar and the bit mask solver and logs boards per second and reveals needed. Usage: Minesweeper.Benchmark.Solver [NumBoards=1000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkSolver)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkMaskEnumerationCommand(
+	TEXT("Minesweeper.Benchmark.MaskEnumeration"),
+	TEXT("Plays random Expert, dense and large boards by logic until stuck and logs exact probabilities enumerated by the scalar search and by bit masks, with their largest difference. Usage: Minesweeper.Benchmark.MaskEnumeration [NumBoards=300] [Repeats=5]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkMaskEnumeration)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkSweepCommand(
+	TEXT("Minesweeper.Benchmark.Sweep"),
+	TEXT("Sweeps half played random Expert, max size and 1000x1000 boards for trivial moves and logs cells per second of the sweep and its stencil. Usage: Minesweeper.Benchmark.Sweep [NumBoards=100]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkSweep)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkPatternsCommand(
+	TEXT("Minesweeper.Benchmark.Patterns"),
+	TEXT("Solves random boards of Beginner through max size with and without the line pattern table and logs enumerations avoided, pattern hit rate and speedup. Usage: Minesweeper.Benchmark.Patterns [NumBoards=1000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkPatterns)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkBotCommand(
+	TEXT("Minesweeper.Benchmark.Bot"),
+	TEXT("Plays random boards of Beginner through max size with the solver bot and logs win rate, games per second and time per move. Usage: Minesweeper.Benchmark.Bot [NumGames=1000] [GameObject=0] [FirstClick=0]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkBot)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkGuessCommand(
+	TEXT("Minesweeper.Benchmark.Guess"),
+	TEXT("Plays the same random Beginner, Intermediate and Expert boards guessing by lowest mine probability and by guess search and logs both win rates. Usage: Minesweeper.Benchmark.Guess [NumGames=1000] [Depth=0] [MaxNodes=0]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkGuess)
+);
+
+static FAutoConsoleCommand GMinesweeperBenchmarkRatingCommand(
+	TEXT("Minesweeper.Benchmark.Rating"),
+	TEXT("Rates random Beginner, Intermediate and Expert boards by solver effort and logs boards per second on one and all workers, guesses, component size and deduction depth. Usage: Minesweeper.Benchmark.Rating [NumBoards=1000]"),
+	FConsoleCommandWithArgsDelegate::CreateStatic(&MinesweeperBenchmarks::BenchmarkRating)
+);
+
+
+
+
+#undef LOCTEXT_NAMESPACE
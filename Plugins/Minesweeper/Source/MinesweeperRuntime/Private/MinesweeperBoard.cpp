@@ -0,0 +1,292 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoard.h"
+#include "MinesweeperSweep.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperBoardPrivate
+{
+	/** Union-find root lookup with path halving. */
+	FORCEINLINE int32 FindRoot(TArray<int32>& InOutParents, int32 InCellIndex)
+	{
+		while (InOutParents[InCellIndex] != InCellIndex)
+		{
+			InOutParents[InCellIndex] = InOutParents[InOutParents[InCellIndex]];
+			InCellIndex = InOutParents[InCellIndex];
+		}
+		return InCellIndex;
+	}
+
+	/** Joins two sets. The lower index becomes the root so every root is the first cell of its set in raster order. */
+	FORCEINLINE void Union(TArray<int32>& InOutParents, const int32 InCellA, const int32 InCellB)
+	{
+		const int32 rootA = FindRoot(InOutParents, InCellA);
+		const int32 rootB = FindRoot(InOutParents, InCellB);
+		if (rootA < rootB)
+		{
+			InOutParents[rootB] = rootA;
+		}
+		else if (rootB < rootA)
+		{
+			InOutParents[rootA] = rootB;
+		}
+	}
+}
+
+
+
+
+void FMinesweeperBoard::Init(const FMinesweeperDifficulty& InDifficulty)
+{
+	Width = FMath::Max(InDifficulty.Width, 0);
+	Height = FMath::Max(InDifficulty.Height, 0);
+	MineCount = 0;
+
+	Mines.SetNumZeroed(Num());
+	NeighborMineCounts.SetNumZeroed(Num());
+
+	ClearOpenings();
+}
+
+void FMinesweeperBoard::ClearMines()
+{
+	MineCount = 0;
+
+	FMemory::Memzero(Mines.GetData(), Mines.Num());
+	FMemory::Memzero(NeighborMineCounts.GetData(), NeighborMineCounts.Num());
+
+	ClearOpenings();
+}
+
+
+void FMinesweeperBoard::ComputeNeighborMineCounts()
+{
+	NeighborMineCounts.SetNumUninitialized(Num());
+	FMinesweeperSweep::SumNeighbors(Mines.GetData(), Width, Height, NeighborMineCounts.GetData());
+}
+
+
+bool FMinesweeperBoard::ComputeOpenings()
+{
+	using namespace MinesweeperBoardPrivate;
+
+	ClearOpenings();
+
+	const int32 totalCellCount = Num();
+	if (totalCellCount == 0) return true;
+
+	// union pass: zero cells are 8-connected, so each one joins the zero cells to its left and in the row above, which were already visited
+	TArray<int32> parents;
+	parents.SetNumUninitialized(totalCellCount);
+
+	for (int32 y = 0; y < Height; ++y)
+	{
+		for (int32 x = 0; x < Width; ++x)
+		{
+			const int32 cellIndex = (Width * y) + x;
+			parents[cellIndex] = cellIndex;
+
+			if (!IsZeroCell(cellIndex)) continue;
+
+			if (x > 0 && IsZeroCell(cellIndex - 1))
+			{
+				Union(parents, cellIndex, cellIndex - 1);
+			}
+
+			if (y > 0)
+			{
+				for (int32 aboveX = FMath::Max(x - 1, 0); aboveX <= FMath::Min(x + 1, Width - 1); ++aboveX)
+				{
+					const int32 aboveIndex = (Width * (y - 1)) + aboveX;
+					if (IsZeroCell(aboveIndex))
+					{
+						Union(parents, cellIndex, aboveIndex);
+					}
+				}
+			}
+		}
+	}
+
+	// label pass: roots come first in raster order, so each root takes the next id before any cell of its set looks it up
+	OpeningIds.SetNumZeroed(totalCellCount);
+
+	int32 numOpenings = 0;
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (!IsZeroCell(cellIndex)) continue;
+
+		const int32 rootIndex = FindRoot(parents, cellIndex);
+		if (rootIndex == cellIndex)
+		{
+			if (numOpenings == MAX_uint16)
+			{
+				ClearOpenings();
+				return false;
+			}
+			OpeningIds[cellIndex] = (uint16)++numOpenings;
+		}
+		else
+		{
+			OpeningIds[cellIndex] = OpeningIds[rootIndex];
+		}
+	}
+
+	// a numbered cell touches at most 4 separate openings, since zero cells next to each other around it are connected
+	auto gatherBorderedOpenings = [this](const int32 InCellIndex, uint16 OutOpeningIds[8]) -> int32
+	{
+		int32 numBordered = 0;
+		ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+			{
+				const uint16 openingId = IsZeroCell(InNeighborIndex) ? OpeningIds[InNeighborIndex] : 0;
+				if (openingId == 0) return;
+
+				for (int32 i = 0; i < numBordered; ++i)
+				{
+					if (OutOpeningIds[i] == openingId) return;
+				}
+				OutOpeningIds[numBordered++] = openingId;
+			});
+		return numBordered;
+	};
+
+	// count pass: size of each opening including its border
+	OpeningCellOffsets.SetNumZeroed(numOpenings + 1);
+
+	uint16 borderedIds[8];
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (Mines[cellIndex] != 0) continue;
+
+		if (NeighborMineCounts[cellIndex] == 0)
+		{
+			++OpeningCellOffsets[OpeningIds[cellIndex]];
+			continue;
+		}
+
+		const int32 numBordered = gatherBorderedOpenings(cellIndex, borderedIds);
+		for (int32 i = 0; i < numBordered; ++i)
+		{
+			++OpeningCellOffsets[borderedIds[i]];
+		}
+		if (numBordered > 0)
+		{
+			OpeningIds[cellIndex] = borderedIds[0];
+		}
+	}
+
+	// prefix sum turns the counts into end offsets, which are also the start offsets of the following opening
+	for (int32 openingId = 1; openingId <= numOpenings; ++openingId)
+	{
+		OpeningCellOffsets[openingId] += OpeningCellOffsets[openingId - 1];
+	}
+
+	// fill pass: same walk as the count pass, writing each cell at its opening's cursor
+	OpeningCells.SetNumUninitialized(OpeningCellOffsets[numOpenings]);
+	TArray<int32> fillCursors(OpeningCellOffsets);
+
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (Mines[cellIndex] != 0) continue;
+
+		if (NeighborMineCounts[cellIndex] == 0)
+		{
+			OpeningCells[fillCursors[OpeningIds[cellIndex] - 1]++] = cellIndex;
+			continue;
+		}
+
+		const int32 numBordered = gatherBorderedOpenings(cellIndex, borderedIds);
+		for (int32 i = 0; i < numBordered; ++i)
+		{
+			OpeningCells[fillCursors[borderedIds[i] - 1]++] = cellIndex;
+		}
+	}
+
+	return true;
+}
+
+void FMinesweeperBoard::ClearOpenings()
+{
+	OpeningIds.Reset();
+	OpeningCellOffsets.Reset();
+	OpeningCells.Reset();
+}
+
+
+int32 FMinesweeperBoard::TransformIndex(const EMinesweeperBoardSymmetry InSymmetry, const int32 InCellIndex) const
+{
+	const int32 x = InCellIndex % Width;
+	const int32 y = InCellIndex / Width;
+
+	// transformed coord and width of the transformed board, rotating by 90 degrees swaps the dimensions
+	switch (InSymmetry)
+	{
+	case EMinesweeperBoardSymmetry::Identity:		return (Width * y) + x;
+	case EMinesweeperBoardSymmetry::FlipX:			return (Width * y) + (Width - 1 - x);
+	case EMinesweeperBoardSymmetry::FlipY:			return (Width * (Height - 1 - y)) + x;
+	case EMinesweeperBoardSymmetry::Rotate180:		return (Width * (Height - 1 - y)) + (Width - 1 - x);
+	case EMinesweeperBoardSymmetry::Rotate90:		return (Height * x) + (Height - 1 - y);
+	case EMinesweeperBoardSymmetry::Rotate270:		return (Height * (Width - 1 - x)) + y;
+	case EMinesweeperBoardSymmetry::Transpose:		return (Height * x) + y;
+	case EMinesweeperBoardSymmetry::AntiTranspose:	return (Height * (Width - 1 - x)) + (Height - 1 - y);
+	}
+	return InCellIndex;
+}
+
+void FMinesweeperBoard::Transform(const EMinesweeperBoardSymmetry InSymmetry, FMinesweeperBoard& OutBoard) const
+{
+	check(&OutBoard != this);
+
+	const bool bSwapsDimensions = InSymmetry >= EMinesweeperBoardSymmetry::Rotate90;
+
+	OutBoard.Width = bSwapsDimensions ? Height : Width;
+	OutBoard.Height = bSwapsDimensions ? Width : Height;
+	OutBoard.MineCount = MineCount;
+	OutBoard.Mines.SetNumUninitialized(Num());
+	OutBoard.NeighborMineCounts.SetNumUninitialized(Num());
+
+	// neighbor counts are invariant under symmetries, so both planes are permuted instead of recomputed
+	for (int32 cellIndex = 0; cellIndex < Num(); ++cellIndex)
+	{
+		const int32 transformedIndex = TransformIndex(InSymmetry, cellIndex);
+		OutBoard.Mines[transformedIndex] = Mines[cellIndex];
+		OutBoard.NeighborMineCounts[transformedIndex] = NeighborMineCounts[cellIndex];
+	}
+
+	// opening labels are invariant too, only the cell indices move
+	OutBoard.ClearOpenings();
+	if (HasOpeningLabels())
+	{
+		OutBoard.OpeningIds.SetNumUninitialized(Num());
+		for (int32 cellIndex = 0; cellIndex < Num(); ++cellIndex)
+		{
+			OutBoard.OpeningIds[TransformIndex(InSymmetry, cellIndex)] = OpeningIds[cellIndex];
+		}
+
+		OutBoard.OpeningCellOffsets = OpeningCellOffsets;
+		OutBoard.OpeningCells.SetNumUninitialized(OpeningCells.Num());
+		for (int32 i = 0; i < OpeningCells.Num(); ++i)
+		{
+			OutBoard.OpeningCells[i] = TransformIndex(InSymmetry, OpeningCells[i]);
+		}
+	}
+}
+
+int32 FMinesweeperBoard::GetCanonicalCellIndex(const int32 InCellIndex) const
+{
+	int32 canonicalIndex = InCellIndex;
+	for (int32 symmetry = 1; symmetry < NumSymmetries(); ++symmetry)
+	{
+		canonicalIndex = FMath::Min(canonicalIndex, TransformIndex((EMinesweeperBoardSymmetry)symmetry, InCellIndex));
+	}
+	return canonicalIndex;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,212 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoardGenerator.h"
+#include "MinesweeperStats.h"
+#include "MinesweeperSolver.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include <atomic>
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Generation Attempts"), STAT_MinesweeperGenerationAttempts, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Generation Attempts Per Second"), STAT_MinesweeperGenerationAttemptsPerSecond, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Generation Latency P99 (ms)"), STAT_MinesweeperGenerationLatencyP99, STATGROUP_Minesweeper);
+
+
+
+
+namespace MinesweeperGeneratorPrivate
+{
+	/** Per worker storage reused between attempts. */
+	struct FWorkerScratch
+	{
+		FMinesweeperBoard Board;
+		TArray<int32> Candidates;
+		FMinesweeperSolver Solver;
+	};
+
+	/** Plays the board from the first click, opening every cell the solver proves safe. Never guesses. */
+	bool SolveByLogic(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex, FMinesweeperSolver& InOutSolver)
+	{
+		if (InBoard.HasMine(InFirstClickIndex)) return false;
+
+		InOutSolver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+
+		// each open only wakes the numbers around it, zero cells resolve their neighbors as safe so openings flood through the solver
+		int32 safeCellsRemaining = InBoard.Num() - InBoard.MineCount;
+		for (int32 cellIndex = InFirstClickIndex; cellIndex != INDEX_NONE; cellIndex = InOutSolver.PopSafeCell())
+		{
+			check(!InBoard.HasMine(cellIndex));
+			InOutSolver.RevealCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+			InOutSolver.Solve();
+			--safeCellsRemaining;
+		}
+
+		return safeCellsRemaining == 0;
+	}
+}
+
+
+
+
+void FMinesweeperBoardGenerator::PlaceMines(FMinesweeperBoard& OutBoard, const FMinesweeperDifficulty& InDifficulty, const int32 InFirstClickIndex, const bool bInClearNeighbors, FMinesweeperRandomStream& InRandStream, TArray<int32>& InOutScratch)
+{
+	if (OutBoard.Width != InDifficulty.Width || OutBoard.Height != InDifficulty.Height)
+	{
+		OutBoard.Init(InDifficulty);
+	}
+	else
+	{
+		OutBoard.ClearMines();
+	}
+
+	const int32 totalCellCount = OutBoard.Num();
+	if (totalCellCount == 0) return;
+
+	// the first click cell is always excluded, its neighbors only if every mine still fits
+	const bool bClearNeighbors = bInClearNeighbors && OutBoard.IsValidIndex(InFirstClickIndex) && (totalCellCount - 9) >= InDifficulty.MineCount;
+
+	InOutScratch.Reset(totalCellCount);
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (cellIndex == InFirstClickIndex) continue;
+		if (bClearNeighbors)
+		{
+			const FIntVector2 cellCoord = OutBoard.IndexToCoord(cellIndex);
+			const FIntVector2 clickCoord = OutBoard.IndexToCoord(InFirstClickIndex);
+			if (FMath::Abs(cellCoord.X - clickCoord.X) <= 1 && FMath::Abs(cellCoord.Y - clickCoord.Y) <= 1) continue;
+		}
+		InOutScratch.Add(cellIndex);
+	}
+
+	// partial Fisher-Yates shuffle, every candidate cell has the same chance of holding a mine
+	const int32 minesToPlace = FMath::Min(InDifficulty.MineCount, InOutScratch.Num());
+	for (int32 i = 0; i < minesToPlace; ++i)
+	{
+		const int32 swapIndex = InRandStream.RandRange(i, InOutScratch.Num() - 1);
+		InOutScratch.Swap(i, swapIndex);
+		OutBoard.Mines[InOutScratch[i]] = 1;
+	}
+	OutBoard.MineCount = minesToPlace;
+
+	OutBoard.ComputeNeighborMineCounts();
+}
+
+
+FMinesweeperRandomStream FMinesweeperBoardGenerator::MakeAttemptStream(const FMinesweeperGenerationParams& InParams, const int32 InAttemptIndex)
+{
+	uint64 boardKey = MinesweeperRandom::CombineKey((uint64)(uint32)InParams.Seed, ((uint64)(uint32)InParams.Difficulty.Width << 32) | (uint32)InParams.Difficulty.Height);
+	boardKey = MinesweeperRandom::CombineKey(boardKey, ((uint64)(uint32)InParams.Difficulty.MineCount << 32) | (uint32)InParams.FirstClickIndex);
+
+	return FMinesweeperRandomStream(boardKey, (uint64)InAttemptIndex);
+}
+
+
+bool FMinesweeperBoardGenerator::IsSolvableWithoutGuessing(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex)
+{
+	if (!InBoard.IsValidIndex(InFirstClickIndex)) return false;
+
+	FMinesweeperSolver solver;
+	return MinesweeperGeneratorPrivate::SolveByLogic(InBoard, InFirstClickIndex, solver);
+}
+
+
+FMinesweeperGenerationResult FMinesweeperBoardGenerator::Generate(const FMinesweeperGenerationParams& InParams, FMinesweeperBoard& OutBoard)
+{
+	using namespace MinesweeperGeneratorPrivate;
+
+	const double startTime = FPlatformTime::Seconds();
+
+	FMinesweeperGenerationResult result;
+
+	if (InParams.Mode == EMinesweeperGenerationMode::NoGuess)
+	{
+		const int32 numWorkers = InParams.NumWorkers > 0 ? InParams.NumWorkers : FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+		const int32 maxAttempts = FMath::Max(InParams.MaxAttempts, 1);
+
+		TArray<FWorkerScratch> workerScratch;
+		workerScratch.SetNum(numWorkers);
+
+		// attempts are claimed in order and each attempt has its own stream, taking the lowest successful attempt keeps the result deterministic
+		std::atomic<int32> nextAttempt(0);
+		std::atomic<int32> bestAttempt(MAX_int32);
+		TArray<int32> workerBestAttempt;
+		workerBestAttempt.Init(MAX_int32, numWorkers);
+
+		ParallelFor(numWorkers, [&](const int32 InWorkerIndex)
+			{
+				FWorkerScratch& scratch = workerScratch[InWorkerIndex];
+
+				while (true)
+				{
+					const int32 attemptIndex = nextAttempt.fetch_add(1);
+					if (attemptIndex >= maxAttempts || attemptIndex > bestAttempt.load()) break; // first success cancels the remaining attempts
+
+					FMinesweeperRandomStream randStream = MakeAttemptStream(InParams, attemptIndex);
+					PlaceMines(scratch.Board, InParams.Difficulty, InParams.FirstClickIndex, true, randStream, scratch.Candidates);
+
+					if (SolveByLogic(scratch.Board, InParams.FirstClickIndex, scratch.Solver))
+					{
+						workerBestAttempt[InWorkerIndex] = attemptIndex;
+
+						int32 currentBest = bestAttempt.load();
+						while (attemptIndex < currentBest && !bestAttempt.compare_exchange_weak(currentBest, attemptIndex)) { }
+						break;
+					}
+				}
+			});
+
+		result.Attempts = FMath::Min(nextAttempt.load(), maxAttempts);
+
+		const int32 winningAttempt = bestAttempt.load();
+		for (int32 workerIndex = 0; workerIndex < numWorkers; ++workerIndex)
+		{
+			if (workerBestAttempt[workerIndex] == winningAttempt)
+			{
+				OutBoard = MoveTemp(workerScratch[workerIndex].Board);
+				result.bSuccess = true;
+				break;
+			}
+		}
+	}
+
+	if (!result.bSuccess)
+	{
+		// random mode, or no-guess mode ran out of attempts
+		TArray<int32> candidates;
+		FMinesweeperRandomStream randStream = MakeAttemptStream(InParams, 0);
+		PlaceMines(OutBoard, InParams.Difficulty, InParams.FirstClickIndex, false, randStream, candidates);
+
+		result.bSuccess = InParams.Mode != EMinesweeperGenerationMode::NoGuess;
+		result.Attempts = FMath::Max(result.Attempts, 1);
+	}
+
+	// labels are only needed for the accepted board, not for every candidate
+	OutBoard.ComputeOpenings();
+
+	result.Seconds = FPlatformTime::Seconds() - startTime;
+
+	FMinesweeperLatencyTracker& latencyTracker = GetLatencyTracker();
+	latencyTracker.AddSample(result.Seconds);
+
+	INC_DWORD_STAT_BY(STAT_MinesweeperGenerationAttempts, result.Attempts);
+	SET_FLOAT_STAT(STAT_MinesweeperGenerationAttemptsPerSecond, result.Seconds > 0.0 ? result.Attempts / result.Seconds : 0.0);
+	SET_FLOAT_STAT(STAT_MinesweeperGenerationLatencyP99, latencyTracker.GetPercentile(99.0f) * 1000.0);
+
+	return result;
+}
+
+
+FMinesweeperLatencyTracker& FMinesweeperBoardGenerator::GetLatencyTracker()
+{
+	static FMinesweeperLatencyTracker latencyTracker;
+	return latencyTracker;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
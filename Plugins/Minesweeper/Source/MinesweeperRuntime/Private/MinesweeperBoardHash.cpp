@@ -0,0 +1,195 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoardHash.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperBoardHashPrivate
+{
+	static const TCHAR* CrockfordAlphabet = TEXT("0123456789ABCDEFGHJKMNPQRSTVWXYZ");
+
+	FORCEINLINE uint64 RotateLeft(const uint64 InValue, const int32 InShift)
+	{
+		return (InValue << InShift) | (InValue >> (64 - InShift));
+	}
+
+	FORCEINLINE uint64 FinalMix(uint64 InValue)
+	{
+		InValue ^= InValue >> 33;
+		InValue *= 0xFF51AFD7ED558CCDull;
+		InValue ^= InValue >> 33;
+		InValue *= 0xC4CEB9FE1A85EC53ull;
+		return InValue ^ (InValue >> 33);
+	}
+
+	/** Packs the board's mines as they land after a symmetry, one bit per cell. */
+	void PackTransformedMines(const FMinesweeperBoard& InBoard, const EMinesweeperBoardSymmetry InSymmetry, TArray<uint8, TInlineAllocator<128>>& OutBits)
+	{
+		OutBits.SetNumZeroed(8 + ((InBoard.Num() + 7) / 8));
+
+		// dimensions of the transformed board lead the key so boards of different shapes never compare equal
+		const bool bSwapsDimensions = InSymmetry >= EMinesweeperBoardSymmetry::Rotate90;
+		const int32 width = bSwapsDimensions ? InBoard.Height : InBoard.Width;
+		const int32 height = bSwapsDimensions ? InBoard.Width : InBoard.Height;
+		FMemory::Memcpy(OutBits.GetData(), &width, 4);
+		FMemory::Memcpy(OutBits.GetData() + 4, &height, 4);
+
+		uint8* mineBits = OutBits.GetData() + 8;
+		for (int32 cellIndex = 0; cellIndex < InBoard.Num(); ++cellIndex)
+		{
+			if (InBoard.Mines[cellIndex] == 0) continue;
+
+			const int32 transformedIndex = InSymmetry == EMinesweeperBoardSymmetry::Identity ? cellIndex : InBoard.TransformIndex(InSymmetry, cellIndex);
+			mineBits[transformedIndex >> 3] |= 1 << (transformedIndex & 7);
+		}
+	}
+}
+
+
+
+
+FMinesweeperBoardHash FMinesweeperBoardHash::HashBytes(const uint8* InData, const int32 InNumBytes, const uint64 InSeed)
+{
+	using namespace MinesweeperBoardHashPrivate;
+
+	static const uint64 c1 = 0x87C37B91114253D5ull;
+	static const uint64 c2 = 0x4CF5AD432745937Full;
+
+	uint64 h1 = InSeed;
+	uint64 h2 = InSeed;
+
+	const int32 numBlocks = InNumBytes / 16;
+	for (int32 blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+	{
+		uint64 k1, k2;
+		FMemory::Memcpy(&k1, InData + (blockIndex * 16), 8);
+		FMemory::Memcpy(&k2, InData + (blockIndex * 16) + 8, 8);
+
+		k1 *= c1; k1 = RotateLeft(k1, 31); k1 *= c2; h1 ^= k1;
+		h1 = RotateLeft(h1, 27); h1 += h2; h1 = (h1 * 5) + 0x52DCE729;
+
+		k2 *= c2; k2 = RotateLeft(k2, 33); k2 *= c1; h2 ^= k2;
+		h2 = RotateLeft(h2, 31); h2 += h1; h2 = (h2 * 5) + 0x38495AB5;
+	}
+
+	// tail bytes
+	const uint8* tail = InData + (numBlocks * 16);
+	const int32 tailSize = InNumBytes & 15;
+
+	uint64 k1 = 0;
+	uint64 k2 = 0;
+	for (int32 i = tailSize - 1; i >= 8; --i)
+	{
+		k2 = (k2 << 8) | tail[i];
+	}
+	for (int32 i = FMath::Min(tailSize, 8) - 1; i >= 0; --i)
+	{
+		k1 = (k1 << 8) | tail[i];
+	}
+
+	if (tailSize > 8)
+	{
+		k2 *= c2; k2 = RotateLeft(k2, 33); k2 *= c1; h2 ^= k2;
+	}
+	if (tailSize > 0)
+	{
+		k1 *= c1; k1 = RotateLeft(k1, 31); k1 *= c2; h1 ^= k1;
+	}
+
+	h1 ^= (uint64)InNumBytes;
+	h2 ^= (uint64)InNumBytes;
+
+	h1 += h2;
+	h2 += h1;
+
+	h1 = FinalMix(h1);
+	h2 = FinalMix(h2);
+
+	h1 += h2;
+	h2 += h1;
+
+	FMinesweeperBoardHash hash;
+	hash.Low = h1;
+	hash.High = h2;
+	return hash;
+}
+
+
+FMinesweeperBoardHash FMinesweeperBoardHash::Compute(const FMinesweeperBoard& InBoard)
+{
+	TArray<uint8, TInlineAllocator<128>> packedBits;
+	MinesweeperBoardHashPrivate::PackTransformedMines(InBoard, EMinesweeperBoardSymmetry::Identity, packedBits);
+
+	return HashBytes(packedBits.GetData(), packedBits.Num());
+}
+
+FMinesweeperBoardHash FMinesweeperBoardHash::ComputeCanonical(const FMinesweeperBoard& InBoard, EMinesweeperBoardSymmetry* OutSymmetry)
+{
+	using namespace MinesweeperBoardHashPrivate;
+
+	TArray<uint8, TInlineAllocator<128>> canonicalBits;
+	TArray<uint8, TInlineAllocator<128>> candidateBits;
+
+	PackTransformedMines(InBoard, EMinesweeperBoardSymmetry::Identity, canonicalBits);
+	EMinesweeperBoardSymmetry canonicalSymmetry = EMinesweeperBoardSymmetry::Identity;
+
+	// the canonical form is the byte-wise smallest packed layout, the same for every board in the orbit
+	for (int32 symmetry = 1; symmetry < InBoard.NumSymmetries(); ++symmetry)
+	{
+		PackTransformedMines(InBoard, (EMinesweeperBoardSymmetry)symmetry, candidateBits);
+		if (FMemory::Memcmp(candidateBits.GetData(), canonicalBits.GetData(), canonicalBits.Num()) < 0)
+		{
+			Swap(canonicalBits, candidateBits);
+			canonicalSymmetry = (EMinesweeperBoardSymmetry)symmetry;
+		}
+	}
+
+	if (OutSymmetry)
+	{
+		*OutSymmetry = canonicalSymmetry;
+	}
+
+	return HashBytes(canonicalBits.GetData(), canonicalBits.Num());
+}
+
+
+FString FMinesweeperBoardHash::ToShortCode() const
+{
+	const uint64 shortKey = GetShortKey();
+
+	FString code;
+	code.Reserve(ShortCodeLength);
+	for (int32 charIndex = ShortCodeLength - 1; charIndex >= 0; --charIndex)
+	{
+		code.AppendChar(MinesweeperBoardHashPrivate::CrockfordAlphabet[(shortKey >> (5 * charIndex)) & 31]);
+	}
+	return code;
+}
+
+bool FMinesweeperBoardHash::ParseShortCode(const FString& InCode, uint64& OutShortKey)
+{
+	if (InCode.Len() != ShortCodeLength) return false;
+
+	OutShortKey = 0;
+	for (TCHAR codeChar : InCode)
+	{
+		codeChar = FChar::ToUpper(codeChar);
+		if (codeChar == TEXT('O')) codeChar = TEXT('0');
+		if (codeChar == TEXT('I') || codeChar == TEXT('L')) codeChar = TEXT('1');
+
+		const TCHAR* found = FCString::Strchr(MinesweeperBoardHashPrivate::CrockfordAlphabet, codeChar);
+		if (!found || codeChar == 0) return false;
+
+		OutShortKey = (OutShortKey << 5) | (uint64)(found - MinesweeperBoardHashPrivate::CrockfordAlphabet);
+	}
+	return true;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
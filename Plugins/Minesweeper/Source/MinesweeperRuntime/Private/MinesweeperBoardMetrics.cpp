@@ -0,0 +1,269 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoardMetrics.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperMetricsPrivate
+{
+	/** Cells that cannot be chorded, or whose chord reveals nothing. */
+	static const int32 NoPremium = MIN_int32;
+
+	/** Click state of one greedy ZiNi run. Inline storage keeps standard boards off the heap. */
+	struct FZiNiState
+	{
+		const FMinesweeperBoard& Board;
+
+		TArray<uint8, TInlineAllocator<1024>> Opened;
+		TArray<uint8, TInlineAllocator<1024>> Flagged;
+		TArray<int32, TInlineAllocator<1024>> Premiums;
+
+		/** Cells opened or flagged by the last action, whose neighbors need new premiums. */
+		TArray<int32, TInlineAllocator<256>> ChangedCells;
+
+		int32 NumClosedSafeCells = 0;
+		int32 Clicks = 0;
+
+		explicit FZiNiState(const FMinesweeperBoard& InBoard)
+			: Board(InBoard)
+		{
+			Opened.SetNumZeroed(InBoard.Num());
+			Flagged.SetNumZeroed(InBoard.Num());
+			Premiums.Init(NoPremium, InBoard.Num());
+		}
+
+		void Open(const int32 InCellIndex)
+		{
+			if (Opened[InCellIndex]) return;
+
+			Opened[InCellIndex] = 1;
+			--NumClosedSafeCells;
+			ChangedCells.Add(InCellIndex);
+		}
+
+		/** Chord premium of a numbered cell. Openings are all open by the time premiums are used, so every closed safe neighbor is one click saved. */
+		int32 ComputePremium(const int32 InCellIndex) const
+		{
+			if (Board.HasMine(InCellIndex) || Board.GetNeighborMineCount(InCellIndex) == 0) return NoPremium;
+
+			int32 numRevealed = 0;
+			int32 numFlagsNeeded = 0;
+			Board.ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+				{
+					if (Board.HasMine(InNeighborIndex))
+					{
+						numFlagsNeeded += Flagged[InNeighborIndex] ? 0 : 1;
+					}
+					else if (!Opened[InNeighborIndex])
+					{
+						++numRevealed;
+					}
+				});
+
+			return numRevealed > 0 ? numRevealed - numFlagsNeeded - 1 : NoPremium;
+		}
+
+		void Chord(const int32 InCellIndex)
+		{
+			if (!Opened[InCellIndex])
+			{
+				++Clicks;
+				Open(InCellIndex);
+			}
+
+			Board.ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+				{
+					if (!Board.HasMine(InNeighborIndex))
+					{
+						Open(InNeighborIndex);
+					}
+					else if (!Flagged[InNeighborIndex])
+					{
+						++Clicks;
+						Flagged[InNeighborIndex] = 1;
+						ChangedCells.Add(InNeighborIndex);
+					}
+				});
+
+			++Clicks;
+		}
+
+		void UpdateChangedPremiums()
+		{
+			for (const int32 changedIndex : ChangedCells)
+			{
+				Premiums[changedIndex] = ComputePremium(changedIndex);
+				Board.ForEachNeighbor(changedIndex, [&](const int32 InNeighborIndex)
+					{
+						Premiums[InNeighborIndex] = ComputePremium(InNeighborIndex);
+					});
+			}
+			ChangedCells.Reset();
+		}
+	};
+}
+
+
+
+
+FMinesweeperBoardMetrics FMinesweeperBoardMetrics::Compute(const FMinesweeperBoard& InBoard)
+{
+	FMinesweeperBoardMetrics metrics;
+
+	if (!InBoard.HasOpeningLabels())
+	{
+		FMinesweeperBoard labeledBoard = InBoard;
+		if (!labeledBoard.ComputeOpenings()) return metrics;
+		return Compute(labeledBoard);
+	}
+
+	const int32 totalCellCount = InBoard.Num();
+
+	metrics.Openings = InBoard.GetNumOpenings();
+
+	// every opening costs one click, every numbered cell outside all openings costs one click of its own
+	TArray<uint8, TInlineAllocator<1024>> visited;
+	visited.SetNumZeroed(totalCellCount);
+
+	TArray<int32, TInlineAllocator<256>> islandStack;
+
+	int32 isolatedCellCount = 0;
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (InBoard.HasMine(cellIndex)) continue;
+
+		++metrics.SafeCells;
+
+		if (InBoard.GetOpeningId(cellIndex) != 0 || visited[cellIndex]) continue;
+
+		// new island, mark all isolated numbered cells connected to it
+		++metrics.Islands;
+
+		visited[cellIndex] = 1;
+		islandStack.Add(cellIndex);
+
+		while (islandStack.Num() > 0)
+		{
+			const int32 islandCellIndex = islandStack.Pop(false);
+			++isolatedCellCount;
+
+			InBoard.ForEachNeighbor(islandCellIndex, [&](const int32 InNeighborIndex)
+				{
+					if (visited[InNeighborIndex] || InBoard.HasMine(InNeighborIndex) || InBoard.GetOpeningId(InNeighborIndex) != 0) return;
+
+					visited[InNeighborIndex] = 1;
+					islandStack.Add(InNeighborIndex);
+				});
+		}
+	}
+
+	metrics.ThreeBV = metrics.Openings + isolatedCellCount;
+
+	return metrics;
+}
+
+
+int32 FMinesweeperBoardMetrics::EstimateZiNi(const FMinesweeperBoard& InBoard)
+{
+	using namespace MinesweeperMetricsPrivate;
+
+	if (!InBoard.HasOpeningLabels())
+	{
+		FMinesweeperBoard labeledBoard = InBoard;
+		if (!labeledBoard.ComputeOpenings()) return 0;
+		return EstimateZiNi(labeledBoard);
+	}
+
+	const int32 totalCellCount = InBoard.Num();
+
+	FZiNiState state(InBoard);
+	state.NumClosedSafeCells = totalCellCount - InBoard.MineCount;
+
+	// every opening needs one click no matter what, and opening them first makes chord premiums exact
+	for (int32 openingId = 1; openingId <= InBoard.GetNumOpenings(); ++openingId)
+	{
+		++state.Clicks;
+		for (const int32 cellIndex : InBoard.GetOpeningCells(openingId))
+		{
+			state.Open(cellIndex);
+		}
+	}
+	state.ChangedCells.Reset();
+
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		state.Premiums[cellIndex] = state.ComputePremium(cellIndex);
+	}
+
+	int32 closedCursor = 0;
+	while (state.NumClosedSafeCells > 0)
+	{
+		int32 bestIndex = INDEX_NONE;
+		int32 bestPremium = 0;
+		for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+		{
+			if (state.Premiums[cellIndex] > bestPremium)
+			{
+				bestPremium = state.Premiums[cellIndex];
+				bestIndex = cellIndex;
+			}
+		}
+
+		if (bestIndex != INDEX_NONE)
+		{
+			state.Chord(bestIndex);
+		}
+		else
+		{
+			// no chord saves a click, so click the next closed safe cell directly
+			while (InBoard.HasMine(closedCursor) || state.Opened[closedCursor])
+			{
+				++closedCursor;
+			}
+
+			++state.Clicks;
+			state.Open(closedCursor);
+		}
+
+		state.UpdateChangedPremiums();
+	}
+
+	return state.Clicks;
+}
+
+
+void FMinesweeperBoardMetrics::ComputeBatch(TArrayView<const FMinesweeperBoard> InBoards, TArrayView<FMinesweeperBoardMetrics> OutMetrics, const bool bInEstimateZiNi, const int32 InNumWorkers)
+{
+	check(InBoards.Num() == OutMetrics.Num());
+	if (InBoards.Num() == 0) return;
+
+	// contiguous ranges per worker keep each worker on its own boards and results
+	const int32 numWorkers = InNumWorkers > 0 ? InNumWorkers : FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+	const int32 numChunks = FMath::Min(numWorkers, InBoards.Num());
+
+	ParallelFor(numChunks, [&](const int32 InChunkIndex)
+		{
+			const int32 startIndex = (int32)(((int64)InBoards.Num() * InChunkIndex) / numChunks);
+			const int32 endIndex = (int32)(((int64)InBoards.Num() * (InChunkIndex + 1)) / numChunks);
+
+			for (int32 boardIndex = startIndex; boardIndex < endIndex; ++boardIndex)
+			{
+				OutMetrics[boardIndex] = Compute(InBoards[boardIndex]);
+				if (bInEstimateZiNi)
+				{
+					OutMetrics[boardIndex].ZiNi = EstimateZiNi(InBoards[boardIndex]);
+				}
+			}
+		});
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,224 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoardPool.h"
+#include "MinesweeperStats.h"
+#include "MinesweeperRuntimeModule.h"
+#include "Misc/ScopeLock.h"
+#include "HAL/IConsoleManager.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Board Pool Hits"), STAT_MinesweeperBoardPoolHits, STATGROUP_Minesweeper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Board Pool Misses"), STAT_MinesweeperBoardPoolMisses, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Board Pool Hit Rate"), STAT_MinesweeperBoardPoolHitRate, STATGROUP_Minesweeper);
+
+
+
+
+FMinesweeperBoardPool& FMinesweeperBoardPool::Get()
+{
+	static FMinesweeperBoardPool boardPool;
+	return boardPool;
+}
+
+FMinesweeperBoardPool::FMinesweeperBoardPool()
+{
+	NextSeed = (int32)FPlatformTime::Cycles();
+}
+
+FMinesweeperBoardPool::~FMinesweeperBoardPool()
+{
+	Shutdown();
+}
+
+
+bool FMinesweeperBoardPool::TryTake(const FMinesweeperGenerationParams& InParams, FMinesweeperBoard& OutBoard)
+{
+	if (bIsShutdown) return false;
+
+	const FPoolKey key = MakeKey(InParams.Difficulty, InParams.Mode, InParams.FirstClickIndex);
+
+	FMinesweeperBoard pooledBoard;
+	bool bHit = false;
+	{
+		FScopeLock scopeLock(&PoolLock);
+
+		FPoolEntry* entry = Entries.Find(key);
+		if (entry && entry->ReadyBoards.Num() > 0)
+		{
+			pooledBoard = entry->ReadyBoards.Pop(false);
+			bHit = true;
+		}
+
+		// misses also create the entry so the next game with the same click class hits
+		RequestRefill_Locked(key);
+	}
+
+	if (bHit)
+	{
+		// find the symmetry that moves the canonical cell the board was generated for onto the clicked cell
+		for (int32 symmetry = 0; symmetry < pooledBoard.NumSymmetries(); ++symmetry)
+		{
+			if (pooledBoard.TransformIndex((EMinesweeperBoardSymmetry)symmetry, key.CanonicalCellIndex) == InParams.FirstClickIndex)
+			{
+				pooledBoard.Transform((EMinesweeperBoardSymmetry)symmetry, OutBoard);
+				break;
+			}
+		}
+		++NumHits;
+		INC_DWORD_STAT(STAT_MinesweeperBoardPoolHits);
+	}
+	else
+	{
+		++NumMisses;
+		INC_DWORD_STAT(STAT_MinesweeperBoardPoolMisses);
+	}
+
+	SET_FLOAT_STAT(STAT_MinesweeperBoardPoolHitRate, GetHitRate());
+
+	return bHit;
+}
+
+void FMinesweeperBoardPool::Prefetch(const FMinesweeperDifficulty& InDifficulty, const EMinesweeperGenerationMode InMode, const int32 InFirstClickIndex)
+{
+	if (bIsShutdown || InFirstClickIndex < 0 || InFirstClickIndex >= InDifficulty.TotalCells()) return;
+
+	FScopeLock scopeLock(&PoolLock);
+	RequestRefill_Locked(MakeKey(InDifficulty, InMode, InFirstClickIndex));
+}
+
+void FMinesweeperBoardPool::Shutdown()
+{
+	bIsShutdown = true;
+
+	TArray<UE::Tasks::FTask> runningTasks;
+	{
+		FScopeLock scopeLock(&PoolLock);
+		runningTasks = MoveTemp(RefillTasks);
+	}
+
+	// refills take the lock when they finish a board, so wait without holding it
+	for (UE::Tasks::FTask& task : runningTasks)
+	{
+		task.Wait();
+	}
+
+	FScopeLock scopeLock(&PoolLock);
+	Entries.Empty();
+}
+
+
+float FMinesweeperBoardPool::GetHitRate() const
+{
+	const int32 numRequests = NumHits.load() + NumMisses.load();
+	return numRequests > 0 ? (float)NumHits.load() / (float)numRequests : 0.0f;
+}
+
+
+FMinesweeperBoardPool::FPoolKey FMinesweeperBoardPool::MakeKey(const FMinesweeperDifficulty& InDifficulty, const EMinesweeperGenerationMode InMode, const int32 InFirstClickIndex) const
+{
+	FMinesweeperBoard shape;
+	shape.Width = InDifficulty.Width;
+	shape.Height = InDifficulty.Height;
+
+	FPoolKey key;
+	key.Difficulty = InDifficulty;
+	key.Mode = InMode;
+	key.CanonicalCellIndex = shape.GetCanonicalCellIndex(InFirstClickIndex);
+	return key;
+}
+
+void FMinesweeperBoardPool::RequestRefill_Locked(const FPoolKey& InKey)
+{
+	FPoolEntry* entry = Entries.Find(InKey);
+	if (!entry)
+	{
+		if (Entries.Num() >= MaxClasses)
+		{
+			EvictOldestEntry_Locked();
+		}
+		entry = &Entries.Add(InKey);
+	}
+
+	entry->LastRequestTime = FPlatformTime::Seconds();
+
+	if (entry->bRefillInFlight || entry->ReadyBoards.Num() >= BoardsPerClass || bIsShutdown) return;
+
+	entry->bRefillInFlight = true;
+
+	RefillTasks.RemoveAll([](const UE::Tasks::FTask& InTask) { return InTask.IsCompleted(); });
+	RefillTasks.Add(UE::Tasks::Launch(UE_SOURCE_LOCATION, [this, InKey]() { Refill(InKey); }, UE::Tasks::ETaskPriority::BackgroundNormal));
+}
+
+void FMinesweeperBoardPool::EvictOldestEntry_Locked()
+{
+	const FPoolKey* oldestKey = nullptr;
+	double oldestRequestTime = MAX_dbl;
+
+	for (const TPair<FPoolKey, FPoolEntry>& pair : Entries)
+	{
+		// entries with a running refill are still referenced by their task
+		if (!pair.Value.bRefillInFlight && pair.Value.LastRequestTime < oldestRequestTime)
+		{
+			oldestKey = &pair.Key;
+			oldestRequestTime = pair.Value.LastRequestTime;
+		}
+	}
+
+	if (oldestKey)
+	{
+		Entries.Remove(FPoolKey(*oldestKey));
+	}
+}
+
+void FMinesweeperBoardPool::Refill(const FPoolKey InKey)
+{
+	while (!bIsShutdown)
+	{
+		// generate off the game thread with a single worker so background refills never starve the game
+		FMinesweeperGenerationParams params;
+		params.Difficulty = InKey.Difficulty;
+		params.Mode = InKey.Mode;
+		params.FirstClickIndex = InKey.CanonicalCellIndex;
+		params.Seed = NextSeed.fetch_add(1);
+		params.NumWorkers = 1;
+
+		FMinesweeperBoard board;
+		const FMinesweeperGenerationResult result = FMinesweeperBoardGenerator::Generate(params, board);
+
+		FScopeLock scopeLock(&PoolLock);
+
+		FPoolEntry* entry = Entries.Find(InKey);
+		if (!entry) return;
+
+		if (result.bSuccess)
+		{
+			entry->ReadyBoards.Add(MoveTemp(board));
+		}
+
+		if (!result.bSuccess || entry->ReadyBoards.Num() >= BoardsPerClass || bIsShutdown)
+		{
+			entry->bRefillInFlight = false;
+			return;
+		}
+	}
+}
+
+
+static FAutoConsoleCommand GMinesweeperBoardPoolStatsCommand(
+	TEXT("Minesweeper.BoardPool.Stats"),
+	TEXT("Logs the hit rate of the pre-generated board pool."),
+	FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FMinesweeperBoardPool& boardPool = FMinesweeperBoardPool::Get();
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("Board pool: %d hits, %d misses, %.1f%% hit rate."),
+				boardPool.GetNumHits(), boardPool.GetNumMisses(), boardPool.GetHitRate() * 100.0f);
+		})
+);
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,96 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBoardRating.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+FMinesweeperBoardRating FMinesweeperBoardRater::Rate(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex)
+{
+	FMinesweeperBoardRating rating;
+	if (!InBoard.IsValidIndex(InFirstClickIndex) || InBoard.HasMine(InFirstClickIndex)) return rating;
+
+	Solver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+	Frontier.Init(InBoard.Width, InBoard.Height);
+
+	const int32 safeCellCount = InBoard.Num() - InBoard.MineCount;
+	int32 cellIndex = InFirstClickIndex;
+
+	while (cellIndex != INDEX_NONE)
+	{
+		Solver.RevealCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+		Frontier.OpenCell(cellIndex, InBoard.GetNeighborMineCount(cellIndex));
+		Solver.Solve();
+
+		cellIndex = Solver.PopSafeCell();
+		if (cellIndex != INDEX_NONE || Frontier.NumOpenedCells() == safeCellCount) continue;
+
+		// the rules are stuck, enumerate with every mine they found flagged
+		for (const int32 mineIndex : Solver.GetKnownMines())
+		{
+			Frontier.SetFlagged(mineIndex, true);
+		}
+
+		const FMinesweeperProbabilityResult result = ProbabilityEngine.Compute(Frontier, InBoard.MineCount, 1);
+		rating.MaxComponentSize = FMath::Max(rating.MaxComponentSize, result.LargestComponent);
+
+		// the safest cell without a mine, a provably safe one needs no guess
+		float bestProbability = 2.0f;
+		for (const int32 closedIndex : Frontier.GetClosedCells().GetCells())
+		{
+			const float probability = result.bSuccess ? ProbabilityEngine.GetMineProbability(closedIndex) : 1.0f;
+			if (!InBoard.HasMine(closedIndex) && (probability < bestProbability || (probability == bestProbability && closedIndex < cellIndex)))
+			{
+				bestProbability = probability;
+				cellIndex = closedIndex;
+			}
+		}
+
+		if (cellIndex == INDEX_NONE) break;
+
+		if (bestProbability <= 0.0f)
+		{
+			rating.DeductionDepth = FMinesweeperBoardRating::EnumerationDepth;
+		}
+		else
+		{
+			++rating.Guesses;
+		}
+	}
+
+	rating.DeductionDepth = FMath::Max(rating.DeductionDepth, (int32)Solver.GetHardestRule());
+	return rating;
+}
+
+
+void FMinesweeperBoardRater::RateBatch(TArrayView<const FMinesweeperBoard> InBoards, TArrayView<const int32> InFirstClickIndices, TArrayView<FMinesweeperBoardRating> OutRatings, const int32 InNumWorkers)
+{
+	check(InBoards.Num() == InFirstClickIndices.Num() && InBoards.Num() == OutRatings.Num());
+	if (InBoards.Num() == 0) return;
+
+	// contiguous ranges per worker keep each worker on its own boards, results and rater
+	const int32 numWorkers = InNumWorkers > 0 ? InNumWorkers : FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+	const int32 numChunks = FMath::Min(numWorkers, InBoards.Num());
+
+	ParallelFor(numChunks, [&](const int32 InChunkIndex)
+		{
+			const int32 startIndex = (int32)(((int64)InBoards.Num() * InChunkIndex) / numChunks);
+			const int32 endIndex = (int32)(((int64)InBoards.Num() * (InChunkIndex + 1)) / numChunks);
+
+			FMinesweeperBoardRater rater;
+			for (int32 boardIndex = startIndex; boardIndex < endIndex; ++boardIndex)
+			{
+				OutRatings[boardIndex] = rater.Rate(InBoards[boardIndex], InFirstClickIndices[boardIndex]);
+			}
+		});
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
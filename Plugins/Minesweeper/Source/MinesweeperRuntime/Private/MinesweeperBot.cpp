@@ -0,0 +1,176 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperBot.h"
+#include "MinesweeperGame.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+FMinesweeperBotResult FMinesweeperBot::Play(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex)
+{
+	const double startTime = FPlatformTime::Seconds();
+
+	FMinesweeperBotResult result;
+	if (!InBoard.IsValidIndex(InFirstClickIndex)) return result;
+
+	Solver.Init(InBoard.Width, InBoard.Height, InBoard.MineCount);
+	Frontier.Init(InBoard.Width, InBoard.Height);
+
+	const int32 safeCellCount = InBoard.Num() - InBoard.MineCount;
+	int32 cellIndex = InFirstClickIndex;
+
+	while (cellIndex != INDEX_NONE)
+	{
+		++result.NumMoves;
+		if (InBoard.HasMine(cellIndex)) break;
+
+		RevealCell(InBoard, cellIndex);
+		Solver.Solve();
+
+		if (Frontier.NumOpenedCells() == safeCellCount)
+		{
+			result.bWon = true;
+			break;
+		}
+
+		cellIndex = Solver.PopSafeCell();
+		if (cellIndex != INDEX_NONE) continue;
+
+		// logic is stuck, proven mines are flagged so the probabilities only spread the unknown mines
+		for (const int32 mineIndex : Solver.GetKnownMines())
+		{
+			Frontier.SetFlagged(mineIndex, true);
+		}
+
+		// games are spread over the workers already, so each position is computed and searched on the calling thread
+		if (ProbabilityEngine.Compute(Frontier, InBoard.MineCount, 1).bSuccess)
+		{
+			if (bUseGuessSearch)
+			{
+				FMinesweeperGuessSettings guessSettings = GuessSettings;
+				guessSettings.NumWorkers = 1;
+				cellIndex = FMinesweeperGuessEvaluator::FindBestGuess(Frontier, InBoard.MineCount, ProbabilityEngine, guessSettings).CellIndex;
+			}
+			else
+			{
+				cellIndex = FindBestGuess(Frontier, ProbabilityEngine);
+			}
+
+			// enumeration can prove a cell safe that the rules could not, opening it is no guess
+			if (cellIndex != INDEX_NONE && ProbabilityEngine.GetMineProbability(cellIndex) > 0.0f)
+			{
+				++result.NumGuesses;
+			}
+		}
+	}
+
+	result.Seconds = FPlatformTime::Seconds() - startTime;
+	return result;
+}
+
+
+FMinesweeperBotResult FMinesweeperBot::PlayGame(UMinesweeperGame* InGame, const int32 InFirstCellX, const int32 InFirstCellY, const float InSecondsPerMove,
+	const bool bInUseGuessSearch)
+{
+	check(IsInGameThread());
+
+	const double startTime = FPlatformTime::Seconds();
+
+	FMinesweeperBotResult result;
+	if (!InGame || InGame->IsEndless() || InGame->IsGameActive()) return result;
+
+	// the game only accepts clicks after its timer has started, which happens when it is ticked
+	FTickableGameObject& tickableGame = *InGame;
+
+	int32 cellX = InFirstCellX;
+	int32 cellY = InFirstCellY;
+
+	while (true)
+	{
+		++result.NumMoves;
+		InGame->TryOpenCell(cellX, cellY);
+		tickableGame.Tick(InSecondsPerMove);
+
+		if (!InGame->IsGameActive())
+		{
+			result.bWon = InGame->HasWon();
+			break;
+		}
+
+		if (InGame->GetHintCell(cellX, cellY)) continue;
+
+		if (!InGame->UpdateMineProbabilities()) break;
+
+		const int32 cellIndex = bInUseGuessSearch
+			? FMinesweeperGuessEvaluator::FindBestGuess(InGame->GetFrontier(), InGame->GetDifficulty().MineCount, InGame->GetProbabilityEngine()).CellIndex
+			: FindBestGuess(InGame->GetFrontier(), InGame->GetProbabilityEngine());
+		if (cellIndex == INDEX_NONE) break;
+
+		const FIntVector2 cellCoord = InGame->GridIndexToCoord(cellIndex);
+		cellX = cellCoord.X;
+		cellY = cellCoord.Y;
+		if (InGame->GetProbabilityEngine().GetMineProbability(cellIndex) > 0.0f)
+		{
+			++result.NumGuesses;
+		}
+	}
+
+	result.Seconds = FPlatformTime::Seconds() - startTime;
+	return result;
+}
+
+
+int32 FMinesweeperBot::FindBestGuess(const FMinesweeperFrontier& InFrontier, const FMinesweeperProbabilityEngine& InProbabilityEngine)
+{
+	if (!InProbabilityEngine.HasProbabilities()) return INDEX_NONE;
+
+	int32 bestCellIndex = INDEX_NONE;
+	float bestProbability = 2.0f;
+
+	const int32 totalCellCount = FMath::Min(InFrontier.Num(), InProbabilityEngine.GetProbabilities().Num());
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (InFrontier.IsOpened(cellIndex) || InFrontier.IsFlagged(cellIndex)) continue;
+
+		const float mineProbability = InProbabilityEngine.GetMineProbability(cellIndex);
+		if (mineProbability < bestProbability)
+		{
+			bestProbability = mineProbability;
+			bestCellIndex = cellIndex;
+		}
+	}
+	return bestCellIndex;
+}
+
+
+void FMinesweeperBot::RevealCell(const FMinesweeperBoard& InBoard, const int32 InCellIndex)
+{
+	auto openCell = [&](const int32 InOpenIndex)
+	{
+		if (Frontier.IsOpened(InOpenIndex)) return;
+
+		Frontier.OpenCell(InOpenIndex, InBoard.GetNeighborMineCount(InOpenIndex));
+		Solver.RevealCell(InOpenIndex, InBoard.GetNeighborMineCount(InOpenIndex));
+	};
+
+	// a zero cell opens its whole opening at once, the same cells the game floods through
+	if (InBoard.IsZeroCell(InCellIndex) && InBoard.HasOpeningLabels())
+	{
+		for (const int32 openingCellIndex : InBoard.GetOpeningCells(InBoard.GetOpeningId(InCellIndex)))
+		{
+			openCell(openingCellIndex);
+		}
+	}
+	else
+	{
+		openCell(InCellIndex);
+	}
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,179 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperComponentCache.h"
+#include "MinesweeperRuntimeModule.h"
+#include "MinesweeperStats.h"
+#include "Misc/ScopeRWLock.h"
+#include "HAL/IConsoleManager.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Component Cache Hits"), STAT_MinesweeperComponentCacheHits, STATGROUP_Minesweeper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Component Cache Misses"), STAT_MinesweeperComponentCacheMisses, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Component Cache Hit Rate"), STAT_MinesweeperComponentCacheHitRate, STATGROUP_Minesweeper);
+DECLARE_MEMORY_STAT(TEXT("Component Cache Memory"), STAT_MinesweeperComponentCacheMemory, STATGROUP_Minesweeper);
+
+
+
+
+FMinesweeperComponentCache& FMinesweeperComponentCache::Get()
+{
+	static FMinesweeperComponentCache componentCache;
+	return componentCache;
+}
+
+
+bool FMinesweeperComponentCache::Find(const uint64 InHash, const int32 InMaxMines, FMinesweeperComponentCacheEntry& OutEntry)
+{
+	bool bHit = false;
+	{
+		FReadScopeLock readLock(CacheLock);
+
+		const FMinesweeperComponentCacheEntry* entry = Entries.Find(InHash);
+		if (entry && entry->MaxMines >= InMaxMines)
+		{
+			OutEntry = *entry;
+			bHit = true;
+		}
+	}
+
+	if (bHit)
+	{
+		++NumHits;
+		INC_DWORD_STAT(STAT_MinesweeperComponentCacheHits);
+	}
+	else
+	{
+		++NumMisses;
+		INC_DWORD_STAT(STAT_MinesweeperComponentCacheMisses);
+	}
+	SET_FLOAT_STAT(STAT_MinesweeperComponentCacheHitRate, GetHitRate());
+
+	return bHit;
+}
+
+void FMinesweeperComponentCache::Add(const uint64 InHash, FMinesweeperComponentCacheEntry&& InEntry)
+{
+	const SIZE_T entryBytes = InEntry.GetAllocatedSize();
+
+	FWriteScopeLock writeLock(CacheLock);
+
+	if (FMinesweeperComponentCacheEntry* entry = Entries.Find(InHash))
+	{
+		// another worker may have counted the same component meanwhile, keep whichever counts more solutions
+		if (entry->MaxMines >= InEntry.MaxMines) return;
+
+		AllocatedBytes -= entry->GetAllocatedSize();
+		DEC_MEMORY_STAT_BY(STAT_MinesweeperComponentCacheMemory, entry->GetAllocatedSize());
+		*entry = MoveTemp(InEntry);
+	}
+	else
+	{
+		Entries.Add(InHash, MoveTemp(InEntry));
+		InsertionOrder.Add(InHash);
+	}
+
+	AllocatedBytes += entryBytes;
+	INC_MEMORY_STAT_BY(STAT_MinesweeperComponentCacheMemory, entryBytes);
+
+	Trim_Locked();
+}
+
+void FMinesweeperComponentCache::Reset()
+{
+	FWriteScopeLock writeLock(CacheLock);
+
+	Entries.Empty();
+	InsertionOrder.Empty();
+	OldestInsertion = 0;
+
+	DEC_MEMORY_STAT_BY(STAT_MinesweeperComponentCacheMemory, AllocatedBytes);
+	AllocatedBytes = 0;
+
+	NumHits = 0;
+	NumMisses = 0;
+}
+
+
+void FMinesweeperComponentCache::SetMaxBytes(const SIZE_T InMaxBytes)
+{
+	FWriteScopeLock writeLock(CacheLock);
+
+	MaxBytes = InMaxBytes;
+	Trim_Locked();
+}
+
+SIZE_T FMinesweeperComponentCache::GetMaxBytes() const
+{
+	FReadScopeLock readLock(CacheLock);
+	return MaxBytes;
+}
+
+SIZE_T FMinesweeperComponentCache::GetAllocatedBytes() const
+{
+	FReadScopeLock readLock(CacheLock);
+	return AllocatedBytes;
+}
+
+int32 FMinesweeperComponentCache::Num() const
+{
+	FReadScopeLock readLock(CacheLock);
+	return Entries.Num();
+}
+
+float FMinesweeperComponentCache::GetHitRate() const
+{
+	const int64 numRequests = NumHits.load() + NumMisses.load();
+	return numRequests > 0 ? (float)((double)NumHits.load() / (double)numRequests) : 0.0f;
+}
+
+
+void FMinesweeperComponentCache::Trim_Locked()
+{
+	while (AllocatedBytes > MaxBytes && OldestInsertion < InsertionOrder.Num())
+	{
+		FMinesweeperComponentCacheEntry entry;
+		if (Entries.RemoveAndCopyValue(InsertionOrder[OldestInsertion++], entry))
+		{
+			AllocatedBytes -= entry.GetAllocatedSize();
+			DEC_MEMORY_STAT_BY(STAT_MinesweeperComponentCacheMemory, entry.GetAllocatedSize());
+		}
+	}
+
+	// drop evicted hashes once they make up half of the queue
+	if (OldestInsertion > 0 && OldestInsertion * 2 >= InsertionOrder.Num())
+	{
+		InsertionOrder.RemoveAt(0, OldestInsertion, false);
+		OldestInsertion = 0;
+	}
+}
+
+
+static FAutoConsoleCommand GMinesweeperComponentCacheStatsCommand(
+	TEXT("Minesweeper.ComponentCache.Stats"),
+	TEXT("Logs the size and hit rate of the frontier component transposition cache."),
+	FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FMinesweeperComponentCache& componentCache = FMinesweeperComponentCache::Get();
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("Component cache: %d entries, %.2f of %.2f MB, %lld hits, %lld misses, %.1f%% hit rate."),
+				componentCache.Num(), componentCache.GetAllocatedBytes() / (1024.0 * 1024.0), componentCache.GetMaxBytes() / (1024.0 * 1024.0),
+				componentCache.GetNumHits(), componentCache.GetNumMisses(), componentCache.GetHitRate() * 100.0f);
+		})
+);
+
+static FAutoConsoleCommand GMinesweeperComponentCacheMaxMegabytesCommand(
+	TEXT("Minesweeper.ComponentCache.SetMaxMegabytes"),
+	TEXT("Sets the memory cap of the frontier component transposition cache, 0 disables caching. Usage: Minesweeper.ComponentCache.SetMaxMegabytes [Megabytes=32]"),
+	FConsoleCommandWithArgsDelegate::CreateLambda([](const TArray<FString>& InArgs)
+		{
+			const int32 maxMegabytes = InArgs.Num() > 0 ? FMath::Max(FCString::Atoi(*InArgs[0]), 0) : 32;
+			FMinesweeperComponentCache::Get().SetMaxBytes((SIZE_T)maxMegabytes * 1024 * 1024);
+		})
+);
+
+
+
+
+#undef LOCTEXT_NAMESPACE
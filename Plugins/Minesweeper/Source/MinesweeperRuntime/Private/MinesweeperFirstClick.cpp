@@ -0,0 +1,150 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperFirstClick.h"
+#include "MinesweeperRuntimeModule.h"
+#include "HAL/FileManager.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+FMinesweeperFirstClickTable& FMinesweeperFirstClickTable::Get()
+{
+	static FMinesweeperFirstClickTable table = []()
+	{
+		FMinesweeperFirstClickTable shippedTable;
+		if (IFileManager::Get().FileExists(*GetDefaultFilename()))
+		{
+			shippedTable.Load(GetDefaultFilename());
+		}
+		return shippedTable;
+	}();
+	return table;
+}
+
+
+FMinesweeperFirstClick FMinesweeperFirstClickTable::Find(const FMinesweeperDifficulty& InDifficulty) const
+{
+	FMinesweeperFirstClick firstClick;
+
+	if (const FMinesweeperFirstClickEntry* entry = Entries.Find(MakeKey(InDifficulty.Width, InDifficulty.Height, InDifficulty.MineCount)))
+	{
+		firstClick.CellIndex = entry->BestCellIndex;
+		firstClick.OpeningProbability = entry->BestCellOpeningProbability;
+		firstClick.WinRate = entry->WinRate;
+		return firstClick;
+	}
+
+	firstClick.CellIndex = FindBestOpeningCell(InDifficulty);
+	if (firstClick.CellIndex != INDEX_NONE)
+	{
+		firstClick.OpeningProbability = ComputeOpeningProbability(InDifficulty, firstClick.CellIndex);
+	}
+	return firstClick;
+}
+
+
+bool FMinesweeperFirstClickTable::Load(const FString& InFilename)
+{
+	using namespace MinesweeperFirstClickTable;
+
+	Entries.Reset();
+
+	auto fail = [&InFilename](const TCHAR* InReason)
+	{
+		UE_LOG(LogMinesweeperRuntime, Error, TEXT("First click table '%s' is invalid: %s."), *InFilename, InReason);
+		return false;
+	};
+
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *InFilename, FILEREAD_Silent)) return fail(TEXT("file not readable"));
+	if (data.Num() < (int32)sizeof(FMinesweeperFirstClickFileHeader)) return fail(TEXT("file too small"));
+
+	FMinesweeperFirstClickFileHeader fileHeader;
+	FMemory::Memcpy(&fileHeader, data.GetData(), sizeof(fileHeader));
+	if (fileHeader.Magic != Magic) return fail(TEXT("not a first click table"));
+	if (fileHeader.Version != Version) return fail(TEXT("unsupported version"));
+	if ((uint64)data.Num() != sizeof(FMinesweeperFirstClickFileHeader) + ((uint64)fileHeader.NumEntries * sizeof(FMinesweeperFirstClickEntry))) return fail(TEXT("bad entry count"));
+
+	Entries.Reserve(fileHeader.NumEntries);
+	for (uint32 entryIndex = 0; entryIndex < fileHeader.NumEntries; ++entryIndex)
+	{
+		FMinesweeperFirstClickEntry entry;
+		FMemory::Memcpy(&entry, data.GetData() + sizeof(FMinesweeperFirstClickFileHeader) + (entryIndex * sizeof(FMinesweeperFirstClickEntry)), sizeof(entry));
+
+		const int64 totalCellCount = (int64)entry.Width * entry.Height;
+		if (entry.Width <= 0 || entry.Height <= 0 || totalCellCount > MAX_uint16 || entry.BestCellIndex >= totalCellCount || entry.OpeningCellIndex >= totalCellCount)
+		{
+			Entries.Reset();
+			return fail(TEXT("bad entry"));
+		}
+
+		Entries.Add(MakeKey(entry.Width, entry.Height, entry.MineCount), entry);
+	}
+
+	return true;
+}
+
+bool FMinesweeperFirstClickTable::Save(const FString& InFilename, TArrayView<const FMinesweeperFirstClickEntry> InEntries)
+{
+	using namespace MinesweeperFirstClickTable;
+
+	FMinesweeperFirstClickFileHeader fileHeader;
+	fileHeader.Magic = Magic;
+	fileHeader.Version = Version;
+	fileHeader.NumEntries = InEntries.Num();
+
+	TUniquePtr<FArchive> fileWriter(IFileManager::Get().CreateFileWriter(*InFilename));
+	if (!fileWriter)
+	{
+		UE_LOG(LogMinesweeperRuntime, Error, TEXT("Could not open first click table '%s' for writing."), *InFilename);
+		return false;
+	}
+
+	fileWriter->Serialize(&fileHeader, sizeof(fileHeader));
+	fileWriter->Serialize((void*)InEntries.GetData(), InEntries.Num() * sizeof(FMinesweeperFirstClickEntry));
+
+	return fileWriter->Close() && !fileWriter->IsError();
+}
+
+FString FMinesweeperFirstClickTable::GetDefaultFilename()
+{
+	return FPaths::Combine(IPluginManager::Get().FindPlugin(FMinesweeperRuntimeModule::GetPluginName().ToString())->GetBaseDir(), TEXT("Resources"), TEXT("FirstClicks.msfc"));
+}
+
+
+float FMinesweeperFirstClickTable::ComputeOpeningProbability(const FMinesweeperDifficulty& InDifficulty, const int32 InCellIndex)
+{
+	const int32 totalCellCount = InDifficulty.TotalCells();
+	if (InCellIndex < 0 || InCellIndex >= totalCellCount) return 0.0f;
+
+	const int32 cellX = InCellIndex % InDifficulty.Width;
+	const int32 cellY = InCellIndex / InDifficulty.Width;
+	const int32 numNeighbors = ((FMath::Min(cellX + 1, InDifficulty.Width - 1) - FMath::Max(cellX - 1, 0) + 1) * (FMath::Min(cellY + 1, InDifficulty.Height - 1) - FMath::Max(cellY - 1, 0) + 1)) - 1;
+
+	// the ratio of binomials, one free neighbor at a time
+	const int32 numOtherCells = totalCellCount - 1;
+	const int32 numSafeOtherCells = numOtherCells - InDifficulty.MineCount;
+	double probability = 1.0;
+	for (int32 neighbor = 0; neighbor < numNeighbors; ++neighbor)
+	{
+		if (numSafeOtherCells - neighbor <= 0) return 0.0f;
+		probability *= (double)(numSafeOtherCells - neighbor) / (double)(numOtherCells - neighbor);
+	}
+	return (float)probability;
+}
+
+int32 FMinesweeperFirstClickTable::FindBestOpeningCell(const FMinesweeperDifficulty& InDifficulty)
+{
+	// the opening probability only falls with every neighbor added, and no cell has fewer than a corner
+	return InDifficulty.TotalCells() > 0 ? 0 : INDEX_NONE;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,109 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperFrontier.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void FMinesweeperFrontier::Init(const int32 InWidth, const int32 InHeight)
+{
+	Width = FMath::Max(InWidth, 0);
+	Height = FMath::Max(InHeight, 0);
+
+	States.SetNumZeroed(Num());
+	OpenedNeighbors.SetNumZeroed(Num());
+	RemainingMines.SetNumZeroed(Num());
+	RemainingUnknowns.SetNumZeroed(Num());
+
+	ClosedCells.Init(Num());
+	ActiveNumbers.Init(Num());
+
+	Reset();
+}
+
+void FMinesweeperFrontier::Reset()
+{
+	FMemory::Memzero(States.GetData(), States.Num());
+	FMemory::Memzero(OpenedNeighbors.GetData(), OpenedNeighbors.Num());
+	FMemory::Memzero(RemainingMines.GetData(), RemainingMines.Num());
+	FMemory::Memzero(RemainingUnknowns.GetData(), RemainingUnknowns.Num());
+
+	ClosedCells.Reset();
+	ActiveNumbers.Reset();
+
+	NumOpened = 0;
+	NumFlagged = 0;
+}
+
+
+void FMinesweeperFrontier::OpenCell(const int32 InCellIndex, const int32 InNeighborMineCount)
+{
+	const uint8 previousState = States[InCellIndex];
+	if (previousState == Opened) return;
+
+	States[InCellIndex] = Opened;
+	++NumOpened;
+	if (previousState == Flagged) --NumFlagged;
+
+	ClosedCells.Remove(InCellIndex);
+
+	int32 remainingMines = InNeighborMineCount;
+	int32 remainingUnknowns = 0;
+
+	ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+		{
+			++OpenedNeighbors[InNeighborIndex];
+
+			switch (States[InNeighborIndex])
+			{
+			case Closed:
+				++remainingUnknowns;
+				UpdateClosedCell(InNeighborIndex);
+				break;
+
+			case Flagged:
+				--remainingMines;
+				break;
+
+			case Opened:
+				// the opened cell was one of this number's unknowns, or one of its flags if a flood opened a flagged cell
+				if (previousState == Closed) --RemainingUnknowns[InNeighborIndex];
+				else ++RemainingMines[InNeighborIndex];
+				UpdateActiveNumber(InNeighborIndex);
+				break;
+			}
+		});
+
+	RemainingMines[InCellIndex] = (int8)remainingMines;
+	RemainingUnknowns[InCellIndex] = (uint8)remainingUnknowns;
+	UpdateActiveNumber(InCellIndex);
+}
+
+void FMinesweeperFrontier::SetFlagged(const int32 InCellIndex, const bool bInFlagged)
+{
+	const uint8 previousState = States[InCellIndex];
+	if (previousState == Opened || (previousState == Flagged) == bInFlagged) return;
+
+	States[InCellIndex] = bInFlagged ? Flagged : Closed;
+	NumFlagged += bInFlagged ? 1 : -1;
+
+	UpdateClosedCell(InCellIndex);
+
+	const int32 delta = bInFlagged ? 1 : -1;
+	ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+		{
+			if (States[InNeighborIndex] != Opened) return;
+
+			RemainingMines[InNeighborIndex] = (int8)(RemainingMines[InNeighborIndex] - delta);
+			RemainingUnknowns[InNeighborIndex] = (uint8)(RemainingUnknowns[InNeighborIndex] - delta);
+			UpdateActiveNumber(InNeighborIndex);
+		});
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
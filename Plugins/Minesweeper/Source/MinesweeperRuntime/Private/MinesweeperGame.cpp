@@ -1,6 +1,11 @@
 // Copyright 2022 Brad Monahan. All Rights Reserved.
 
 #include "MinesweeperGame.h"
+#include "MinesweeperRuntimeModule.h"
+#include "MinesweeperBoardPool.h"
+#include "MinesweeperPuzzleDatabase.h"
+#include "MinesweeperFirstClick.h"
+#include "Misc/ScopeExit.h"
 
 
 #define LOCTEXT_NAMESPACE "Minesweeper"
@@ -12,9 +17,44 @@ void UMinesweeperGame::SetupGame(const FMinesweeperDifficulty& InDifficulty)
 {
 	Difficulty = InDifficulty;
 
+	if (IsEndless())
+	{
+		Difficulty.Width = FMath::Clamp(Difficulty.Width, MinGridSize, MaxEndlessGridSize);
+		Difficulty.Height = FMath::Clamp(Difficulty.Height, MinGridSize, MaxEndlessGridSize);
+	}
+
 	const int32 totalCellCount = TotalCellCount();
 	
-	CellMap.Empty(totalCellCount);
+	// endless cells are created on demand, and their mines come from the hashed mine field instead of a board
+	CellMap.Empty(IsEndless() ? 0 : totalCellCount);
+	Board.Init(IsEndless() ? FMinesweeperDifficulty(0, 0, 0) : Difficulty);
+	BoardMetrics = FMinesweeperBoardMetrics();
+	BoardRating = FMinesweeperBoardRating();
+	BoardHash = FMinesweeperBoardHash();
+	MineField.Reset();
+	PuzzleId = INDEX_NONE;
+
+	// endless grids are too large to follow, the solver and frontier stay empty
+	const int32 trackedWidth = IsEndless() ? 0 : Difficulty.Width;
+	const int32 trackedHeight = IsEndless() ? 0 : Difficulty.Height;
+	Solver.Init(trackedWidth, trackedHeight, Difficulty.MineCount);
+	Frontier.Init(trackedWidth, trackedHeight);
+	ProbabilityEngine.Reset();
+	IsProbabilityEstimateStale = true;
+	ChangedCells.Reset();
+	CancelHint();
+
+	UpdateGridRandomSeed();
+
+	// warm the board pool for the most common first clicks, the center and the corners
+	if (GenerationMode == EMinesweeperGenerationMode::NoGuess && !HasFixedSeed)
+	{
+		FMinesweeperBoardPool& boardPool = FMinesweeperBoardPool::Get();
+		boardPool.Prefetch(Difficulty, GenerationMode, Board.CoordToIndex(Difficulty.Width / 2, Difficulty.Height / 2));
+		boardPool.Prefetch(Difficulty, GenerationMode, 0);
+	}
+
+	if (IsEndless()) return;
 
 	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
 	{
@@ -27,25 +67,63 @@ void UMinesweeperGame::RestartGame()
 	IsActive = false;
 	GameTime = 0.0f;
 
-	ForEachCell([](TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
-		{
-			InCell->Reset();
-		});
+	if (IsEndless())
+	{
+		CellMap.Empty();
+	}
+	else
+	{
+		ForEachCell([](TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
+			{
+				InCell->Reset();
+			});
+	}
+
+	Board.ClearMines();
+	BoardMetrics = FMinesweeperBoardMetrics();
+	BoardRating = FMinesweeperBoardRating();
+	BoardHash = FMinesweeperBoardHash();
+	MineField.Reset();
+
+	Solver.Reset();
+	Frontier.Reset();
+	ProbabilityEngine.Reset();
+	IsProbabilityEstimateStale = true;
+	ChangedCells.Reset();
+	CancelHint();
+
+	if (IsPuzzle())
+	{
+		LoadPuzzleBoard();
+	}
+
+	UpdateGridRandomSeed();
 }
 
 
 bool UMinesweeperGame::TryOpenCell(const int32 CellX, const int32 CellY)
 {
+	if (!IsValidGridCoord(FIntVector2(CellX, CellY))) return false;
+
 	const int32 cellIndex = GridCoordToIndex(FIntVector2(CellX, CellY));
-	if (!CellMap.Contains(cellIndex)) return false;
+	TSharedPtr<FMinesweeperCell> cell = GetCell(cellIndex);
+	if (!cell.IsValid()) return false;
 
-	TSharedRef<FMinesweeperCell> openCell = CellMap[cellIndex];
+	TSharedRef<FMinesweeperCell> openCell = cell.ToSharedRef();
 
+	ON_SCOPE_EXIT { FlushChangedCells(); };
 
 	if (IsActive && GameTime > 0.0f) // game is active and started
 	{
 		++TotalClicks; // clicks always count towards score
 
+		// an endless opening cut off by MaxEndlessOpenCells carries on from any of its opened zero cells
+		if (IsEndless() && openCell->bIsOpened && openCell->NeighborMineCount == 0)
+		{
+			OpenNeighbors(openCell, cellIndex);
+			return true;
+		}
+
 		if (openCell->bIsOpened || openCell->bIsFlagged) return false;
 
 		OpenCell(openCell, cellIndex);
@@ -78,43 +156,49 @@ bool UMinesweeperGame::TryOpenCell(const int32 CellX, const int32 CellY)
 		NumClosedCells = Difficulty.TotalCells();
 		NumOpenedCells = 0;
 
-		FRandomStream randStream(GridRandomSeed);
-
 		// calculate placement of mines after user clicks to avoid the user ever clicking a mine on the first click
-		const int32 totalCellCount = NumClosedCells;
-		int32 minesToPlace = FlagsRemaining;
-		while (minesToPlace > 0)
+		if (IsEndless())
 		{
-			int32 randCellIndex = randStream.RandRange(0, totalCellCount - 1);
+			MineField.Init(GridRandomSeed, EndlessMineDensity, CellX, CellY);
 
-			TSharedPtr<FMinesweeperCell> cell = GetCell(randCellIndex);
-			if (!cell.IsValid()) break;
+			ApplyBoard();
 
-			if (cell != openCell && !cell->bHasMine)
-			{
-				cell->bHasMine = true;
-				--minesToPlace;
-			}
+			OpenCell(openCell, cellIndex);
+			return true;
+		}
+
+		if (IsPuzzle())
+		{
+			// the board was loaded by SetupPuzzle(), the game always starts from the puzzle's start cell
+			ApplyBoard();
+
+			TSharedPtr<FMinesweeperCell> startCell = GetCell(PuzzleStartIndex);
+			OpenCell(startCell, PuzzleStartIndex);
+			return true;
 		}
 
-		// calculate neighboring mine counts for each cell
-		int32 currentNeighborMineCount = 0;
-		ForEachCell([&](TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
+		FMinesweeperGenerationParams generationParams;
+		generationParams.Difficulty = Difficulty;
+		generationParams.FirstClickIndex = cellIndex;
+		generationParams.Seed = GridRandomSeed;
+		generationParams.Mode = GenerationMode;
+
+		// expensive boards come from the background pool when one is ready for this click
+		const bool bUseBoardPool = GenerationMode == EMinesweeperGenerationMode::NoGuess && !HasFixedSeed;
+		if (!bUseBoardPool || !FMinesweeperBoardPool::Get().TryTake(generationParams, Board))
+		{
+			const FMinesweeperGenerationResult generationResult = FMinesweeperBoardGenerator::Generate(generationParams, Board);
+			if (!generationResult.bSuccess)
 			{
-				TArray<TSharedRef<FMinesweeperCell>> neighborCells = GetNeighborCells(InCellIndex);
+				UE_LOG(LogMinesweeperRuntime, Warning, TEXT("No-guess board not found after %d attempts, using a random board."), generationResult.Attempts);
+			}
+		}
 
-				currentNeighborMineCount = 0;
-				for (uint32 i = 0; i < (uint32)neighborCells.Num(); ++i)
-				{
-					if (neighborCells[i]->bHasMine) ++currentNeighborMineCount;
-				}
+		BoardMetrics = FMinesweeperBoardMetrics::Compute(Board);
+		BoardMetrics.ZiNi = FMinesweeperBoardMetrics::EstimateZiNi(Board);
+		BoardHash = FMinesweeperBoardHash::ComputeCanonical(Board);
 
-				TSharedPtr<FMinesweeperCell> cell = GetCell(InCellIndex);
-				if (cell.IsValid())
-				{
-					cell->NeighborMineCount = currentNeighborMineCount;
-				}
-			});
+		ApplyBoard();
 
 		OpenCell(openCell, cellIndex);
 	}
@@ -125,10 +209,13 @@ bool UMinesweeperGame::TryOpenCell(const int32 CellX, const int32 CellY)
 
 bool UMinesweeperGame::TryFlagCell(const int32 CellX, const int32 CellY)
 {
+	if (!IsValidGridCoord(FIntVector2(CellX, CellY))) return false;
+
 	const int32 cellIndex = GridCoordToIndex(FIntVector2(CellX, CellY));
-	if (!CellMap.Contains(cellIndex)) return false;
+	TSharedPtr<FMinesweeperCell> cell = GetCell(cellIndex);
+	if (!cell.IsValid()) return false;
 
-	TSharedRef<FMinesweeperCell> clickCell = CellMap[cellIndex];
+	TSharedRef<FMinesweeperCell> clickCell = cell.ToSharedRef();
 
 	++TotalClicks; // clicks always count towards score
 
@@ -137,6 +224,9 @@ bool UMinesweeperGame::TryFlagCell(const int32 CellX, const int32 CellY)
 
 	clickCell->bIsFlagged = ~clickCell->bIsFlagged;
 
+	ChangedCells.Add(cellIndex);
+	FlushChangedCells();
+
 	if (clickCell->bIsFlagged)
 	{
 		if (FlagsRemaining > 0)
@@ -153,6 +243,263 @@ bool UMinesweeperGame::TryFlagCell(const int32 CellX, const int32 CellY)
 }
 
 
+bool UMinesweeperGame::GetHintCell(int32& OutCellX, int32& OutCellY)
+{
+	if (!IsActive || IsEndless()) return false;
+
+	const int32 cellIndex = Solver.GetNextSafeCell();
+	if (cellIndex == INDEX_NONE) return false;
+
+	const FIntVector2 cellCoord = GridIndexToCoord(cellIndex);
+	OutCellX = cellCoord.X;
+	OutCellY = cellCoord.Y;
+	return true;
+}
+
+bool UMinesweeperGame::RequestHint()
+{
+	if (IsGameOver() || IsEndless()) return false;
+
+	if (!HintService.IsValid())
+	{
+		HintService = MakeShared<FMinesweeperHintService, ESPMode::ThreadSafe>();
+		HintService->OnHintReady.BindUObject(this, &UMinesweeperGame::HandleHintReady);
+	}
+
+	HintService->Request(MakeHintSnapshot());
+	return true;
+}
+
+void UMinesweeperGame::CancelHint()
+{
+	if (HintService.IsValid())
+	{
+		HintService->Cancel();
+	}
+}
+
+FMinesweeperHintSnapshot UMinesweeperGame::MakeHintSnapshot() const
+{
+	FMinesweeperHintSnapshot snapshot;
+	snapshot.Width = Difficulty.Width;
+	snapshot.Height = Difficulty.Height;
+	snapshot.MineCount = Difficulty.MineCount;
+	snapshot.Cells.Init(FMinesweeperHintSnapshot::ClosedCell, TotalCellCount());
+
+	for (const TPair<int32, TSharedRef<FMinesweeperCell>>& pair : CellMap)
+	{
+		const FMinesweeperCell& cell = *pair.Value;
+		if (cell.bIsOpened) snapshot.Cells[pair.Key] = (int8)cell.NeighborMineCount;
+		else if (cell.bIsFlagged) snapshot.Cells[pair.Key] = FMinesweeperHintSnapshot::FlaggedCell;
+	}
+	return snapshot;
+}
+
+void UMinesweeperGame::HandleHintReady(const FMinesweeperHint& InHint)
+{
+	if (IsGameOver()) return;
+
+	const FIntVector2 cellCoord = IsValidGridIndex(InHint.CellIndex) ? GridIndexToCoord(InHint.CellIndex) : FIntVector2(-1, -1);
+	OnHintReady.Broadcast(cellCoord.X, cellCoord.Y, InHint.bIsSafe, InHint.MineProbability);
+}
+
+int32 UMinesweeperGame::AutoFlagKnownMines()
+{
+	if (!IsActive || IsEndless()) return 0;
+
+	for (const int32 cellIndex : Solver.GetKnownMines())
+	{
+		const TSharedRef<FMinesweeperCell>* cell = CellMap.Find(cellIndex);
+		if (!cell || (*cell)->bIsOpened || (*cell)->bIsFlagged) continue;
+
+		(*cell)->bIsFlagged = true;
+		if (FlagsRemaining > 0)
+		{
+			--FlagsRemaining;
+		}
+		ChangedCells.Add(cellIndex);
+	}
+
+	const int32 numFlagged = ChangedCells.Num();
+	FlushChangedCells();
+	return numFlagged;
+}
+
+
+bool UMinesweeperGame::UpdateMineProbabilities()
+{
+	if (!IsActive || IsEndless()) return false;
+
+	// the exact result replaces any estimate, so estimating restarts on the next update
+	IsProbabilityEstimateStale = true;
+	const bool bSuccess = ProbabilityEngine.Compute(Frontier, Difficulty.MineCount).bSuccess;
+	FlushChangedProbabilities();
+	return bSuccess;
+}
+
+bool UMinesweeperGame::UpdateMineProbabilitiesWithin(const float BudgetMilliseconds)
+{
+	if (!IsActive || IsEndless()) return false;
+
+	const double budgetSeconds = FMath::Max(BudgetMilliseconds, 0.0f) / 1000.0;
+	bool bSuccess = false;
+	if (IsProbabilityEstimateStale)
+	{
+		IsProbabilityEstimateStale = false;
+		bSuccess = ProbabilityEngine.BeginEstimate(Frontier, Difficulty.MineCount, budgetSeconds, GridRandomSeed).bSuccess;
+	}
+	else
+	{
+		bSuccess = ProbabilityEngine.RefineEstimate(Frontier, budgetSeconds).bSuccess;
+	}
+	FlushChangedProbabilities();
+	return bSuccess;
+}
+
+float UMinesweeperGame::GetMineProbability(const int32 CellX, const int32 CellY) const
+{
+	if (!IsValidGridCoord(FIntVector2(CellX, CellY)) || !ProbabilityEngine.HasProbabilities()) return -1.0f;
+
+	const int32 cellIndex = GridCoordToIndex(FIntVector2(CellX, CellY));
+	return ProbabilityEngine.IsValidIndex(cellIndex) ? ProbabilityEngine.GetMineProbability(cellIndex) : -1.0f;
+}
+
+float UMinesweeperGame::GetMineProbabilityError(const int32 CellX, const int32 CellY) const
+{
+	if (!IsValidGridCoord(FIntVector2(CellX, CellY)) || !ProbabilityEngine.HasProbabilities()) return 0.0f;
+
+	return ProbabilityEngine.GetMineProbabilityError(GridCoordToIndex(FIntVector2(CellX, CellY)));
+}
+
+
+bool UMinesweeperGame::OpenPuzzleDatabase(const FString& InFilename)
+{
+	TSharedPtr<FMinesweeperPuzzleDatabase> puzzleDatabase = MakeShared<FMinesweeperPuzzleDatabase>();
+	if (!puzzleDatabase->Open(InFilename)) return false;
+
+	PuzzleDatabase = puzzleDatabase;
+	return true;
+}
+
+int64 UMinesweeperGame::FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bNoGuess, const int32 MinThreeBV, const int32 MaxThreeBV)
+{
+	if (!PuzzleDatabase.IsValid()) return INDEX_NONE;
+
+	FMinesweeperRandomStream randStream((uint32)GridRandomSeed);
+	const int64 puzzleId = PuzzleDatabase->FindRandomPuzzle(InDifficulty, bNoGuess, MinThreeBV, MaxThreeBV, randStream);
+
+	UpdateGridRandomSeed();
+
+	return puzzleId;
+}
+
+int64 UMinesweeperGame::FindRandomRatedPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bNoGuess, const int32 MinThreeBV, const int32 MaxThreeBV,
+	const FMinesweeperBoardRating& MinRating, const FMinesweeperBoardRating& MaxRating)
+{
+	if (!PuzzleDatabase.IsValid()) return INDEX_NONE;
+
+	FMinesweeperRandomStream randStream((uint32)GridRandomSeed);
+	const int64 puzzleId = PuzzleDatabase->FindRandomPuzzle(InDifficulty, bNoGuess, MinThreeBV, MaxThreeBV, MinRating, MaxRating, randStream);
+
+	UpdateGridRandomSeed();
+
+	return puzzleId;
+}
+
+bool UMinesweeperGame::SetupPuzzle(const int64 InPuzzleId)
+{
+	if (IsEndless() || !PuzzleDatabase.IsValid() || !PuzzleDatabase->GetRecord(InPuzzleId)) return false;
+
+	SetupGame(PuzzleDatabase->GetSectionDifficulty(MinesweeperPuzzleDatabase::GetSectionIndex(InPuzzleId)));
+
+	PuzzleId = InPuzzleId;
+	LoadPuzzleBoard();
+
+	return true;
+}
+
+void UMinesweeperGame::LoadPuzzleBoard()
+{
+	const FMinesweeperPuzzleRecord* record = PuzzleDatabase.IsValid() ? PuzzleDatabase->GetRecord(PuzzleId) : nullptr;
+	if (!record)
+	{
+		PuzzleId = INDEX_NONE;
+		return;
+	}
+
+	// the record is read in place from the mapped file, only the mine bits are expanded into the board planes
+	MinesweeperPuzzleDatabase::UnpackMines(record->GetMineBits(), Difficulty, Board);
+	PuzzleStartIndex = record->FirstClickIndex;
+
+	BoardMetrics.ThreeBV = record->ThreeBV;
+	BoardMetrics.Openings = record->Openings;
+	BoardMetrics.Islands = record->Islands;
+	BoardMetrics.ZiNi = record->ZiNi;
+	BoardMetrics.SafeCells = Board.Num() - Board.MineCount;
+	BoardRating = record->GetRating();
+
+	BoardHash = FMinesweeperBoardHash::ComputeCanonical(Board);
+}
+
+bool UMinesweeperGame::SetupPuzzleByCode(const FString& InBoardCode)
+{
+	uint64 shortKey = 0;
+	if (!PuzzleDatabase.IsValid() || !FMinesweeperBoardHash::ParseShortCode(InBoardCode.TrimStartAndEnd(), shortKey)) return false;
+
+	return SetupPuzzle(PuzzleDatabase->FindPuzzleByShortKey(shortKey));
+}
+
+FString UMinesweeperGame::GetBoardCode() const
+{
+	return BoardHash.IsZero() ? FString() : BoardHash.ToShortCode();
+}
+
+
+int32 UMinesweeperGame::GetRecommendedFirstClickIndex() const
+{
+	if (IsEndless()) return INDEX_NONE;
+	if (IsPuzzle()) return PuzzleStartIndex;
+
+	return FMinesweeperFirstClickTable::Get().Find(Difficulty).CellIndex;
+}
+
+bool UMinesweeperGame::OpenRecommendedFirstClick()
+{
+	const int32 cellIndex = GetRecommendedFirstClickIndex();
+	if (IsActive || GameTime > 0.0f || !IsValidGridIndex(cellIndex)) return false;
+
+	const FIntVector2 cellCoord = GridIndexToCoord(cellIndex);
+	return TryOpenCell(cellCoord.X, cellCoord.Y);
+}
+
+
+void UMinesweeperGame::SetEndlessMineDensity(const float InDensity)
+{
+	EndlessMineDensity = FMath::Clamp(InDensity, MinEndlessMineDensity, MaxEndlessMineDensity);
+}
+
+
+void UMinesweeperGame::SetGridRandomSeed(const int32 InSeed)
+{
+	GridRandomSeed = InSeed;
+	HasFixedSeed = true;
+}
+
+void UMinesweeperGame::ClearGridRandomSeed()
+{
+	HasFixedSeed = false;
+	UpdateGridRandomSeed();
+}
+
+void UMinesweeperGame::UpdateGridRandomSeed()
+{
+	if (HasFixedSeed) return;
+
+	static uint64 seedCounter = 0;
+	GridRandomSeed = (int32)MinesweeperRandom::CombineKey(FPlatformTime::Cycles64(), ++seedCounter);
+}
+
+
 bool UMinesweeperGame::IsValidGridIndex(const int32 InCellIndex) const
 {
 	return InCellIndex >= 0 && InCellIndex < TotalCellCount();
@@ -170,7 +517,8 @@ int32 UMinesweeperGame::GridCoordToIndex(const FIntVector2& InCellCoord) const
 
 FIntVector2 UMinesweeperGame::GridIndexToCoord(const int32 InCellIndex) const
 {
-	return FIntVector2(FMath::FloorToInt32((float)(InCellIndex % Difficulty.Width)), FMath::FloorToInt32((float)InCellIndex / (float)Difficulty.Width));
+	// integer division, float loses precision on endless grids
+	return FIntVector2(InCellIndex % Difficulty.Width, InCellIndex / Difficulty.Width);
 }
 
 
@@ -178,10 +526,15 @@ int32 UMinesweeperGame::FindCellIndex(TSharedPtr<FMinesweeperCell> InCell) const
 {
 	if (!InCell.IsValid()) return -1;
 
-	TArray<TSharedRef<FMinesweeperCell>> allCells;
-	CellMap.GenerateValueArray(allCells);
+	for (const TPair<int32, TSharedRef<FMinesweeperCell>>& cellPair : CellMap)
+	{
+		if (cellPair.Value == InCell.ToSharedRef())
+		{
+			return cellPair.Key;
+		}
+	}
 
-	return allCells.Find(InCell.ToSharedRef());
+	return -1;
 }
 
 
@@ -192,6 +545,15 @@ TSharedPtr<FMinesweeperCell> UMinesweeperGame::GetCell(const int32 InCellIndex)
 	{
 		return CellMap[InCellIndex];
 	}
+
+	if (IsEndless())
+	{
+		TSharedRef<FMinesweeperCell> cell = MakeShareable(new FMinesweeperCell);
+		ApplyMineField(cell.Get(), InCellIndex);
+		CellMap.Add(InCellIndex, cell);
+		return cell;
+	}
+
 	return nullptr;
 }
 
@@ -231,11 +593,41 @@ TArray<TSharedRef<FMinesweeperCell>> UMinesweeperGame::GetNeighborCells(const in
 	return outCellWidgets;
 }
 
+void UMinesweeperGame::ApplyBoard()
+{
+	if (IsEndless())
+	{
+		for (const TPair<int32, TSharedRef<FMinesweeperCell>>& cellPair : CellMap)
+		{
+			ApplyMineField(cellPair.Value.Get(), cellPair.Key);
+		}
+		return;
+	}
+
+	ForEachCell([&](TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
+		{
+			if (!Board.IsValidIndex(InCellIndex)) return;
+
+			InCell->bHasMine = Board.HasMine(InCellIndex);
+			InCell->NeighborMineCount = Board.GetNeighborMineCount(InCellIndex);
+		});
+}
+
+void UMinesweeperGame::ApplyMineField(FMinesweeperCell& InCell, const int32 InCellIndex) const
+{
+	if (!HasPlacedMines()) return;
+
+	const FIntVector2 cellCoord = GridIndexToCoord(InCellIndex);
+	InCell.bHasMine = MineField.HasMine(cellCoord.X, cellCoord.Y);
+	InCell.NeighborMineCount = MineField.GetNeighborMineCount(cellCoord.X, cellCoord.Y, Difficulty.Width, Difficulty.Height);
+}
+
 void UMinesweeperGame::OpenCell(TSharedPtr<FMinesweeperCell> InCell, const int32 InCellIndex)
 {
 	if (!CellMap.Contains(InCellIndex) || CellMap[InCellIndex] != InCell) return;
 
 	InCell->bIsOpened = true;
+	ChangedCells.Add(InCellIndex);
 
 	--NumClosedCells;
 	++NumOpenedCells;
@@ -250,25 +642,132 @@ void UMinesweeperGame::OpenNeighbors(TSharedPtr<FMinesweeperCell> InCell, const
 {
 	if (!CellMap.Contains(InCellIndex) || CellMap[InCellIndex] != InCell) return;
 
-	TArray<TSharedRef<FMinesweeperCell>> neighborCells = GetNeighborCells(InCellIndex);
-	for (auto cell : neighborCells)
+	// generated boards know every opening up front, so the whole region is opened with a linear scan
+	if (!IsEndless() && Board.HasOpeningLabels() && Board.IsValidIndex(InCellIndex) && Board.IsZeroCell(InCellIndex))
 	{
-		const int32 cellIndex = FindCellIndex(cell);
-		if (cellIndex > -1 && !cell->bIsOpened)
+		for (const int32 cellIndex : Board.GetOpeningCells(Board.GetOpeningId(InCellIndex)))
 		{
-			OpenCell(cell, cellIndex);
+			const TSharedRef<FMinesweeperCell>* cell = CellMap.Find(cellIndex);
+			if (cell && !(*cell)->bIsOpened)
+			{
+				(*cell)->bIsOpened = true;
+				ChangedCells.Add(cellIndex);
+
+				--NumClosedCells;
+				++NumOpenedCells;
+			}
+		}
+		return;
+	}
+
+	// iterative flood fill, openings on endless grids can be far too large for recursion
+	TArray<int32> pendingCells;
+	pendingCells.Add(InCellIndex);
+
+	// endless openings stop after MaxEndlessOpenCells, the zero cells left pending stay open to be continued by another click
+	const int32 maxOpenedCells = IsEndless() ? NumOpenedCells + MaxEndlessOpenCells : MAX_int32;
+
+	while (pendingCells.Num() > 0 && NumOpenedCells < maxOpenedCells)
+	{
+		const FIntVector2 cellCoord = GridIndexToCoord(pendingCells.Pop(false));
+
+		for (int32 y = FMath::Max(cellCoord.Y - 1, 0); y <= FMath::Min(cellCoord.Y + 1, Difficulty.Height - 1); ++y)
+		{
+			for (int32 x = FMath::Max(cellCoord.X - 1, 0); x <= FMath::Min(cellCoord.X + 1, Difficulty.Width - 1); ++x)
+			{
+				const int32 neighborIndex = GridCoordToIndex(FIntVector2(x, y));
+				TSharedPtr<FMinesweeperCell> neighborCell = GetCell(neighborIndex);
+				if (!neighborCell.IsValid() || neighborCell->bIsOpened) continue;
+
+				neighborCell->bIsOpened = true;
+				ChangedCells.Add(neighborIndex);
+
+				--NumClosedCells;
+				++NumOpenedCells;
+
+				if (neighborCell->NeighborMineCount == 0)
+				{
+					pendingCells.Add(neighborIndex);
+				}
+			}
 		}
 	}
 }
 
+void UMinesweeperGame::FlushChangedCells()
+{
+	if (ChangedCells.Num() == 0) return;
+
+	// only the numbers around the changed cells are re-evaluated, so the cost follows the size of the action, not the board
+	if (!IsEndless())
+	{
+		for (const int32 cellIndex : ChangedCells)
+		{
+			const TSharedRef<FMinesweeperCell>* cell = CellMap.Find(cellIndex);
+			if (!cell || ((*cell)->bHasMine && (*cell)->bIsOpened)) continue;
+
+			if ((*cell)->bIsOpened)
+			{
+				Frontier.OpenCell(cellIndex, (*cell)->NeighborMineCount);
+				Solver.RevealCell(cellIndex, (*cell)->NeighborMineCount);
+			}
+			else
+			{
+				Frontier.SetFlagged(cellIndex, (*cell)->bIsFlagged);
+			}
+		}
+		Solver.Solve();
+		IsProbabilityEstimateStale = true;
+
+		// a pending hint may point at a cell that was just opened, restart it from the new position
+		if (IsHintPending())
+		{
+			HintService->Request(MakeHintSnapshot());
+		}
+	}
+
+	OnCellsChanged.Broadcast(ChangedCells);
+	ChangedCells.Reset();
+}
+
+void UMinesweeperGame::FlushChangedProbabilities()
+{
+	if (ProbabilityEngine.GetChangedCells().Num() == 0) return;
+
+	OnMineProbabilitiesChanged.Broadcast(ProbabilityEngine.GetChangedCells());
+	ProbabilityEngine.ClearChangedCells();
+}
+
 void UMinesweeperGame::ForEachCell(TFunctionRef<void(TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)> InFunc)
 {
-	for (int32 cellIndex = 0; cellIndex < TotalCellCount(); ++cellIndex)
+	ForEachCellInRect(FIntVector2(0, 0), FIntVector2(Difficulty.Width, Difficulty.Height), InFunc);
+}
+
+void UMinesweeperGame::ForEachCellInRect(const FIntVector2& InMinCoord, const FIntVector2& InMaxCoord, TFunctionRef<void(TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)> InFunc)
+{
+	// untouched endless cells are not created just to be visited
+	TSharedRef<FMinesweeperCell> scratchCell = MakeShareable(new FMinesweeperCell);
+
+	const FIntVector2 minCoord(FMath::Max(InMinCoord.X, 0), FMath::Max(InMinCoord.Y, 0));
+	const FIntVector2 maxCoord(FMath::Min(InMaxCoord.X, Difficulty.Width), FMath::Min(InMaxCoord.Y, Difficulty.Height));
+
+	for (int32 y = minCoord.Y; y < maxCoord.Y; ++y)
 	{
-		TSharedPtr<FMinesweeperCell> cell = GetCell(cellIndex);
-		if (cell.IsValid())
+		for (int32 x = minCoord.X; x < maxCoord.X; ++x)
 		{
-			InFunc(cell.ToSharedRef(), cellIndex, FVector2D(cellIndex % Difficulty.Width, cellIndex / Difficulty.Width));
+			const int32 cellIndex = (Difficulty.Width * y) + x;
+			const FVector2D cellCoord(x, y);
+
+			if (const TSharedRef<FMinesweeperCell>* cell = CellMap.Find(cellIndex))
+			{
+				InFunc(*cell, cellIndex, cellCoord);
+			}
+			else if (IsEndless())
+			{
+				scratchCell->Reset();
+				ApplyMineField(scratchCell.Get(), cellIndex);
+				InFunc(scratchCell, cellIndex, cellCoord);
+			}
 		}
 	}
 }
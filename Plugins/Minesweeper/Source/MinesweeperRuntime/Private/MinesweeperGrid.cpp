@@ -145,6 +145,16 @@ void UMinesweeperGrid::UpdateResource()
 	MyGrid->UpdateResource();
 }
 
+void UMinesweeperGrid::SetShowProbabilityOverlay(const bool InShow)
+{
+	MyGrid->SetShowProbabilityOverlay(InShow);
+}
+
+void UMinesweeperGrid::UpdateProbabilityOverlay(const float InBudgetMilliseconds)
+{
+	MyGrid->UpdateProbabilityOverlay(InBudgetMilliseconds);
+}
+
 
 void UMinesweeperGrid::ClearHoverCell()
 {
@@ -28,7 +28,18 @@ UMinesweeperGridCanvas::UMinesweeperGridCanvas()
 
 void UMinesweeperGridCanvas::InitCanvas(UMinesweeperGame* InGame, const FMinesweeperVisualTheme& InVisualTheme)
 {
+	if (Game)
+	{
+		Game->OnMineProbabilitiesChanged.Remove(MineProbabilitiesChangedHandle);
+	}
+
 	Game = InGame;
+	ViewOrigin = FIntPoint::ZeroValue;
+
+	if (Game)
+	{
+		MineProbabilitiesChangedHandle = Game->OnMineProbabilitiesChanged.AddUObject(this, &UMinesweeperGridCanvas::HandleMineProbabilitiesChanged);
+	}
 
 	VisualTheme.CopyIfNotNull(InVisualTheme);
 
@@ -51,17 +62,47 @@ void UMinesweeperGridCanvas::SetCellDrawSize(const float InCellDrawSize)
 }
 
 
+void UMinesweeperGridCanvas::SetViewOrigin(const int32 InCellX, const int32 InCellY)
+{
+	if (!Game) return;
+
+	const FIntPoint viewCellCount = GetViewCellCount();
+	const FIntPoint viewOrigin(
+		FMath::Clamp(InCellX, 0, FMath::Max(Game->GetDifficulty().Width - viewCellCount.X, 0)),
+		FMath::Clamp(InCellY, 0, FMath::Max(Game->GetDifficulty().Height - viewCellCount.Y, 0)));
+
+	if (viewOrigin == ViewOrigin) return;
+	ViewOrigin = viewOrigin;
+
+	UpdateResource();
+}
+
+void UMinesweeperGridCanvas::ScrollView(const int32 InDeltaX, const int32 InDeltaY)
+{
+	SetViewOrigin(ViewOrigin.X + InDeltaX, ViewOrigin.Y + InDeltaY);
+}
+
+FIntPoint UMinesweeperGridCanvas::GetViewCellCount() const
+{
+	return FIntPoint(FMath::CeilToInt(SizeX / VisualTheme.CellDrawSize), FMath::CeilToInt(SizeY / VisualTheme.CellDrawSize));
+}
+
+
 int32 UMinesweeperGridCanvas::GridPositionToCellIndex(const FVector2D& InGridPosition) const
 {
-	return Game == nullptr ? -1 : Game->GridCoordToIndex(FIntVector2(InGridPosition.X / VisualTheme.CellDrawSize, InGridPosition.Y / VisualTheme.CellDrawSize));
+	if (Game == nullptr) return -1;
+
+	int32 cellX, cellY;
+	GridPositionToCellCoord(InGridPosition, cellX, cellY);
+	return Game->GridCoordToIndex(FIntVector2(cellX, cellY));
 }
 
 void UMinesweeperGridCanvas::GridPositionToCellCoord(const FVector2D& InGridPosition, int32& OutCellX, int32& OutCellY) const
 {
 	if (Game)
 	{
-		OutCellX = InGridPosition.X / VisualTheme.CellDrawSize;
-		OutCellY = InGridPosition.Y / VisualTheme.CellDrawSize;
+		OutCellX = ViewOrigin.X + (int32)(InGridPosition.X / VisualTheme.CellDrawSize);
+		OutCellY = ViewOrigin.Y + (int32)(InGridPosition.Y / VisualTheme.CellDrawSize);
 	}
 	else
 	{
@@ -90,6 +131,47 @@ void UMinesweeperGridCanvas::SetHoverCellCoord(const int32 InCellX, const int32
 }
 
 
+void UMinesweeperGridCanvas::SetShowProbabilityOverlay(const bool InShow)
+{
+	if (ShowProbabilityOverlay == InShow) return;
+	ShowProbabilityOverlay = InShow;
+
+	UpdateResource();
+}
+
+void UMinesweeperGridCanvas::UpdateProbabilityOverlay(const float InBudgetMilliseconds)
+{
+	if (!Game || !ShowProbabilityOverlay) return;
+
+	// the game broadcasts only the cells whose probability moved, which are marked dirty by HandleMineProbabilitiesChanged()
+	Game->UpdateMineProbabilitiesWithin(InBudgetMilliseconds);
+
+	RedrawDirtyCells();
+}
+
+void UMinesweeperGridCanvas::HandleMineProbabilitiesChanged(TArrayView<const int32> InCellIndices)
+{
+	if (!ShowProbabilityOverlay) return;
+
+	DirtyCells.Append(InCellIndices.GetData(), InCellIndices.Num());
+}
+
+void UMinesweeperGridCanvas::RedrawDirtyCells()
+{
+	if (!Game || DirtyCells.Num() == 0) return;
+
+	// repaint without recreating or clearing the texture, so every cell that is not dirty keeps what was drawn before
+	IsRedrawingDirtyCells = true;
+	const bool bShouldClear = bShouldClearRenderTargetOnReceiveUpdate;
+	bShouldClearRenderTargetOnReceiveUpdate = false;
+
+	RepaintCanvas();
+
+	bShouldClearRenderTargetOnReceiveUpdate = bShouldClear;
+	IsRedrawingDirtyCells = false;
+}
+
+
 FSlateColor UMinesweeperGridCanvas::GetNeighborMineCountColor_Implementation(const int32 InMineCount)
 {
 	return UMinesweeperStatics::DefaultNeighborMineCountColor(InMineCount);
@@ -100,87 +182,134 @@ void UMinesweeperGridCanvas::UpdateCanvas(UCanvas* InCanvas, const int32 InWidth
 {
 	if (!InCanvas || !Game) return;
 
+	// only the cells inside the view window are drawn, endless grids hold billions of them
+	const FIntVector2 viewMin(ViewOrigin.X, ViewOrigin.Y);
+	const FIntVector2 viewMax(viewMin.X + FMath::CeilToInt(InWidth / VisualTheme.CellDrawSize), viewMin.Y + FMath::CeilToInt(InHeight / VisualTheme.CellDrawSize));
 
-	auto DrawCell = [&](const FVector2D& InPosition, const UTexture2D* InTexture, FVector2D InSize = FVector2D::ZeroVector, const FLinearColor InColor = FLinearColor(1.0f, 1.0f, 1.0f))
+	// redraw only the dirty cells, each over a cleared tile since cell textures may be translucent
+	if (IsRedrawingDirtyCells)
 	{
-		if (!InTexture) return;
-		if (InSize == FVector2D::ZeroVector) InSize = FVector2D(VisualTheme.CellDrawSize);
-		FCanvasTileItem canvasTileItem(InPosition, InTexture->GetResource(), InSize, InColor);
-		canvasTileItem.BlendMode = SE_BLEND_Translucent;
-		InCanvas->DrawItem(canvasTileItem);
-	};
+		for (const int32 cellIndex : DirtyCells)
+		{
+			const FIntVector2 gridCoord = Game->GridIndexToCoord(cellIndex);
+			if (gridCoord.X < viewMin.X || gridCoord.Y < viewMin.Y || gridCoord.X >= viewMax.X || gridCoord.Y >= viewMax.Y) continue;
+
+			const TSharedPtr<FMinesweeperCell> cell = Game->GetCell(cellIndex);
+			if (!cell.IsValid()) continue;
+
+			const FVector2D cellCoord(gridCoord.X, gridCoord.Y);
+
+			FCanvasTileItem clearTileItem((cellCoord - FVector2D(ViewOrigin)) * VisualTheme.CellDrawSize, FVector2D(VisualTheme.CellDrawSize), ClearColor);
+			clearTileItem.BlendMode = SE_BLEND_Opaque;
+			InCanvas->DrawItem(clearTileItem);
+
+			DrawGridCell(InCanvas, *cell, cellIndex, cellCoord);
+		}
+		DirtyCells.Reset();
+		return;
+	}
 
 
 	// draw the minesweeper grid
-	Game->ForEachCell([&](const TSharedPtr<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
+	Game->ForEachCellInRect(viewMin, viewMax, [&](const TSharedPtr<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)
 		{
-			const FVector2D cellPosition = InCellCoord * VisualTheme.CellDrawSize;
+			DrawGridCell(InCanvas, *InCell, InCellIndex, InCellCoord);
+		});
+
+	DirtyCells.Reset();
+}
+
 
+void UMinesweeperGridCanvas::DrawCellTexture(UCanvas* InCanvas, const FVector2D& InPosition, const UTexture2D* InTexture, const FLinearColor& InColor) const
+{
+	if (!InTexture) return;
+	FCanvasTileItem canvasTileItem(InPosition, InTexture->GetResource(), FVector2D(VisualTheme.CellDrawSize), InColor);
+	canvasTileItem.BlendMode = SE_BLEND_Translucent;
+	InCanvas->DrawItem(canvasTileItem);
+}
 
-			// draw open/closed cell background
-			{
-				UTexture2D* backgroundTexture = VisualTheme.ClosedCellTexture;
-				if (InCell->bIsOpened)
-				{
-					backgroundTexture = InCell->bHasMine ? VisualTheme.OpenCellMineTexture : VisualTheme.OpenCellTexture;
-				}
-				DrawCell(cellPosition, backgroundTexture);
-			}
 
+void UMinesweeperGridCanvas::DrawGridCell(UCanvas* InCanvas, const FMinesweeperCell& InCell, const int32 InCellIndex, const FVector2D& InCellCoord)
+{
+	const FVector2D cellPosition = (InCellCoord - FVector2D(ViewOrigin)) * VisualTheme.CellDrawSize;
 
-			// draw neighbor mine count text
+
+	// draw open/closed cell background
+	{
+		UTexture2D* backgroundTexture = VisualTheme.ClosedCellTexture;
+		if (InCell.bIsOpened)
+		{
+			backgroundTexture = InCell.bHasMine ? VisualTheme.OpenCellMineTexture : VisualTheme.OpenCellTexture;
+		}
+		DrawCellTexture(InCanvas, cellPosition, backgroundTexture);
+	}
+
+
+	// draw mine probability tint, as of the last time the cell was broadcast as changed
+	if (ShowProbabilityOverlay && Game->IsGameActive() && !InCell.bIsOpened && !InCell.bIsFlagged)
+	{
+		const float mineProbability = Game->GetProbabilityEngine().GetTrackedMineProbability(InCellIndex);
+		if (mineProbability >= 0.0f)
+		{
+			FCanvasTileItem tintTileItem(cellPosition, FVector2D(VisualTheme.CellDrawSize), FMath::Lerp(VisualTheme.ProbabilityOverlaySafeColor, VisualTheme.ProbabilityOverlayMineColor, mineProbability));
+			tintTileItem.BlendMode = SE_BLEND_Translucent;
+			InCanvas->DrawItem(tintTileItem);
+		}
+	}
+
+
+	// draw neighbor mine count text
 #ifdef DEFINE_DEBUG_MINES
-			const bool drawNeighborMineCount = true;
+	const bool drawNeighborMineCount = true;
 #else
-			const bool drawNeighborMineCount = InCell->bIsOpened && !InCell->bHasMine && InCell->NeighborMineCount > 0;
+	const bool drawNeighborMineCount = InCell.bIsOpened && !InCell.bHasMine && InCell.NeighborMineCount > 0;
 #endif
-			if (VisualTheme.CellFont && drawNeighborMineCount)
-			{
-				FString neighborMineCountStr = FString::FromInt(InCell->NeighborMineCount);
-				FText neighborMineCountText = FText::FromString(neighborMineCountStr);
-				
-				float outWidth, outHeight;
-				VisualTheme.CellFont->GetCharSize(neighborMineCountStr[0], outWidth, outHeight);
-				int32 textWidth = VisualTheme.CellFont->GetStringSize(*neighborMineCountStr);
-
-				const float percentOfCellSize = 0.8f;
-
-				FVector2D textPosition = cellPosition + FVector2D((outWidth * 0.5f) * percentOfCellSize, (outHeight * 0.5f) * 0.2f);
-				
-				float scale = (VisualTheme.CellDrawSize / outHeight) * percentOfCellSize;
-
-				FCanvasTextItem textItem(textPosition, neighborMineCountText, VisualTheme.CellFont, GetNeighborMineCountColor(InCell->NeighborMineCount).GetSpecifiedColor());
-				textItem.Scale = FVector2D(scale);
-				textItem.BlendMode = SE_BLEND_Translucent;
-				InCanvas->DrawItem(textItem);
-			}
-
-			
-			// draw mine
+	if (VisualTheme.CellFont && drawNeighborMineCount)
+	{
+		FString neighborMineCountStr = FString::FromInt(InCell.NeighborMineCount);
+		FText neighborMineCountText = FText::FromString(neighborMineCountStr);
+		
+		float outWidth, outHeight;
+		VisualTheme.CellFont->GetCharSize(neighborMineCountStr[0], outWidth, outHeight);
+		int32 textWidth = VisualTheme.CellFont->GetStringSize(*neighborMineCountStr);
+
+		const float percentOfCellSize = 0.8f;
+
+		FVector2D textPosition = cellPosition + FVector2D((outWidth * 0.5f) * percentOfCellSize, (outHeight * 0.5f) * 0.2f);
+		
+		float scale = (VisualTheme.CellDrawSize / outHeight) * percentOfCellSize;
+
+		FCanvasTextItem textItem(textPosition, neighborMineCountText, VisualTheme.CellFont, GetNeighborMineCountColor(InCell.NeighborMineCount).GetSpecifiedColor());
+		textItem.Scale = FVector2D(scale);
+		textItem.BlendMode = SE_BLEND_Translucent;
+		InCanvas->DrawItem(textItem);
+	}
+
+	
+	// draw mine
 #ifdef DEFINE_DEBUG_MINES
-			const bool drawMine = InCell->bHasMine;
+	const bool drawMine = InCell.bHasMine;
 #else
-			const bool drawMine = InCell->bHasMine && Game->IsGameOver();
+	const bool drawMine = InCell.bHasMine && Game->IsGameOver();
 #endif
-			if (drawMine)
-			{
-				DrawCell(cellPosition, VisualTheme.MineTexture);
-			}
+	if (drawMine)
+	{
+		DrawCellTexture(InCanvas, cellPosition, VisualTheme.MineTexture);
+	}
 
 
-			// draw flag
-			if (!InCell->bIsOpened && InCell->bIsFlagged)
-			{
-				DrawCell(cellPosition, VisualTheme.FlagTexture);
-			}
+	// draw flag
+	if (!InCell.bIsOpened && InCell.bIsFlagged)
+	{
+		DrawCellTexture(InCanvas, cellPosition, VisualTheme.FlagTexture);
+	}
 
 
-			// draw hover cell outline
-			if (HoverCellIndex > -1 && InCellIndex == HoverCellIndex)
-			{
-				DrawCell(cellPosition, VisualTheme.HoverCellTexture, FVector2D::ZeroVector, InCell->bIsOpened ? VisualTheme.HoverCellInvalidColor : VisualTheme.HoverCellValidColor);
-			}
-		});
+	// draw hover cell outline
+	if (HoverCellIndex > -1 && InCellIndex == HoverCellIndex)
+	{
+		DrawCellTexture(InCanvas, cellPosition, VisualTheme.HoverCellTexture, InCell.bIsOpened ? VisualTheme.HoverCellInvalidColor : VisualTheme.HoverCellValidColor);
+	}
 }
 
 
@@ -0,0 +1,239 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperGuess.h"
+#include "Async/ParallelFor.h"
+#include <atomic>
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperGuessPrivate
+{
+	/** State shared by every candidate of one search. */
+	struct FSearch
+	{
+		FSearch(const FMinesweeperGuessSettings& InSettings, const int32 InMineCount, const double InDeadline, TFunctionRef<bool()> InIsCancelled)
+			: Settings(InSettings), MineCount(InMineCount), Deadline(InDeadline), IsCancelled(InIsCancelled)
+		{
+		}
+
+		const FMinesweeperGuessSettings& Settings;
+		const int32 MineCount;
+		const double Deadline;
+		TFunctionRef<bool()> IsCancelled;
+
+		std::atomic<bool> bAborted { false };
+		std::atomic<int32> NumPositions { 0 };
+		std::atomic<int64> NumNodes { 0 };
+
+		/** True once a candidate ran out of nodes, which only drops that candidate. */
+		std::atomic<bool> bOutOfNodes { false };
+
+		/** True once the budget is spent or the search is cancelled, for every candidate at once. */
+		bool ShouldStop()
+		{
+			if (!bAborted.load(std::memory_order_relaxed) && (FPlatformTime::Seconds() > Deadline || IsCancelled()))
+			{
+				bAborted = true;
+			}
+			return bAborted.load(std::memory_order_relaxed);
+		}
+	};
+
+	/**
+	 * Closed unflagged cells within InMaxProbabilityMargin of the lowest mine probability, the safest first. Ties go to cells with
+	 * fewer neighbors, which are the most likely to show a zero, so corners and edges stand in for the interior.
+	 */
+	void GatherCandidates(const FMinesweeperFrontier& InFrontier, const FMinesweeperProbabilityEngine& InProbabilityEngine, const int32 InMaxCandidates,
+		const float InMaxProbabilityMargin, TArray<int32>& OutCandidates)
+	{
+		struct FCandidate
+		{
+			float MineProbability;
+			int32 NumNeighbors;
+			int32 CellIndex;
+		};
+
+		TArray<FCandidate> candidates;
+		const int32 totalCellCount = FMath::Min(InFrontier.Num(), InProbabilityEngine.GetProbabilities().Num());
+		for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+		{
+			if (InFrontier.IsOpened(cellIndex) || InFrontier.IsFlagged(cellIndex)) continue;
+
+			int32 numNeighbors = 0;
+			InFrontier.ForEachNeighbor(cellIndex, [&numNeighbors](const int32) { ++numNeighbors; });
+			candidates.Add({ InProbabilityEngine.GetMineProbability(cellIndex), numNeighbors, cellIndex });
+		}
+
+		candidates.Sort([](const FCandidate& InA, const FCandidate& InB)
+			{
+				if (InA.MineProbability != InB.MineProbability) return InA.MineProbability < InB.MineProbability;
+				if (InA.NumNeighbors != InB.NumNeighbors) return InA.NumNeighbors < InB.NumNeighbors;
+				return InA.CellIndex < InB.CellIndex;
+			});
+
+		OutCandidates.Reset();
+		for (const FCandidate& candidate : candidates)
+		{
+			if (OutCandidates.Num() >= InMaxCandidates || candidate.MineProbability >= 1.0f) break;
+			if (candidate.MineProbability > candidates[0].MineProbability + InMaxProbabilityMargin) break;
+			OutCandidates.Add(candidate.CellIndex);
+		}
+	}
+
+	double ScoreCandidate(FSearch& InSearch, const FMinesweeperFrontier& InFrontier, const double InLogSolutionCount, const int32 InCellIndex, const int32 InDepth, int64& InOutNodesLeft);
+
+	/** Best score over the candidates of a position after a guess, -1 if the search stopped before it was scored. */
+	double ScorePosition(FSearch& InSearch, const FMinesweeperFrontier& InFrontier, const FMinesweeperProbabilityEngine& InProbabilityEngine, const int32 InDepth,
+		int64& InOutNodesLeft)
+	{
+		TArray<int32> candidates;
+		GatherCandidates(InFrontier, InProbabilityEngine, InSearch.Settings.MaxChildCandidates, InSearch.Settings.MaxProbabilityMargin, candidates);
+
+		double bestScore = 0.0;
+		for (const int32 cellIndex : candidates)
+		{
+			const double score = ScoreCandidate(InSearch, InFrontier, InProbabilityEngine.GetLogSolutionCount(), cellIndex, InDepth, InOutNodesLeft);
+			if (score < 0.0) return -1.0;
+			bestScore = FMath::Max(bestScore, score);
+		}
+		return bestScore;
+	}
+
+	/**
+	 * Chance to survive opening a cell and come out with a provably safe cell, a won game or, for numbers that prove nothing, the
+	 * score of the best guess they leave. -1 if the search stopped or InOutNodesLeft ran out before the cell was scored.
+	 */
+	double ScoreCandidate(FSearch& InSearch, const FMinesweeperFrontier& InFrontier, const double InLogSolutionCount, const int32 InCellIndex, const int32 InDepth,
+		int64& InOutNodesLeft)
+	{
+		// the cell shows its flagged neighbors plus however many of its other closed neighbors are mines
+		int32 numFlagged = 0;
+		int32 numClosed = 0;
+		InFrontier.ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+			{
+				if (InFrontier.IsFlagged(InNeighborIndex)) ++numFlagged;
+				else if (!InFrontier.IsOpened(InNeighborIndex)) ++numClosed;
+			});
+
+		FMinesweeperFrontier child;
+		FMinesweeperProbabilityEngine childEngine;
+		childEngine.SetUseComponentCache(InSearch.Settings.MaxNodes <= 0);
+		double score = 0.0;
+
+		for (int32 number = numFlagged; number <= numFlagged + numClosed; ++number)
+		{
+			if (InSearch.ShouldStop()) return -1.0;
+
+			child = InFrontier;
+			child.OpenCell(InCellIndex, number);
+
+			// a dense position can take far longer than the budget, so the enumeration itself watches the clock and the nodes
+			const FMinesweeperProbabilityResult childResult = childEngine.Compute(child, InSearch.MineCount, 1, [&InSearch]() { return InSearch.ShouldStop(); }, InOutNodesLeft);
+			++InSearch.NumPositions;
+			InSearch.NumNodes += childResult.NumNodes;
+			InOutNodesLeft -= childResult.NumNodes;
+			if (childResult.bAborted)
+			{
+				if (InOutNodesLeft <= 0) InSearch.bOutOfNodes = true;
+				return -1.0;
+			}
+
+			// numbers no layout agrees with have no solution, and the solutions of the rest split those of the position between them
+			if (!childResult.bSuccess) continue;
+
+			const double numberProbability = FMath::Exp(childEngine.GetLogSolutionCount() - InLogSolutionCount);
+
+			float lowestProbability = childResult.NumInteriorCells > 0 ? childEngine.GetInteriorProbability() : 1.0f;
+			for (const int32 closedIndex : child.GetClosedCells().GetCells())
+			{
+				lowestProbability = FMath::Min(lowestProbability, childEngine.GetMineProbability(closedIndex));
+			}
+
+			// a safe cell or nothing but mines left, otherwise the guess this number leaves
+			double numberScore = 1.0;
+			if (lowestProbability > 0.0f && lowestProbability < 1.0f)
+			{
+				numberScore = InDepth > 0 ? ScorePosition(InSearch, child, childEngine, InDepth - 1, InOutNodesLeft) : 1.0 - lowestProbability;
+				if (numberScore < 0.0) return -1.0;
+			}
+			score += numberProbability * numberScore;
+		}
+		return score;
+	}
+}
+
+
+
+
+FMinesweeperGuess FMinesweeperGuessEvaluator::FindBestGuess(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const FMinesweeperProbabilityEngine& InProbabilityEngine,
+	const FMinesweeperGuessSettings& InSettings, TFunctionRef<bool()> InIsCancelled)
+{
+	using namespace MinesweeperGuessPrivate;
+
+	const double startTime = FPlatformTime::Seconds();
+
+	FMinesweeperGuess guess;
+	if (!InProbabilityEngine.HasProbabilities()) return guess;
+
+	TArray<int32> candidates;
+	GatherCandidates(InFrontier, InProbabilityEngine, FMath::Max(InSettings.MaxCandidates, 1), InSettings.MaxProbabilityMargin, candidates);
+	if (candidates.Num() == 0) return guess;
+
+	// the safest cell stands until a candidate scores better
+	guess.CellIndex = candidates[0];
+	guess.MineProbability = InProbabilityEngine.GetMineProbability(candidates[0]);
+	guess.NumCandidates = candidates.Num();
+
+	// a safe cell needs no search and estimates have no solution counts to search with
+	if (guess.MineProbability > 0.0f && candidates.Num() > 1 && InProbabilityEngine.IsExact())
+	{
+		FSearch search(InSettings, InMineCount, startTime + InSettings.BudgetSeconds, InIsCancelled);
+
+		TArray<double> scores;
+		scores.Init(-1.0, candidates.Num());
+		ParallelFor(candidates.Num(), [&](const int32 InCandidateIndex)
+			{
+				// every candidate has a node budget of its own, so which ones finish does not depend on the order they run in
+				int64 nodesLeft = InSettings.MaxNodes > 0 ? InSettings.MaxNodes : MAX_int64;
+				scores[InCandidateIndex] = ScoreCandidate(search, InFrontier, InProbabilityEngine.GetLogSolutionCount(), candidates[InCandidateIndex], InSettings.Depth, nodesLeft);
+			}, InSettings.NumWorkers == 1);
+
+		// ties go to the safer cell
+		double bestScore = -1.0;
+		for (int32 candidateIndex = 0; candidateIndex < candidates.Num(); ++candidateIndex)
+		{
+			if (scores[candidateIndex] < 0.0) continue;
+
+			++guess.NumScored;
+			if (scores[candidateIndex] > bestScore)
+			{
+				bestScore = scores[candidateIndex];
+				guess.CellIndex = candidates[candidateIndex];
+			}
+		}
+
+		guess.MineProbability = InProbabilityEngine.GetMineProbability(guess.CellIndex);
+		guess.ProgressProbability = (float)FMath::Max(bestScore, 0.0);
+		guess.NumPositions = search.NumPositions;
+		guess.NumNodes = search.NumNodes;
+		guess.bTimedOut = search.bAborted || search.bOutOfNodes;
+	}
+
+	guess.Seconds = FPlatformTime::Seconds() - startTime;
+	return guess;
+}
+
+FMinesweeperGuess FMinesweeperGuessEvaluator::FindBestGuess(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const FMinesweeperProbabilityEngine& InProbabilityEngine,
+	const FMinesweeperGuessSettings& InSettings)
+{
+	return FindBestGuess(InFrontier, InMineCount, InProbabilityEngine, InSettings, []() { return false; });
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
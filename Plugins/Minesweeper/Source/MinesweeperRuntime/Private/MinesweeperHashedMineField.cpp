@@ -0,0 +1,38 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperHashedMineField.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void FMinesweeperHashedMineField::Init(const int32 InSeed, const double InDensity, const int32 InFirstClickX, const int32 InFirstClickY)
+{
+	Key = MinesweeperRandom::Mix64((uint64)(uint32)InSeed);
+
+	// 2^32 scaled density, clamped so a density of 1 still fits in 32 bits
+	const double threshold = FMath::Clamp(InDensity, 0.0, 1.0) * 4294967296.0;
+	DensityThreshold = (uint32)FMath::Min(threshold, 4294967295.0);
+
+	SafeX = InFirstClickX;
+	SafeY = InFirstClickY;
+}
+
+void FMinesweeperHashedMineField::Reset()
+{
+	Key = 0;
+	DensityThreshold = 0;
+}
+
+
+double FMinesweeperHashedMineField::GetDensity() const
+{
+	return (double)DensityThreshold / 4294967296.0;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
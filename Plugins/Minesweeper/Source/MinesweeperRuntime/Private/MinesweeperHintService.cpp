@@ -0,0 +1,187 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperHintService.h"
+#include "MinesweeperRuntimeModule.h"
+#include "MinesweeperStats.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperGuess.h"
+#include "MinesweeperFirstClick.h"
+#include "Tasks/Task.h"
+#include "Async/Async.h"
+#include "HAL/IConsoleManager.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Hints Requested"), STAT_MinesweeperHintsRequested, STATGROUP_Minesweeper);
+DECLARE_DWORD_ACCUMULATOR_STAT(TEXT("Hints Restarted"), STAT_MinesweeperHintsRestarted, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Hint Latency P50 (ms)"), STAT_MinesweeperHintLatencyP50, STATGROUP_Minesweeper);
+DECLARE_FLOAT_ACCUMULATOR_STAT(TEXT("Hint Latency P99 (ms)"), STAT_MinesweeperHintLatencyP99, STATGROUP_Minesweeper);
+
+
+
+
+void FMinesweeperHintService::Request(FMinesweeperHintSnapshot&& InSnapshot)
+{
+	check(IsInGameThread());
+
+	if (bIsPending)
+	{
+		INC_DWORD_STAT(STAT_MinesweeperHintsRestarted);
+	}
+	else
+	{
+		INC_DWORD_STAT(STAT_MinesweeperHintsRequested);
+		RequestStartTime = FPlatformTime::Seconds();
+	}
+	bIsPending = true;
+
+	// the task checks the id between steps, so bumping it cancels the running request
+	const int32 requestId = ++CurrentRequestId;
+
+	// weak pointers let the owner destroy the service while a request is running, the task then finishes without an answer
+	TWeakPtr<FMinesweeperHintService, ESPMode::ThreadSafe> weakThis = AsShared();
+	UE::Tasks::Launch(UE_SOURCE_LOCATION, [weakThis, requestId, snapshot = MoveTemp(InSnapshot)]()
+		{
+			FMinesweeperHint hint;
+			{
+				TSharedPtr<FMinesweeperHintService, ESPMode::ThreadSafe> service = weakThis.Pin();
+				if (!service.IsValid()) return;
+
+				auto isCancelled = [&]() { return service->CurrentRequestId.load() != requestId; };
+				hint = FindHint(snapshot, isCancelled);
+				if (isCancelled()) return;
+			}
+
+			AsyncTask(ENamedThreads::GameThread, [weakThis, requestId, hint]()
+				{
+					TSharedPtr<FMinesweeperHintService, ESPMode::ThreadSafe> service = weakThis.Pin();
+					if (service.IsValid())
+					{
+						service->Complete(requestId, hint);
+					}
+				});
+		}, UE::Tasks::ETaskPriority::BackgroundHigh);
+}
+
+void FMinesweeperHintService::Cancel()
+{
+	check(IsInGameThread());
+
+	++CurrentRequestId;
+	bIsPending = false;
+}
+
+
+void FMinesweeperHintService::Complete(const int32 InRequestId, const FMinesweeperHint& InHint)
+{
+	// the board changed or the request was cancelled after the task finished
+	if (!bIsPending || InRequestId != CurrentRequestId.load()) return;
+
+	bIsPending = false;
+
+	FMinesweeperHint hint = InHint;
+	hint.Seconds = FPlatformTime::Seconds() - RequestStartTime;
+
+	FMinesweeperLatencyTracker& latencyTracker = GetLatencyTracker();
+	latencyTracker.AddSample(hint.Seconds);
+
+	SET_FLOAT_STAT(STAT_MinesweeperHintLatencyP50, latencyTracker.GetPercentile(50.0f) * 1000.0);
+	SET_FLOAT_STAT(STAT_MinesweeperHintLatencyP99, latencyTracker.GetPercentile(99.0f) * 1000.0);
+
+	OnHintReady.ExecuteIfBound(hint);
+}
+
+
+FMinesweeperHint FMinesweeperHintService::FindHint(const FMinesweeperHintSnapshot& InSnapshot, TFunctionRef<bool()> InIsCancelled)
+{
+	FMinesweeperHint hint;
+
+	const int32 totalCellCount = InSnapshot.Cells.Num();
+	if (totalCellCount != InSnapshot.Width * InSnapshot.Height || totalCellCount == 0) return hint;
+
+	// mines are placed after the first click, so any cell is safe and the table has the one to start from
+	if (!InSnapshot.Cells.ContainsByPredicate([](const int8 InCell) { return InCell >= 0; }))
+	{
+		hint.CellIndex = FMinesweeperFirstClickTable::Get().Find(FMinesweeperDifficulty(InSnapshot.Width, InSnapshot.Height, InSnapshot.MineCount)).CellIndex;
+		hint.bIsSafe = hint.CellIndex != INDEX_NONE;
+		return hint;
+	}
+
+	FMinesweeperSolver solver;
+	solver.Init(InSnapshot.Width, InSnapshot.Height, InSnapshot.MineCount);
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (InSnapshot.Cells[cellIndex] >= 0)
+		{
+			solver.RevealCell(cellIndex, InSnapshot.Cells[cellIndex]);
+		}
+	}
+	if (InIsCancelled()) return hint;
+
+	solver.Solve();
+	if (InIsCancelled()) return hint;
+
+	// player flags are not trusted by the solver, but a flagged cell makes a poor hint even if it is safe
+	for (int32 cellIndex = solver.PopSafeCell(); cellIndex != INDEX_NONE; cellIndex = solver.PopSafeCell())
+	{
+		if (InSnapshot.Cells[cellIndex] != FMinesweeperHintSnapshot::FlaggedCell)
+		{
+			hint.CellIndex = cellIndex;
+			hint.bIsSafe = true;
+			return hint;
+		}
+	}
+
+	// logic is stuck, point at the best guess instead
+	FMinesweeperFrontier frontier;
+	frontier.Init(InSnapshot.Width, InSnapshot.Height);
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (InSnapshot.Cells[cellIndex] >= 0) frontier.OpenCell(cellIndex, InSnapshot.Cells[cellIndex]);
+		else if (InSnapshot.Cells[cellIndex] == FMinesweeperHintSnapshot::FlaggedCell) frontier.SetFlagged(cellIndex, true);
+	}
+	if (InIsCancelled()) return hint;
+
+	// dense positions can enumerate for seconds, the cancel check inside the search drops a stale request right away
+	FMinesweeperProbabilityEngine probabilityEngine;
+	if (!probabilityEngine.Compute(frontier, InSnapshot.MineCount, 1, InIsCancelled).bSuccess || InIsCancelled()) return hint;
+
+	// the search stops with the safest cell when the request is cancelled, which is then dropped anyway
+	const FMinesweeperGuess guess = FMinesweeperGuessEvaluator::FindBestGuess(frontier, InSnapshot.MineCount, probabilityEngine, FMinesweeperGuessSettings(), InIsCancelled);
+	if (guess.CellIndex != INDEX_NONE && !InIsCancelled())
+	{
+		hint.CellIndex = guess.CellIndex;
+		hint.MineProbability = guess.MineProbability;
+		hint.bIsSafe = guess.MineProbability <= 0.0f;
+	}
+	return hint;
+}
+
+
+FMinesweeperLatencyTracker& FMinesweeperHintService::GetLatencyTracker()
+{
+	static FMinesweeperLatencyTracker latencyTracker;
+	return latencyTracker;
+}
+
+
+static FAutoConsoleCommand GMinesweeperHintStatsCommand(
+	TEXT("Minesweeper.Hint.Stats"),
+	TEXT("Logs the request to answer latency percentiles of asynchronous hints."),
+	FConsoleCommandDelegate::CreateLambda([]()
+		{
+			const FMinesweeperLatencyTracker& latencyTracker = FMinesweeperHintService::GetLatencyTracker();
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("Hints: %d samples, p50 %.3f ms, p90 %.3f ms, p99 %.3f ms."),
+				latencyTracker.Num(), latencyTracker.GetPercentile(50.0f) * 1000.0,
+				latencyTracker.GetPercentile(90.0f) * 1000.0, latencyTracker.GetPercentile(99.0f) * 1000.0);
+		})
+);
+
+
+
+
+#undef LOCTEXT_NAMESPACE
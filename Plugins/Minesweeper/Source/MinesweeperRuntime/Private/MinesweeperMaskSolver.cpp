@@ -0,0 +1,499 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperMaskSolver.h"
+#include "MinesweeperProbability.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void FMinesweeperMaskSolver::Init(const int32 InWidth, const int32 InHeight, const int32 InMineCount)
+{
+	Width = FMath::Max(InWidth, 0);
+	Height = FMath::Max(InHeight, 0);
+	MineCount = InMineCount;
+
+	RowWords = ((Width + (WindowRadius * 2) + 63) / 64) + 1;
+	UnknownRows.SetNumUninitialized(RowWords * (Height + (WindowRadius * 2)));
+	MineRows.SetNumUninitialized(UnknownRows.Num());
+	OpenedRows.SetNumUninitialized(UnknownRows.Num());
+
+	States.SetNumUninitialized(Num());
+	Numbers.SetNumUninitialized(Num());
+	IsQueued.SetNumUninitialized(Num());
+
+	Reset();
+}
+
+void FMinesweeperMaskSolver::Reset()
+{
+	FMemory::Memzero(UnknownRows.GetData(), UnknownRows.Num() * sizeof(uint64));
+	FMemory::Memzero(MineRows.GetData(), MineRows.Num() * sizeof(uint64));
+	FMemory::Memzero(OpenedRows.GetData(), OpenedRows.Num() * sizeof(uint64));
+
+	for (int32 cellIndex = 0; cellIndex < Num(); ++cellIndex)
+	{
+		SetBit(UnknownRows, cellIndex, true);
+	}
+
+	FMemory::Memzero(States.GetData(), States.Num());
+	FMemory::Memzero(Numbers.GetData(), Numbers.Num());
+	FMemory::Memzero(IsQueued.GetData(), IsQueued.Num());
+
+	DirtyCells.Reset();
+	SafeCells.Reset();
+	KnownMines.Reset();
+
+	NumUnknown = Num();
+	NumOpened = 0;
+}
+
+
+void FMinesweeperMaskSolver::RevealCell(const int32 InCellIndex, const int32 InNeighborMineCount)
+{
+	const uint8 state = States[InCellIndex];
+	if (state == ECellState::Opened) return;
+
+	// a revealed mine means the player lost, nothing more to deduce from it
+	if (state == ECellState::Unknown) --NumUnknown;
+
+	States[InCellIndex] = ECellState::Opened;
+	Numbers[InCellIndex] = (uint8)InNeighborMineCount;
+	++NumOpened;
+
+	SetBit(UnknownRows, InCellIndex, false);
+	SetBit(MineRows, InCellIndex, false);
+	SetBit(OpenedRows, InCellIndex, true);
+
+	Queue(InCellIndex);
+	QueueAffected(InCellIndex);
+}
+
+
+void FMinesweeperMaskSolver::Solve()
+{
+	while (true)
+	{
+		while (DirtyCells.Num() > 0)
+		{
+			const int32 cellIndex = DirtyCells.Pop(false);
+			IsQueued[cellIndex] = 0;
+
+			if (!ApplySinglePoint(cellIndex))
+			{
+				ApplyPairs(cellIndex);
+			}
+		}
+
+		// the global rule only runs once local rules are exhausted, and only resolves anything near the end of a game
+		if (!ApplyGlobal()) break;
+	}
+}
+
+
+int32 FMinesweeperMaskSolver::GetNextSafeCell()
+{
+	while (SafeCells.Num() > 0 && States[SafeCells.Last()] != ECellState::Safe)
+	{
+		SafeCells.Pop(false);
+	}
+	return SafeCells.Num() > 0 ? SafeCells.Last() : INDEX_NONE;
+}
+
+int32 FMinesweeperMaskSolver::PopSafeCell()
+{
+	const int32 cellIndex = GetNextSafeCell();
+	if (cellIndex != INDEX_NONE)
+	{
+		SafeCells.Pop(false);
+	}
+	return cellIndex;
+}
+
+
+uint64 FMinesweeperMaskSolver::GetWindow(const TArray<uint64>& InRows, const int32 InCellIndex) const
+{
+	// with the padding the window starts at the cell's own bit position, WindowRadius rows and columns up and left
+	const int32 bitPosition = InCellIndex % Width;
+	const int32 word = bitPosition >> 6;
+	const int32 shift = bitPosition & 63;
+	const uint64* rows = InRows.GetData() + ((InCellIndex / Width) * RowWords) + word;
+
+	uint64 window = 0;
+	for (int32 y = 0; y < WindowSize; ++y, rows += RowWords)
+	{
+		const uint64 bits = shift > 0 ? (rows[0] >> shift) | (rows[1] << (64 - shift)) : rows[0];
+		window |= (bits & ((1ull << WindowSize) - 1)) << (y * WindowSize);
+	}
+	return window;
+}
+
+void FMinesweeperMaskSolver::SetBit(TArray<uint64>& InOutRows, const int32 InCellIndex, const bool bInValue)
+{
+	const int32 bitPosition = (InCellIndex % Width) + WindowRadius;
+	uint64& word = InOutRows[(((InCellIndex / Width) + WindowRadius) * RowWords) + (bitPosition >> 6)];
+	const uint64 bit = 1ull << (bitPosition & 63);
+	word = bInValue ? word | bit : word & ~bit;
+}
+
+
+bool FMinesweeperMaskSolver::ResolveWindow(const int32 InCenterIndex, uint64 InMask, const bool bInAsMines)
+{
+	const int32 cornerIndex = InCenterIndex - (Width * WindowRadius) - WindowRadius;
+
+	bool bProgress = false;
+	while (InMask != 0)
+	{
+		const int32 bit = (int32)FMath::CountTrailingZeros64(InMask);
+		InMask &= InMask - 1;
+
+		const int32 cellIndex = cornerIndex + ((bit / WindowSize) * Width) + (bit % WindowSize);
+		if (States[cellIndex] != ECellState::Unknown) continue;
+
+		ResolveCell(cellIndex, bInAsMines);
+		bProgress = true;
+	}
+	return bProgress;
+}
+
+void FMinesweeperMaskSolver::ResolveCell(const int32 InCellIndex, const bool bInAsMine)
+{
+	--NumUnknown;
+	SetBit(UnknownRows, InCellIndex, false);
+
+	if (bInAsMine)
+	{
+		States[InCellIndex] = ECellState::Mine;
+		SetBit(MineRows, InCellIndex, true);
+		KnownMines.Add(InCellIndex);
+	}
+	else
+	{
+		States[InCellIndex] = ECellState::Safe;
+		SafeCells.Add(InCellIndex);
+	}
+
+	QueueAffected(InCellIndex);
+}
+
+
+void FMinesweeperMaskSolver::Queue(const int32 InCellIndex)
+{
+	if (IsQueued[InCellIndex]) return;
+
+	IsQueued[InCellIndex] = 1;
+	DirtyCells.Add(InCellIndex);
+}
+
+void FMinesweeperMaskSolver::QueueAffected(const int32 InCellIndex)
+{
+	const int32 cornerIndex = InCellIndex - (Width * WindowRadius) - WindowRadius;
+
+	for (uint64 opened = GetWindow(OpenedRows, InCellIndex) & NeighborMask(0, 0); opened != 0; opened &= opened - 1)
+	{
+		const int32 bit = (int32)FMath::CountTrailingZeros64(opened);
+		Queue(cornerIndex + ((bit / WindowSize) * Width) + (bit % WindowSize));
+	}
+}
+
+
+bool FMinesweeperMaskSolver::ApplySinglePoint(const int32 InCellIndex)
+{
+	const uint64 neighbors = NeighborMask(0, 0);
+	const uint64 unknowns = GetWindow(UnknownRows, InCellIndex) & neighbors;
+	if (unknowns == 0) return false;
+
+	const int32 missingMines = Numbers[InCellIndex] - FMath::CountBits(GetWindow(MineRows, InCellIndex) & neighbors);
+	if (missingMines == 0) return ResolveWindow(InCellIndex, unknowns, false);
+	if (missingMines == FMath::CountBits(unknowns)) return ResolveWindow(InCellIndex, unknowns, true);
+	return false;
+}
+
+bool FMinesweeperMaskSolver::ApplyPairs(const int32 InCellIndex)
+{
+	const uint64 unknownWindow = GetWindow(UnknownRows, InCellIndex);
+	const uint64 mineWindow = GetWindow(MineRows, InCellIndex);
+
+	const uint64 unknownsA = unknownWindow & NeighborMask(0, 0);
+	if (unknownsA == 0) return false;
+	const int32 missingMinesA = Numbers[InCellIndex] - FMath::CountBits(mineWindow & NeighborMask(0, 0));
+
+	// numbers sharing an unknown neighbor are at most two cells apart
+	uint64 candidates = 0;
+	for (int32 y = -2; y <= 2; ++y)
+	{
+		candidates |= 0x1Full << WindowBit(-2, y);
+	}
+	candidates &= GetWindow(OpenedRows, InCellIndex) & ~(1ull << WindowBit(0, 0));
+
+	const int32 cellX = InCellIndex % Width;
+	const int32 cellY = InCellIndex / Width;
+
+	for (; candidates != 0; candidates &= candidates - 1)
+	{
+		const int32 bit = (int32)FMath::CountTrailingZeros64(candidates);
+		const int32 offsetX = (bit % WindowSize) - WindowRadius;
+		const int32 offsetY = (bit / WindowSize) - WindowRadius;
+		const int32 cellIndexB = ((cellY + offsetY) * Width) + cellX + offsetX;
+
+		const uint64 neighborsB = NeighborMask(offsetX, offsetY);
+		const uint64 unknownsB = unknownWindow & neighborsB;
+
+		const uint64 shared = unknownsA & unknownsB;
+		if (shared == 0) continue;
+
+		const uint64 onlyA = unknownsA & ~unknownsB;
+		const uint64 onlyB = unknownsB & ~unknownsA;
+		if (onlyA == 0 && onlyB == 0) continue;
+
+		const int32 missingMinesB = Numbers[cellIndexB] - FMath::CountBits(mineWindow & neighborsB);
+		const int32 numOnlyA = FMath::CountBits(onlyA);
+		const int32 numOnlyB = FMath::CountBits(onlyB);
+
+		// the shared cells hold as many mines as both numbers allow, whatever is left over falls to the cells only one number sees
+		const int32 minShared = FMath::Max3(missingMinesA - numOnlyA, missingMinesB - numOnlyB, 0);
+		const int32 maxShared = FMath::Min3(missingMinesA, missingMinesB, FMath::CountBits(shared));
+		if (minShared > maxShared) continue;
+
+		bool bProgress = false;
+		if (numOnlyA > 0 && missingMinesA - maxShared == numOnlyA) bProgress |= ResolveWindow(InCellIndex, onlyA, true);
+		else if (numOnlyA > 0 && missingMinesA - minShared == 0) bProgress |= ResolveWindow(InCellIndex, onlyA, false);
+
+		if (numOnlyB > 0 && missingMinesB - maxShared == numOnlyB) bProgress |= ResolveWindow(InCellIndex, onlyB, true);
+		else if (numOnlyB > 0 && missingMinesB - minShared == 0) bProgress |= ResolveWindow(InCellIndex, onlyB, false);
+
+		if (bProgress)
+		{
+			// the windows are stale now, the remaining pairs are tried when this number comes back around
+			Queue(InCellIndex);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FMinesweeperMaskSolver::ApplyGlobal()
+{
+	if (NumUnknown == 0) return false;
+
+	const int32 minesRemaining = MineCount - KnownMines.Num();
+	if (minesRemaining != 0 && minesRemaining != NumUnknown) return false;
+
+	// walks the unknown bits row by row, collecting first since resolving clears them
+	TArray<int32, TInlineAllocator<64>> unknownCells;
+	for (int32 y = 0; y < Height; ++y)
+	{
+		const uint64* row = UnknownRows.GetData() + ((y + WindowRadius) * RowWords);
+		for (int32 word = 0; word < RowWords; ++word)
+		{
+			for (uint64 bits = row[word]; bits != 0; bits &= bits - 1)
+			{
+				const int32 x = (word * 64) + (int32)FMath::CountTrailingZeros64(bits) - WindowRadius;
+				unknownCells.Add((y * Width) + x);
+			}
+		}
+	}
+
+	for (const int32 cellIndex : unknownCells)
+	{
+		ResolveCell(cellIndex, minesRemaining > 0);
+	}
+	return unknownCells.Num() > 0;
+}
+
+
+
+
+void FMinesweeperMaskEnumerator::Init(const int32 InNumCells)
+{
+	check(InNumCells >= 0 && InNumCells <= MaxCells);
+	CellCount = InNumCells;
+
+	ConstraintMasks.Reset();
+	ConstraintMines.Reset();
+	CellConstraints.SetNumUninitialized(CellCount * 8);
+	NumCellConstraints.SetNumZeroed(CellCount);
+}
+
+void FMinesweeperMaskEnumerator::AddConstraint(const uint64 InCellMask, const int32 InMines)
+{
+	const int32 constraintIndex = ConstraintMasks.Add(InCellMask);
+	ConstraintMines.Add(InMines);
+
+	// a cell has 8 neighbors, so it is in at most 8 constraints
+	for (uint64 bits = InCellMask; bits != 0; bits &= bits - 1)
+	{
+		const int32 cell = (int32)FMath::CountTrailingZeros64(bits);
+		check(NumCellConstraints[cell] < 8);
+		CellConstraints[(cell * 8) + NumCellConstraints[cell]++] = constraintIndex;
+	}
+}
+
+bool FMinesweeperMaskEnumerator::Enumerate(const int32 InMaxMines, const int64 InMaxNodes, TArray<double>& OutSolutionCounts, TArray<double>& OutCellMineCounts, const TFunctionRef<bool()>* InShouldAbort)
+{
+	OutSolutionCounts.Init(0.0, CellCount + 1);
+	OutCellMineCounts.Init(0.0, CellCount * (CellCount + 1));
+
+	SolutionCounts = &OutSolutionCounts;
+	CellMineCounts = &OutCellMineCounts;
+	MaxMines = FMath::Min(InMaxMines, CellCount);
+	NodesLeft = InMaxNodes;
+	NodeCount = 0;
+	bAborted = false;
+	ShouldAbort = InShouldAbort;
+
+	bool bSolvable = MaxMines >= 0;
+	for (int32 constraintIndex = 0; constraintIndex < ConstraintMasks.Num() && bSolvable; ++constraintIndex)
+	{
+		bSolvable = ConstraintMines[constraintIndex] >= 0 && ConstraintMines[constraintIndex] <= FMath::CountBits(ConstraintMasks[constraintIndex]);
+	}
+
+	// constraints are taken in the order of their lowest cell, which follows the component outward from its first cell
+	ConstraintOrder.SetNumUninitialized(ConstraintMasks.Num());
+	for (int32 i = 0; i < ConstraintOrder.Num(); ++i)
+	{
+		ConstraintOrder[i] = i;
+	}
+	ConstraintOrder.Sort([this](const int32 InA, const int32 InB)
+		{
+			const uint64 lowestA = ConstraintMasks[InA] & (0ull - ConstraintMasks[InA]);
+			const uint64 lowestB = ConstraintMasks[InB] & (0ull - ConstraintMasks[InB]);
+			return lowestA != lowestB ? lowestA < lowestB : InA < InB;
+		});
+
+	// the constraints sharing a cell with each constraint, the only ones a branch on it can break
+	OverlapStarts.SetNumUninitialized(ConstraintMasks.Num() + 1);
+	Overlaps.Reset();
+	for (int32 constraintIndex = 0; constraintIndex < ConstraintMasks.Num(); ++constraintIndex)
+	{
+		OverlapStarts[constraintIndex] = Overlaps.Num();
+		for (uint64 bits = ConstraintMasks[constraintIndex]; bits != 0; bits &= bits - 1)
+		{
+			const int32 cell = (int32)FMath::CountTrailingZeros64(bits);
+			for (int32 i = 0; i < NumCellConstraints[cell]; ++i)
+			{
+				const int32 otherIndex = CellConstraints[(cell * 8) + i];
+
+				bool bListed = otherIndex == constraintIndex;
+				for (int32 j = OverlapStarts[constraintIndex]; j < Overlaps.Num() && !bListed; ++j)
+				{
+					bListed = Overlaps[j] == otherIndex;
+				}
+				if (!bListed)
+				{
+					Overlaps.Add(otherIndex);
+				}
+			}
+		}
+	}
+	OverlapStarts[ConstraintMasks.Num()] = Overlaps.Num();
+
+	if (bSolvable)
+	{
+		Search(0, 0, 0);
+	}
+
+	ShouldAbort = nullptr;
+	SolutionCounts = nullptr;
+	CellMineCounts = nullptr;
+
+	if (bAborted)
+	{
+		OutSolutionCounts.Reset();
+		OutCellMineCounts.Reset();
+		return false;
+	}
+	return true;
+}
+
+
+void FMinesweeperMaskEnumerator::Search(const int32 InOrderIndex, const uint64 InAssigned, const uint64 InMines)
+{
+	++NodeCount;
+	if (bAborted || --NodesLeft < 0 || (ShouldAbort && (NodesLeft % FMinesweeperProbabilityEngine::AbortCheckNodes) == 0 && (*ShouldAbort)()))
+	{
+		bAborted = true;
+		return;
+	}
+
+	// constraints before InOrderIndex are fully assigned
+	int32 orderIndex = InOrderIndex;
+	while (orderIndex < ConstraintOrder.Num() && (ConstraintMasks[ConstraintOrder[orderIndex]] & ~InAssigned) == 0)
+	{
+		++orderIndex;
+	}
+
+	// every cell of a component is in a constraint, so no constraint with free cells means every cell is assigned
+	if (orderIndex == ConstraintOrder.Num())
+	{
+		Record(InMines);
+		return;
+	}
+
+	const int32 bestConstraint = ConstraintOrder[orderIndex];
+	const uint64 freeCells = ConstraintMasks[bestConstraint] & ~InAssigned;
+	const int32 missingMines = ConstraintMines[bestConstraint] - FMath::CountBits(ConstraintMasks[bestConstraint] & InMines);
+	if (missingMines < 0 || missingMines > FMath::CountBits(freeCells) || FMath::CountBits(InMines) + missingMines > MaxMines) return;
+
+	int32 freePositions[8];
+	int32 numFree = 0;
+	for (uint64 bits = freeCells; bits != 0; bits &= bits - 1)
+	{
+		freePositions[numFree++] = (int32)FMath::CountTrailingZeros64(bits);
+	}
+
+	const uint64 assigned = InAssigned | freeCells;
+
+	// Gosper's hack steps through the numFree bit patterns with missingMines bits set, in increasing order
+	const uint32 endPattern = 1u << numFree;
+	for (uint32 pattern = (1u << missingMines) - 1; pattern < endPattern; )
+	{
+		uint64 placedMines = 0;
+		for (uint32 bits = pattern; bits != 0; bits &= bits - 1)
+		{
+			placedMines |= 1ull << freePositions[FMath::CountTrailingZeros(bits)];
+		}
+
+		const uint64 mines = InMines | placedMines;
+		if (IsConsistent(bestConstraint, assigned, mines))
+		{
+			Search(orderIndex + 1, assigned, mines);
+		}
+
+		if (pattern == 0) break;
+		const uint32 lowestBit = pattern & (0u - pattern);
+		const uint32 ripple = pattern + lowestBit;
+		pattern = (((ripple ^ pattern) >> 2) / lowestBit) | ripple;
+	}
+}
+
+bool FMinesweeperMaskEnumerator::IsConsistent(const int32 InConstraintIndex, const uint64 InAssigned, const uint64 InMines) const
+{
+	for (int32 i = OverlapStarts[InConstraintIndex]; i < OverlapStarts[InConstraintIndex + 1]; ++i)
+	{
+		const int32 constraintIndex = Overlaps[i];
+		const uint64 mask = ConstraintMasks[constraintIndex];
+
+		const int32 mines = FMath::CountBits(mask & InMines);
+		if (mines > ConstraintMines[constraintIndex] || mines + FMath::CountBits(mask & ~InAssigned) < ConstraintMines[constraintIndex]) return false;
+	}
+	return true;
+}
+
+void FMinesweeperMaskEnumerator::Record(const uint64 InMines)
+{
+	const int32 numMines = FMath::CountBits(InMines);
+	(*SolutionCounts)[numMines] += 1.0;
+	for (uint64 bits = InMines; bits != 0; bits &= bits - 1)
+	{
+		(*CellMineCounts)[((int32)FMath::CountTrailingZeros64(bits) * (CellCount + 1)) + numMines] += 1.0;
+	}
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
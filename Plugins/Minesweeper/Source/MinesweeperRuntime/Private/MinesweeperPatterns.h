@@ -0,0 +1,95 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+
+/**
+ * Forced deductions of every line pattern, generated at compile time. A line pattern is a run of three opened numbers along a row or
+ * column whose unknown neighbors all lie in the five cells alongside the run:
+ *
+ *     c0 c1 c2 c3 c4
+ *        n0 n1 n2
+ *
+ * Number ni sees cells ci, ci+1 and ci+2. Cells off the board or already known are simply not unknown, which covers walls. Longer
+ * patterns such as 1-2-2-1 resolve by looking up overlapping runs in turn as each lookup settles cells for the next.
+ *
+ * Keys hold the unknown mask of the five cells in bits 0-4 and the mines each number still misses, at most 3, in two bits each from
+ * bit 5. Entries hold the cells that are safe in every solution in bits 0-4 and the cells that are mines in every solution in bits 5-9.
+ * Keys without a solution map to 0 like keys without a deduction.
+ */
+namespace MinesweeperPatterns
+{
+	static constexpr int32 NumRunNumbers = 3;
+	static constexpr int32 NumRunCells = NumRunNumbers + 2;
+	static constexpr uint32 CellMask = (1u << NumRunCells) - 1;
+	static constexpr int32 NumKeys = 1 << (NumRunCells + (NumRunNumbers * 2));
+
+	FORCEINLINE constexpr uint32 MakeKey(const uint32 InUnknownMask, const uint32 InMissingMines0, const uint32 InMissingMines1, const uint32 InMissingMines2)
+	{
+		return InUnknownMask | (InMissingMines0 << NumRunCells) | (InMissingMines1 << (NumRunCells + 2)) | (InMissingMines2 << (NumRunCells + 4));
+	}
+
+	FORCEINLINE constexpr uint32 GetSafeCells(const uint16 InEntry) { return InEntry & CellMask; }
+	FORCEINLINE constexpr uint32 GetMineCells(const uint16 InEntry) { return (InEntry >> NumRunCells) & CellMask; }
+
+
+	struct FPatternTable
+	{
+		uint16 Entries[NumKeys];
+
+		/**
+		 * Walks every mine assignment of every unknown mask once, 3^5 pairs in all, and files it under the key it satisfies. Cheap
+		 * enough for any compiler's constant evaluation limits, unlike solving each of the 2048 keys on its own.
+		 */
+		constexpr FPatternTable()
+			: Entries()
+		{
+			uint32 canBeMine[NumKeys] = {};
+			uint32 canBeSafe[NumKeys] = {};
+			bool hasSolution[NumKeys] = {};
+
+			for (uint32 unknownMask = 0; unknownMask <= CellMask; ++unknownMask)
+			{
+				// every subset of the unknown mask, down to the empty one
+				for (uint32 mines = unknownMask; ; mines = (mines - 1) & unknownMask)
+				{
+					uint32 missingMines[NumRunNumbers] = {};
+					for (int32 number = 0; number < NumRunNumbers; ++number)
+					{
+						for (int32 cell = number; cell < number + 3; ++cell)
+						{
+							missingMines[number] += (mines >> cell) & 1;
+						}
+					}
+
+					const uint32 key = MakeKey(unknownMask, missingMines[0], missingMines[1], missingMines[2]);
+					canBeMine[key] |= mines;
+					canBeSafe[key] |= unknownMask & ~mines;
+					hasSolution[key] = true;
+
+					if (mines == 0) break;
+				}
+			}
+
+			for (int32 key = 0; key < NumKeys; ++key)
+			{
+				const uint32 unknownMask = key & CellMask;
+				Entries[key] = hasSolution[key] ? (uint16)((unknownMask & ~canBeMine[key]) | ((unknownMask & ~canBeSafe[key]) << NumRunCells)) : 0;
+			}
+		}
+
+		FORCEINLINE constexpr uint16 operator[](const uint32 InKey) const { return Entries[InKey]; }
+	};
+
+	inline constexpr FPatternTable PatternTable;
+
+
+	// 1-2-1: the cells over the ones are mines, the rest are safe
+	static_assert(PatternTable[MakeKey(0x1F, 1, 2, 1)] == (0x15 | (0x0A << NumRunCells)), "1-2-1 must resolve every cell");
+
+	// 1-1 against a wall, with the first cell off the board: the cell past the second number is safe
+	static_assert(GetSafeCells(PatternTable[MakeKey(0x1E, 1, 1, 1)]) == 0x08, "1-1 along a wall must clear the cell past it");
+}
@@ -0,0 +1,1020 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperProbability.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperComponentCache.h"
+#include "MinesweeperMaskSolver.h"
+#include "Algo/BinarySearch.h"
+#include "Async/ParallelFor.h"
+#include "Async/TaskGraphInterfaces.h"
+#include <atomic>
+#include <cmath>
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+namespace MinesweeperProbabilityPrivate
+{
+	int32 FindRoot(TArray<int32>& InOutParents, int32 InIndex)
+	{
+		while (InOutParents[InIndex] != InIndex)
+		{
+			InOutParents[InIndex] = InOutParents[InOutParents[InIndex]]; // path halving
+			InIndex = InOutParents[InIndex];
+		}
+		return InIndex;
+	}
+
+	/** Polynomial product of two solution count tables indexed by mine count. */
+	void Convolve(const TArray<double>& InA, const TArray<double>& InB, TArray<double>& OutResult)
+	{
+		OutResult.Init(0.0, InA.Num() + InB.Num() - 1);
+		for (int32 a = 0; a < InA.Num(); ++a)
+		{
+			if (InA[a] == 0.0) continue;
+			for (int32 b = 0; b < InB.Num(); ++b)
+			{
+				OutResult[a + b] += InA[a] * InB[b];
+			}
+		}
+	}
+
+	/** Divides the values by their largest and returns the log of the divisor. */
+	double Normalize(TArray<double>& InOutValues)
+	{
+		double maxValue = 0.0;
+		for (const double value : InOutValues)
+		{
+			maxValue = FMath::Max(maxValue, value);
+		}
+		if (maxValue <= 0.0) return 0.0;
+
+		for (double& value : InOutValues)
+		{
+			value /= maxValue;
+		}
+		return FMath::Loge(maxValue);
+	}
+
+	/** ln C(InNum, InChosen) */
+	double LogBinomial(const int64 InNum, const int64 InChosen)
+	{
+		return std::lgamma((double)InNum + 1.0) - std::lgamma((double)InChosen + 1.0) - std::lgamma((double)(InNum - InChosen) + 1.0);
+	}
+
+	/**
+	 * Ways to place the remaining mines on the interior cells when the frontier holds k of them, C(InNumInteriorCells, InRemainingMines - k)
+	 * for every k in [0, InMaxFrontierMines], divided by InMineOdds^k and then by the largest of them. Only ratios matter, so the weights
+	 * are built in log space from the ratio of neighboring binomials and never overflow however many interior cells there are.
+	 * Returns the log of what the weights were divided by, so absolute counts can be recovered.
+	 */
+	double ComputeInteriorWeights(const int64 InNumInteriorCells, const int32 InRemainingMines, const int32 InMaxFrontierMines, const double InLogMineOdds, TArray<double>& OutWeights)
+	{
+		OutWeights.Init(0.0, InMaxFrontierMines + 1);
+
+		// the interior cannot hold more mines than cells, so the frontier holds at least the rest
+		const int32 minFrontierMines = (int32)FMath::Max<int64>(InRemainingMines - InNumInteriorCells, 0);
+		if (minFrontierMines > InMaxFrontierMines) return 0.0;
+
+		// ln C(n, m - 1) - ln C(n, m) = ln(m / (n - m + 1)), which stays close to the log odds so the tilted weights change slowly
+		TArray<double> logWeights;
+		logWeights.SetNumUninitialized(InMaxFrontierMines + 1);
+		logWeights[minFrontierMines] = 0.0;
+		double maxLogWeight = 0.0;
+		for (int32 k = minFrontierMines + 1; k <= InMaxFrontierMines; ++k)
+		{
+			const int64 interiorMines = InRemainingMines - (k - 1);
+			logWeights[k] = logWeights[k - 1] + FMath::Loge((double)interiorMines / (double)(InNumInteriorCells - interiorMines + 1)) - InLogMineOdds;
+			maxLogWeight = FMath::Max(maxLogWeight, logWeights[k]);
+		}
+
+		for (int32 k = minFrontierMines; k <= InMaxFrontierMines; ++k)
+		{
+			OutWeights[k] = FMath::Exp(logWeights[k] - maxLogWeight);
+		}
+
+		// weight k was C(interior, rest - k) / C(interior, rest - min) / odds^(k - min), the components carry odds^k themselves
+		return LogBinomial(InNumInteriorCells, InRemainingMines - minFrontierMines) + maxLogWeight - (minFrontierMines * InLogMineOdds);
+	}
+
+	/** Depth first search state of one component. */
+	struct FEnumeration
+	{
+		const TArray<int32>* CellConstraints = nullptr;
+		const TArray<uint8>* NumCellConstraints = nullptr;
+		TArray<double>* SolutionCounts = nullptr;
+		TArray<double>* CellMineCounts = nullptr;
+
+		TArray<int32> ConstraintMines;
+		TArray<int32> ConstraintUnassigned;
+		TArray<int32> ConstraintTargets;
+		TArray<int32> MineCells;
+
+		/** Value assigned to each cell on the current probe path. */
+		TArray<uint8> Assignments;
+
+		int32 NumCells = 0;
+		int32 MaxMines = 0;
+
+		/** Search nodes left before the search gives up. */
+		int64 NodesLeft = MAX_int64;
+		bool bAborted = false;
+
+		/** Polled every AbortCheckNodes search nodes, the search gives up once it returns true. */
+		const TFunctionRef<bool()>* ShouldAbort = nullptr;
+
+		template <typename ComponentType>
+		void Setup(const ComponentType& InComponent, const int32 InMaxMines)
+		{
+			CellConstraints = &InComponent.CellConstraints;
+			NumCellConstraints = &InComponent.NumCellConstraints;
+			NumCells = InComponent.Cells.Num();
+			MaxMines = InMaxMines;
+
+			const int32 numConstraints = InComponent.Constraints.Num();
+			ConstraintMines.Init(0, numConstraints);
+			ConstraintUnassigned.SetNumUninitialized(numConstraints);
+			ConstraintTargets.SetNumUninitialized(numConstraints);
+			for (int32 i = 0; i < numConstraints; ++i)
+			{
+				ConstraintUnassigned[i] = InComponent.Constraints[i].NumCells;
+				ConstraintTargets[i] = InComponent.Constraints[i].RemainingMines;
+			}
+
+			Assignments.SetNumZeroed(NumCells);
+			MineCells.Reset();
+			MineCells.Reserve(NumCells);
+		}
+
+		/** Adds a solution with the cells in MineCells holding mines to the counts. */
+		void Record(const double InWeight)
+		{
+			const int32 numMines = MineCells.Num();
+			(*SolutionCounts)[numMines] += InWeight;
+			for (const int32 mineCell : MineCells)
+			{
+				(*CellMineCounts)[(mineCell * (NumCells + 1)) + numMines] += InWeight;
+			}
+		}
+
+		/** Assigns a cell and returns false if a constraint can no longer be met. Always fully applied so it can be undone. */
+		bool Assign(const int32 InCell, const int32 InMine)
+		{
+			bool bValid = true;
+			for (int32 i = 0; i < (*NumCellConstraints)[InCell]; ++i)
+			{
+				const int32 constraintIndex = (*CellConstraints)[(InCell * 8) + i];
+				ConstraintMines[constraintIndex] += InMine;
+				--ConstraintUnassigned[constraintIndex];
+
+				const int32 mines = ConstraintMines[constraintIndex];
+				bValid &= mines <= ConstraintTargets[constraintIndex] && mines + ConstraintUnassigned[constraintIndex] >= ConstraintTargets[constraintIndex];
+			}
+			return bValid;
+		}
+
+		void Unassign(const int32 InCell, const int32 InMine)
+		{
+			for (int32 i = 0; i < (*NumCellConstraints)[InCell]; ++i)
+			{
+				const int32 constraintIndex = (*CellConstraints)[(InCell * 8) + i];
+				ConstraintMines[constraintIndex] -= InMine;
+				++ConstraintUnassigned[constraintIndex];
+			}
+		}
+
+		void Search(const int32 InCell)
+		{
+			if (bAborted || --NodesLeft < 0 || (ShouldAbort && (NodesLeft % FMinesweeperProbabilityEngine::AbortCheckNodes) == 0 && (*ShouldAbort)()))
+			{
+				bAborted = true;
+				return;
+			}
+
+			if (InCell == NumCells)
+			{
+				Record(1.0);
+				return;
+			}
+
+			if (Assign(InCell, 0))
+			{
+				Search(InCell + 1);
+			}
+			Unassign(InCell, 0);
+
+			if (MineCells.Num() < MaxMines)
+			{
+				MineCells.Add(InCell);
+				if (Assign(InCell, 1))
+				{
+					Search(InCell + 1);
+				}
+				Unassign(InCell, 1);
+				MineCells.Pop(false);
+			}
+		}
+
+		/**
+		 * Walks one random path down the search tree, taking a random branch wherever both are viable. Returns false at a dead end.
+		 * OutLogWeight is the log of the product of viable branch counts along the path. The path stays applied until UndoProbe().
+		 */
+		bool Probe(FMinesweeperRandomStream& InOutRandStream, double& OutLogWeight, int32& OutDepth)
+		{
+			static const double logTwo = FMath::Loge(2.0);
+
+			OutLogWeight = 0.0;
+			for (OutDepth = 0; OutDepth < NumCells; ++OutDepth)
+			{
+				const int32 cell = OutDepth;
+
+				const bool bCanBeSafe = Assign(cell, 0);
+				Unassign(cell, 0);
+
+				bool bCanBeMine = false;
+				if (MineCells.Num() < MaxMines)
+				{
+					bCanBeMine = Assign(cell, 1);
+					Unassign(cell, 1);
+				}
+
+				if (!bCanBeSafe && !bCanBeMine) return false;
+
+				uint8 mine = bCanBeMine ? 1 : 0;
+				if (bCanBeSafe && bCanBeMine)
+				{
+					OutLogWeight += logTwo;
+					mine = (uint8)InOutRandStream.NextBounded(2);
+				}
+
+				Assign(cell, mine);
+				Assignments[cell] = mine;
+				if (mine) MineCells.Add(cell);
+			}
+			return true;
+		}
+
+		void UndoProbe(const int32 InDepth)
+		{
+			for (int32 cell = InDepth - 1; cell >= 0; --cell)
+			{
+				Unassign(cell, Assignments[cell]);
+			}
+			MineCells.Reset();
+		}
+	};
+}
+
+
+
+
+void FMinesweeperProbabilityEngine::Reset()
+{
+	Probabilities.Reset();
+	Errors.Reset();
+	InteriorProbability = 0.0f;
+	bHasProbabilities = false;
+	bIsExact = false;
+	EstimateResult = FMinesweeperProbabilityResult();
+	TrackedProbabilities.Reset();
+	ChangedCells.Init(0);
+}
+
+
+void FMinesweeperProbabilityEngine::ClearChangedCells()
+{
+	ChangedCells.Reset();
+}
+
+
+void FMinesweeperProbabilityEngine::TrackProbability(const int32 InCellIndex, const float InProbability)
+{
+	Probabilities[InCellIndex] = InProbability;
+
+	// small moves are left out so anytime refinement does not report the whole frontier on every call
+	float& trackedProbability = TrackedProbabilities[InCellIndex];
+	if (trackedProbability < 0.0f || FMath::Abs(InProbability - trackedProbability) > ProbabilityChangeTolerance)
+	{
+		trackedProbability = InProbability;
+		ChangedCells.Add(InCellIndex);
+	}
+}
+
+
+FMinesweeperProbabilityResult FMinesweeperProbabilityEngine::Compute(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const int32 InNumWorkers)
+{
+	return Compute(InFrontier, InMineCount, InNumWorkers, []() { return false; });
+}
+
+FMinesweeperProbabilityResult FMinesweeperProbabilityEngine::Compute(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const int32 InNumWorkers, TFunctionRef<bool()> InShouldAbort,
+	const int64 InMaxNodes)
+{
+	const double startTime = FPlatformTime::Seconds();
+
+	FMinesweeperProbabilityResult result;
+	bHasProbabilities = false;
+
+	if (Decompose(InFrontier, InMineCount, result))
+	{
+		// one aborted component makes the whole position worthless, the others stop at their next check
+		std::atomic<bool> bAborted { false };
+
+		// each component may take whatever the components before it left of the node limit
+		std::atomic<int64> nodesLeft { InMaxNodes };
+		std::atomic<int64> numNodes { 0 };
+
+		const int32 numWorkers = InNumWorkers > 0 ? InNumWorkers : FMath::Max(FTaskGraphInterface::Get().GetNumWorkerThreads(), 1);
+		ParallelFor(Components.Num(), [&](const int32 InComponentIndex)
+			{
+				FComponent& component = Components[InComponentIndex];
+				if (bAborted.load(std::memory_order_relaxed)) return;
+
+				const bool bEnumerated = EnumerateCached(component, RemainingMines, FMath::Max(nodesLeft.load(std::memory_order_relaxed), (int64)0), &InShouldAbort);
+				nodesLeft -= component.NumNodes;
+				numNodes += component.NumNodes;
+				if (!bEnumerated)
+				{
+					bAborted = true;
+					return;
+				}
+				component.State = EComponentState::Exact;
+				FinalizeCounts(component, LogMineOdds);
+			}, numWorkers == 1);
+
+		result.bAborted = bAborted;
+		result.NumNodes = numNodes;
+		if (!result.bAborted)
+		{
+			Combine(InFrontier, result);
+		}
+	}
+
+	result.Seconds = FPlatformTime::Seconds() - startTime;
+	return result;
+}
+
+
+FMinesweeperProbabilityResult FMinesweeperProbabilityEngine::BeginEstimate(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const double InBudgetSeconds, const int32 InSeed)
+{
+	const double startTime = FPlatformTime::Seconds();
+
+	bHasProbabilities = false;
+	RandStream = FMinesweeperRandomStream((uint32)InSeed);
+
+	EstimateResult = FMinesweeperProbabilityResult();
+	EstimateResult.bSuccess = Decompose(InFrontier, InMineCount, EstimateResult);
+
+	return RunEstimate(InFrontier, startTime, InBudgetSeconds);
+}
+
+FMinesweeperProbabilityResult FMinesweeperProbabilityEngine::RefineEstimate(const FMinesweeperFrontier& InFrontier, const double InBudgetSeconds)
+{
+	return RunEstimate(InFrontier, FPlatformTime::Seconds(), InBudgetSeconds);
+}
+
+FMinesweeperProbabilityResult FMinesweeperProbabilityEngine::RunEstimate(const FMinesweeperFrontier& InFrontier, const double InStartTime, const double InBudgetSeconds)
+{
+	FMinesweeperProbabilityResult result = EstimateResult;
+	result.bSuccess = false;
+	if (!EstimateResult.bSuccess || (bHasProbabilities && bIsExact))
+	{
+		result.bSuccess = EstimateResult.bSuccess;
+		result.bExact = bIsExact;
+		result.Seconds = FPlatformTime::Seconds() - InStartTime;
+		return result;
+	}
+
+	// always makes progress, even when the budget was spent before the call
+	const double deadline = InStartTime + InBudgetSeconds;
+	bool bDidWork = false;
+
+	// smallest components first, they are the most likely to finish within the node limit
+	for (int32 i = Components.Num() - 1; i >= 0; --i)
+	{
+		FComponent& component = Components[i];
+		if (component.State != EComponentState::Pending) continue;
+		if (bDidWork && FPlatformTime::Seconds() >= deadline) break;
+
+		if (EnumerateCached(component, RemainingMines, AnytimeExactNodeLimit))
+		{
+			component.State = EComponentState::Exact;
+			FinalizeCounts(component, LogMineOdds);
+		}
+		else
+		{
+			component.State = EComponentState::Sampled;
+		}
+		bDidWork = true;
+	}
+
+	bool bAllVisited = true;
+	for (const FComponent& component : Components)
+	{
+		bAllVisited &= component.State != EComponentState::Pending;
+	}
+
+	// the least certain sampled component gets the next batch of probes
+	while (bAllVisited)
+	{
+		if (bDidWork && FPlatformTime::Seconds() >= deadline) break;
+
+		FComponent* leastCertain = nullptr;
+		for (FComponent& component : Components)
+		{
+			if (component.State == EComponentState::Sampled && (!leastCertain || component.GetEffectiveSamples() < leastCertain->GetEffectiveSamples()))
+			{
+				leastCertain = &component;
+			}
+		}
+		if (!leastCertain) break;
+
+		Sample(*leastCertain, RemainingMines, AnytimeProbeBatchSize, RandStream);
+		bDidWork = true;
+	}
+
+	bool bReady = bAllVisited;
+	for (FComponent& component : Components)
+	{
+		if (component.State != EComponentState::Sampled) continue;
+
+		++result.NumSampledComponents;
+		result.NumProbes += component.NumProbes;
+		bReady &= component.SumWeights > 0.0;
+		if (component.SumWeights > 0.0)
+		{
+			FinalizeCounts(component, LogMineOdds);
+		}
+	}
+
+	if (bReady)
+	{
+		Combine(InFrontier, result);
+	}
+
+	result.Seconds = FPlatformTime::Seconds() - InStartTime;
+	return result;
+}
+
+
+bool FMinesweeperProbabilityEngine::Decompose(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, FMinesweeperProbabilityResult& OutResult)
+{
+	using namespace MinesweeperProbabilityPrivate;
+
+	FMinesweeperProbabilityResult& result = OutResult;
+
+	const int32 totalCellCount = InFrontier.Num();
+	const int32 remainingMines = InMineCount - InFrontier.NumFlaggedCells();
+	const int32 closedCellCount = totalCellCount - InFrontier.NumOpenedCells() - InFrontier.NumFlaggedCells();
+	if (remainingMines < 0 || remainingMines > closedCellCount) return false;
+
+	// sorted so results do not depend on the order cells entered the frontier
+	const TArrayView<const int32> closedCells = InFrontier.GetClosedCells().GetCells();
+	FrontierCells.Reset();
+	FrontierCells.Append(closedCells.GetData(), closedCells.Num());
+	FrontierCells.Sort();
+
+	const int32 numFrontierCells = FrontierCells.Num();
+	result.NumFrontierCells = numFrontierCells;
+	result.NumInteriorCells = closedCellCount - numFrontierCells;
+
+	CellComponents.Init(INDEX_NONE, totalCellCount);
+	CellPositions.SetNumUninitialized(totalCellCount);
+	for (int32 i = 0; i < numFrontierCells; ++i)
+	{
+		CellPositions[FrontierCells[i]] = i;
+	}
+
+	// frontier cells that share a number belong to the same component
+	Parents.SetNumUninitialized(numFrontierCells);
+	for (int32 i = 0; i < numFrontierCells; ++i)
+	{
+		Parents[i] = i;
+	}
+
+	for (const int32 numberIndex : InFrontier.GetActiveNumbers().GetCells())
+	{
+		int32 firstRoot = INDEX_NONE;
+		InFrontier.ForEachNeighbor(numberIndex, [&](const int32 InNeighborIndex)
+			{
+				if (!InFrontier.GetClosedCells().Contains(InNeighborIndex)) return;
+
+				const int32 root = FindRoot(Parents, CellPositions[InNeighborIndex]);
+				if (firstRoot == INDEX_NONE)
+				{
+					firstRoot = root;
+				}
+				else if (root != firstRoot)
+				{
+					// the lower position stays the root
+					const int32 newRoot = FMath::Min(root, firstRoot);
+					Parents[FMath::Max(root, firstRoot)] = newRoot;
+					firstRoot = newRoot;
+				}
+			});
+	}
+
+	int32 numComponents = 0;
+	for (int32 i = 0; i < numFrontierCells; ++i)
+	{
+		const int32 root = FindRoot(Parents, i);
+		if (root == i)
+		{
+			CellComponents[FrontierCells[i]] = numComponents++;
+		}
+		else
+		{
+			CellComponents[FrontierCells[i]] = CellComponents[FrontierCells[root]];
+		}
+	}
+
+	Components.SetNum(numComponents);
+	for (FComponent& component : Components)
+	{
+		component.State = EComponentState::Pending;
+		component.Hash = 0;
+		component.Cells.Reset();
+		component.Constraints.Reset();
+		component.NumProbes = 0;
+		component.SumWeights = 0.0;
+		component.SumSquaredWeights = 0.0;
+		component.ReferenceLogWeight = 0.0;
+	}
+
+	// frontier cells are sorted, so the first cell of each component is its lowest
+	for (const int32 cellIndex : FrontierCells)
+	{
+		FComponent& component = Components[CellComponents[cellIndex]];
+		CellPositions[cellIndex] = component.Cells.Add(cellIndex);
+		component.BaseCell = component.Cells[0];
+	}
+
+	for (const int32 numberIndex : InFrontier.GetActiveNumbers().GetCells())
+	{
+		FConstraint constraint;
+		constraint.RemainingMines = InFrontier.GetRemainingMines(numberIndex);
+
+		int32 componentIndex = INDEX_NONE;
+		InFrontier.ForEachNeighbor(numberIndex, [&](const int32 InNeighborIndex)
+			{
+				if (!InFrontier.GetClosedCells().Contains(InNeighborIndex)) return;
+
+				componentIndex = CellComponents[InNeighborIndex];
+				constraint.Cells[constraint.NumCells++] = CellPositions[InNeighborIndex];
+			});
+
+		// a wrong flag can leave a number that no layout satisfies
+		if (constraint.RemainingMines < 0 || constraint.RemainingMines > constraint.NumCells) return false;
+
+		// the hash is rebuilt from scratch here, not kept up to date by the frontier: keys are offsets from the lowest cell, which moves
+		// whenever components merge or split. It costs one pass over the constraints, which are built here anyway.
+		// Constraint keys are added, so the hash does not depend on the order numbers are visited.
+		FComponent& component = Components[componentIndex];
+		uint64 cellsKey = 0;
+		for (int32 i = 0; i < constraint.NumCells; ++i)
+		{
+			cellsKey += MinesweeperRandom::Mix64((uint64)(component.Cells[constraint.Cells[i]] - component.BaseCell));
+		}
+		component.Hash += MinesweeperRandom::CombineKey(cellsKey, (uint64)constraint.RemainingMines);
+
+		component.Constraints.Add(constraint);
+	}
+
+	result.NumComponents = numComponents;
+	for (const FComponent& component : Components)
+	{
+		result.LargestComponent = FMath::Max(result.LargestComponent, component.Cells.Num());
+	}
+
+	// largest components first so the longest enumerations start right away
+	Components.Sort([](const FComponent& InA, const FComponent& InB) { return InA.Cells.Num() > InB.Cells.Num(); });
+	for (FComponent& component : Components)
+	{
+		OrderCells(component);
+	}
+
+	// every frontier mine is weighed by the odds of an interior mine, so component counts and interior weights both stay near 1 however
+	// far apart their raw magnitudes are. The tilt cancels out in the products.
+	const double mineDensity = closedCellCount > 0 ? (double)remainingMines / (double)closedCellCount : 0.0;
+	LogMineOdds = mineDensity > 0.0 && mineDensity < 1.0 ? FMath::Loge(mineDensity / (1.0 - mineDensity)) : 0.0;
+	RemainingMines = remainingMines;
+	NumInteriorCells = result.NumInteriorCells;
+
+	return true;
+}
+
+
+bool FMinesweeperProbabilityEngine::Combine(const FMinesweeperFrontier& InFrontier, FMinesweeperProbabilityResult& OutResult)
+{
+	using namespace MinesweeperProbabilityPrivate;
+
+	const int32 totalCellCount = InFrontier.Num();
+	const int32 numComponents = Components.Num();
+	const int32 remainingMines = RemainingMines;
+
+	int32 numFrontierCells = 0;
+	for (const FComponent& component : Components)
+	{
+		numFrontierCells += component.Cells.Num();
+	}
+
+	// every component's solutions combine with every other's, the interior cells take the remaining mines in C(interior, rest) ways
+	const int32 maxFrontierMines = FMath::Min(numFrontierCells, remainingMines);
+	TArray<double> interiorWeights;
+	const double interiorLogScale = ComputeInteriorWeights(NumInteriorCells, remainingMines, maxFrontierMines, LogMineOdds, interiorWeights);
+
+	// prefix products hold the combined counts of the components before each component, suffix weights the weight of the components
+	// after it plus the interior for every number of mines already placed. Both are rescaled as they grow and carry their log scale.
+	TArray<TArray<double>> prefixCounts, suffixWeights;
+	TArray<double> prefixLogScales, suffixLogScales;
+	prefixCounts.SetNum(numComponents + 1);
+	suffixWeights.SetNum(numComponents + 1);
+	prefixLogScales.SetNumZeroed(numComponents + 1);
+	suffixLogScales.SetNumZeroed(numComponents + 1);
+
+	prefixCounts[0] = { 1.0 };
+	for (int32 i = 0; i < numComponents; ++i)
+	{
+		Convolve(prefixCounts[i], Components[i].SolutionCounts, prefixCounts[i + 1]);
+		prefixLogScales[i + 1] = prefixLogScales[i] + Normalize(prefixCounts[i + 1]);
+	}
+
+	suffixWeights[numComponents] = interiorWeights;
+	for (int32 i = numComponents - 1; i >= 0; --i)
+	{
+		const TArray<double>& solutionCounts = Components[i].SolutionCounts;
+		const TArray<double>& nextWeights = suffixWeights[i + 1];
+		suffixWeights[i].Init(0.0, maxFrontierMines + 1);
+		for (int32 placedMines = 0; placedMines <= maxFrontierMines; ++placedMines)
+		{
+			for (int32 k = 0; k < solutionCounts.Num() && placedMines + k <= maxFrontierMines; ++k)
+			{
+				suffixWeights[i][placedMines] += solutionCounts[k] * nextWeights[placedMines + k];
+			}
+		}
+		suffixLogScales[i] = suffixLogScales[i + 1] + Normalize(suffixWeights[i]);
+	}
+
+	const TArray<double>& totalCounts = prefixCounts[numComponents];
+	double totalWeight = 0.0;
+	double interiorMineWeight = 0.0;
+	for (int32 k = 0; k < totalCounts.Num() && k <= maxFrontierMines; ++k)
+	{
+		const double weight = totalCounts[k] * interiorWeights[k];
+		totalWeight += weight;
+		interiorMineWeight += weight * (remainingMines - k);
+	}
+	if (totalWeight <= 0.0) return false;
+
+	// undo every scaling on the way to the total weight, the interior scale takes the odds back out of the components
+	LogSolutionCount = FMath::Loge(totalWeight) + prefixLogScales[numComponents] + interiorLogScale;
+	for (const FComponent& component : Components)
+	{
+		LogSolutionCount += component.LogCountScale;
+	}
+
+	Probabilities.SetNumUninitialized(totalCellCount);
+	InteriorProbability = NumInteriorCells > 0 ? (float)(interiorMineWeight / totalWeight / NumInteriorCells) : 0.0f;
+
+	// estimates are as certain as their effective number of samples, the interior depends on every sampled component
+	bIsExact = true;
+	double minEffectiveSamples = TNumericLimits<double>::Max();
+	for (const FComponent& component : Components)
+	{
+		if (component.State == EComponentState::Sampled)
+		{
+			bIsExact = false;
+			minEffectiveSamples = FMath::Min(minEffectiveSamples, component.GetEffectiveSamples());
+		}
+	}
+
+	auto standardError = [](const double InProbability, const double InEffectiveSamples) -> float
+	{
+		return (float)FMath::Sqrt(FMath::Clamp(InProbability, 0.0, 1.0) * (1.0 - FMath::Clamp(InProbability, 0.0, 1.0)) / FMath::Max(InEffectiveSamples, 1.0));
+	};
+	const float interiorError = bIsExact ? 0.0f : standardError(InteriorProbability, minEffectiveSamples);
+
+	if (TrackedProbabilities.Num() != totalCellCount)
+	{
+		TrackedProbabilities.Init(-1.0f, totalCellCount);
+		ChangedCells.Init(totalCellCount);
+	}
+
+	// frontier cells are left to their components so every cell is compared against its tracked probability once
+	Errors.Init(0.0f, totalCellCount);
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (InFrontier.IsOpened(cellIndex)) TrackProbability(cellIndex, 0.0f);
+		else if (InFrontier.IsFlagged(cellIndex)) TrackProbability(cellIndex, 1.0f);
+		else if (CellComponents[cellIndex] == INDEX_NONE)
+		{
+			TrackProbability(cellIndex, InteriorProbability);
+			Errors[cellIndex] = interiorError;
+		}
+	}
+
+	const double totalLogScale = prefixLogScales[numComponents];
+	TArray<double> otherWeights;
+	for (int32 i = 0; i < numComponents; ++i)
+	{
+		const FComponent& component = Components[i];
+		const int32 numCells = component.Cells.Num();
+		const TArray<double>& before = prefixCounts[i];
+		const TArray<double>& after = suffixWeights[i + 1];
+
+		// weight of the rest of the board for each mine count of this component
+		otherWeights.Init(0.0, numCells + 1);
+		for (int32 k = 0; k <= numCells; ++k)
+		{
+			for (int32 j = 0; j < before.Num() && k + j <= maxFrontierMines; ++j)
+			{
+				otherWeights[k] += before[j] * after[k + j];
+			}
+		}
+
+		const double scale = FMath::Exp(prefixLogScales[i] + suffixLogScales[i + 1] - totalLogScale) / totalWeight;
+		for (int32 cell = 0; cell < numCells; ++cell)
+		{
+			double mineWeight = 0.0;
+			for (int32 k = 0; k <= numCells; ++k)
+			{
+				mineWeight += component.CellMineCounts[(cell * (numCells + 1)) + k] * otherWeights[k];
+			}
+			const double probability = FMath::Min(mineWeight * scale, 1.0);
+			TrackProbability(component.Cells[cell], (float)probability);
+			Errors[component.Cells[cell]] = component.State == EComponentState::Sampled ? standardError(probability, component.GetEffectiveSamples()) : 0.0f;
+		}
+	}
+
+	bHasProbabilities = true;
+	OutResult.bSuccess = true;
+	OutResult.bExact = bIsExact;
+	return true;
+}
+
+
+void FMinesweeperProbabilityEngine::OrderCells(FComponent& InOutComponent)
+{
+	const int32 numCells = InOutComponent.Cells.Num();
+
+	// constraints of each cell, in the original order
+	TArray<int32> cellConstraints;
+	TArray<uint8> numCellConstraints;
+	cellConstraints.SetNumUninitialized(numCells * 8);
+	numCellConstraints.SetNumZeroed(numCells);
+	for (int32 constraintIndex = 0; constraintIndex < InOutComponent.Constraints.Num(); ++constraintIndex)
+	{
+		const FConstraint& constraint = InOutComponent.Constraints[constraintIndex];
+		for (int32 i = 0; i < constraint.NumCells; ++i)
+		{
+			const int32 cell = constraint.Cells[i];
+			cellConstraints[(cell * 8) + numCellConstraints[cell]++] = constraintIndex;
+		}
+	}
+
+	// breadth first from the first cell, neighbors through shared constraints come next
+	TArray<int32> order;
+	TArray<int32> newPositions;
+	order.Reserve(numCells);
+	newPositions.Init(INDEX_NONE, numCells);
+
+	order.Add(0);
+	newPositions[0] = 0;
+	for (int32 head = 0; head < order.Num(); ++head)
+	{
+		const int32 cell = order[head];
+		for (int32 i = 0; i < numCellConstraints[cell]; ++i)
+		{
+			const FConstraint& constraint = InOutComponent.Constraints[cellConstraints[(cell * 8) + i]];
+			for (int32 j = 0; j < constraint.NumCells; ++j)
+			{
+				const int32 otherCell = constraint.Cells[j];
+				if (newPositions[otherCell] == INDEX_NONE)
+				{
+					newPositions[otherCell] = order.Add(otherCell);
+				}
+			}
+		}
+	}
+	check(order.Num() == numCells);
+
+	TArray<int32> orderedCells;
+	orderedCells.SetNumUninitialized(numCells);
+	for (int32 i = 0; i < numCells; ++i)
+	{
+		orderedCells[i] = InOutComponent.Cells[order[i]];
+	}
+	InOutComponent.Cells = MoveTemp(orderedCells);
+
+	InOutComponent.CellConstraints.SetNumUninitialized(numCells * 8);
+	InOutComponent.NumCellConstraints.SetNumZeroed(numCells);
+	for (int32 constraintIndex = 0; constraintIndex < InOutComponent.Constraints.Num(); ++constraintIndex)
+	{
+		FConstraint& constraint = InOutComponent.Constraints[constraintIndex];
+		for (int32 i = 0; i < constraint.NumCells; ++i)
+		{
+			const int32 cell = constraint.Cells[i] = newPositions[constraint.Cells[i]];
+			InOutComponent.CellConstraints[(cell * 8) + InOutComponent.NumCellConstraints[cell]++] = constraintIndex;
+		}
+	}
+}
+
+bool FMinesweeperProbabilityEngine::Enumerate(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort)
+{
+	using namespace MinesweeperProbabilityPrivate;
+
+	const int32 numCells = InOutComponent.Cells.Num();
+	InOutComponent.RawSolutionCounts.Init(0.0, numCells + 1);
+	InOutComponent.RawCellMineCounts.Init(0.0, numCells * (numCells + 1));
+
+	FEnumeration enumeration;
+	enumeration.Setup(InOutComponent, InMaxMines);
+	enumeration.SolutionCounts = &InOutComponent.RawSolutionCounts;
+	enumeration.CellMineCounts = &InOutComponent.RawCellMineCounts;
+	enumeration.NodesLeft = InMaxNodes;
+	enumeration.ShouldAbort = InShouldAbort;
+
+	enumeration.Search(0);
+	InOutComponent.NumNodes = InMaxNodes - FMath::Max(enumeration.NodesLeft, (int64)0);
+
+	if (enumeration.bAborted)
+	{
+		InOutComponent.RawSolutionCounts.Reset();
+		InOutComponent.RawCellMineCounts.Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FMinesweeperProbabilityEngine::EnumerateComponent(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort) const
+{
+	const int32 numCells = InOutComponent.Cells.Num();
+	if (!bUseMaskEnumeration || numCells > FMinesweeperMaskEnumerator::MaxCells) return Enumerate(InOutComponent, InMaxMines, InMaxNodes, InShouldAbort);
+
+	FMinesweeperMaskEnumerator maskEnumerator;
+	maskEnumerator.Init(numCells);
+	for (const FConstraint& constraint : InOutComponent.Constraints)
+	{
+		uint64 cellMask = 0;
+		for (int32 i = 0; i < constraint.NumCells; ++i)
+		{
+			cellMask |= 1ull << constraint.Cells[i];
+		}
+		maskEnumerator.AddConstraint(cellMask, constraint.RemainingMines);
+	}
+	const bool bEnumerated = maskEnumerator.Enumerate(InMaxMines, InMaxNodes, InOutComponent.RawSolutionCounts, InOutComponent.RawCellMineCounts, InShouldAbort);
+	InOutComponent.NumNodes = maskEnumerator.NumNodes();
+	return bEnumerated;
+}
+
+bool FMinesweeperProbabilityEngine::EnumerateCached(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort) const
+{
+	const int32 numCells = InOutComponent.Cells.Num();
+	if (!bUseComponentCache || numCells < MinCachedComponentCells) return EnumerateComponent(InOutComponent, InMaxMines, InMaxNodes, InShouldAbort);
+
+	FMinesweeperComponentCache& componentCache = FMinesweeperComponentCache::Get();
+	const int32 maxMines = FMath::Min(InMaxMines, numCells);
+
+	FMinesweeperComponentCacheEntry entry;
+	InOutComponent.NumNodes = 0;
+	if (componentCache.Find(InOutComponent.Hash, maxMines, entry) && entry.CellOffsets.Num() == numCells)
+	{
+		InOutComponent.RawSolutionCounts = MoveTemp(entry.SolutionCounts);
+		InOutComponent.RawCellMineCounts.SetNumUninitialized(numCells * (numCells + 1));
+
+		// the entry lists cells by offset, this component in search order
+		bool bCellsMatch = true;
+		for (int32 cell = 0; cell < numCells && bCellsMatch; ++cell)
+		{
+			const int32 entryCell = Algo::BinarySearch(entry.CellOffsets, InOutComponent.Cells[cell] - InOutComponent.BaseCell);
+			bCellsMatch = entryCell != INDEX_NONE;
+			if (bCellsMatch)
+			{
+				FMemory::Memcpy(&InOutComponent.RawCellMineCounts[cell * (numCells + 1)], &entry.CellMineCounts[entryCell * (numCells + 1)], (numCells + 1) * sizeof(double));
+			}
+		}
+
+		if (bCellsMatch)
+		{
+			// entries counted with more mines hold solutions this position does not allow
+			for (int32 k = maxMines + 1; k <= numCells; ++k)
+			{
+				InOutComponent.RawSolutionCounts[k] = 0.0;
+				for (int32 cell = 0; cell < numCells; ++cell)
+				{
+					InOutComponent.RawCellMineCounts[(cell * (numCells + 1)) + k] = 0.0;
+				}
+			}
+			return true;
+		}
+	}
+
+	if (!EnumerateComponent(InOutComponent, InMaxMines, InMaxNodes, InShouldAbort)) return false;
+
+	entry.MaxMines = maxMines;
+	entry.SolutionCounts = InOutComponent.RawSolutionCounts;
+	entry.CellOffsets.SetNumUninitialized(numCells);
+	entry.CellMineCounts.SetNumUninitialized(numCells * (numCells + 1));
+
+	TArray<int32> cellOrder;
+	cellOrder.SetNumUninitialized(numCells);
+	for (int32 cell = 0; cell < numCells; ++cell)
+	{
+		cellOrder[cell] = cell;
+	}
+	cellOrder.Sort([&](const int32 InA, const int32 InB) { return InOutComponent.Cells[InA] < InOutComponent.Cells[InB]; });
+
+	for (int32 entryCell = 0; entryCell < numCells; ++entryCell)
+	{
+		const int32 cell = cellOrder[entryCell];
+		entry.CellOffsets[entryCell] = InOutComponent.Cells[cell] - InOutComponent.BaseCell;
+		FMemory::Memcpy(&entry.CellMineCounts[entryCell * (numCells + 1)], &InOutComponent.RawCellMineCounts[cell * (numCells + 1)], (numCells + 1) * sizeof(double));
+	}
+
+	componentCache.Add(InOutComponent.Hash, MoveTemp(entry));
+	return true;
+}
+
+void FMinesweeperProbabilityEngine::Sample(FComponent& InOutComponent, const int32 InMaxMines, const int32 InNumProbes, FMinesweeperRandomStream& InOutRandStream)
+{
+	using namespace MinesweeperProbabilityPrivate;
+
+	const int32 numCells = InOutComponent.Cells.Num();
+	if (InOutComponent.NumProbes == 0)
+	{
+		InOutComponent.RawSolutionCounts.Init(0.0, numCells + 1);
+		InOutComponent.RawCellMineCounts.Init(0.0, numCells * (numCells + 1));
+	}
+
+	FEnumeration enumeration;
+	enumeration.Setup(InOutComponent, InMaxMines);
+	enumeration.SolutionCounts = &InOutComponent.RawSolutionCounts;
+	enumeration.CellMineCounts = &InOutComponent.RawCellMineCounts;
+
+	for (int32 probeIndex = 0; probeIndex < InNumProbes; ++probeIndex)
+	{
+		double logWeight = 0.0;
+		int32 depth = 0;
+		if (enumeration.Probe(InOutRandStream, logWeight, depth))
+		{
+			// weights are kept relative to the first solution found, absolute weights grow like 2^cells
+			if (InOutComponent.SumWeights <= 0.0)
+			{
+				InOutComponent.ReferenceLogWeight = logWeight;
+			}
+
+			const double weight = FMath::Exp(logWeight - InOutComponent.ReferenceLogWeight);
+			enumeration.Record(weight);
+			InOutComponent.SumWeights += weight;
+			InOutComponent.SumSquaredWeights += weight * weight;
+		}
+		enumeration.UndoProbe(depth);
+		++InOutComponent.NumProbes;
+	}
+}
+
+void FMinesweeperProbabilityEngine::FinalizeCounts(FComponent& InOutComponent, const double InLogMineOdds)
+{
+	const int32 numCells = InOutComponent.Cells.Num();
+	InOutComponent.SolutionCounts = InOutComponent.RawSolutionCounts;
+	InOutComponent.CellMineCounts = InOutComponent.RawCellMineCounts;
+
+	// counts become count * odds^k divided by the largest of them, computed in log space since either factor alone can overflow
+	double maxLogCount = TNumericLimits<double>::Lowest();
+	for (int32 k = 0; k <= numCells; ++k)
+	{
+		if (InOutComponent.SolutionCounts[k] > 0.0)
+		{
+			maxLogCount = FMath::Max(maxLogCount, FMath::Loge(InOutComponent.SolutionCounts[k]) + (k * InLogMineOdds));
+		}
+	}
+
+	InOutComponent.LogCountScale = maxLogCount > TNumericLimits<double>::Lowest() ? maxLogCount : 0.0;
+
+	auto tilt = [&](double& InOutCount, const int32 InNumMines)
+	{
+		if (InOutCount > 0.0)
+		{
+			InOutCount = FMath::Exp(FMath::Loge(InOutCount) + (InNumMines * InLogMineOdds) - maxLogCount);
+		}
+	};
+
+	for (int32 k = 0; k <= numCells; ++k)
+	{
+		tilt(InOutComponent.SolutionCounts[k], k);
+	}
+	for (int32 cell = 0; cell < numCells; ++cell)
+	{
+		for (int32 k = 0; k <= numCells; ++k)
+		{
+			tilt(InOutComponent.CellMineCounts[(cell * (numCells + 1)) + k], k);
+		}
+	}
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,420 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperPuzzleDatabase.h"
+#include "MinesweeperRuntimeModule.h"
+#include "HAL/FileManager.h"
+#include "HAL/PlatformFileManager.h"
+#include "Async/MappedFileHandle.h"
+#include "Misc/FileHelper.h"
+#include "Algo/BinarySearch.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void MinesweeperPuzzleDatabase::PackMines(const FMinesweeperBoard& InBoard, uint8* OutBits)
+{
+	const int32 totalCellCount = InBoard.Num();
+	FMemory::Memzero(OutBits, (totalCellCount + 7) / 8);
+
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		OutBits[cellIndex >> 3] |= InBoard.Mines[cellIndex] << (cellIndex & 7);
+	}
+}
+
+void MinesweeperPuzzleDatabase::UnpackMines(const uint8* InBits, const FMinesweeperDifficulty& InDifficulty, FMinesweeperBoard& OutBoard)
+{
+	OutBoard.Init(InDifficulty);
+
+	for (int32 cellIndex = 0; cellIndex < OutBoard.Num(); ++cellIndex)
+	{
+		const uint8 mine = (InBits[cellIndex >> 3] >> (cellIndex & 7)) & 1;
+		OutBoard.Mines[cellIndex] = mine;
+		OutBoard.MineCount += mine;
+	}
+
+	OutBoard.ComputeNeighborMineCounts();
+	OutBoard.ComputeOpenings();
+}
+
+
+
+
+int32 FMinesweeperPuzzleDatabaseWriter::AddSection(const FMinesweeperDifficulty& InDifficulty, const int32 InNumRecords)
+{
+	check(InDifficulty.TotalCells() > 0 && InDifficulty.TotalCells() <= MAX_uint16); // first clicks are stored as uint16
+
+	FSectionData& section = Sections.AddDefaulted_GetRef();
+	section.Difficulty = InDifficulty;
+	section.NumRecords = FMath::Max(InNumRecords, 0);
+	section.RecordSize = MinesweeperPuzzleDatabase::GetRecordSize(InDifficulty);
+	section.Records.SetNumZeroed((int64)section.NumRecords * section.RecordSize);
+	section.Hashes.SetNumZeroed(section.NumRecords);
+
+	return Sections.Num() - 1;
+}
+
+void FMinesweeperPuzzleDatabaseWriter::WriteRecord(const int32 InSectionIndex, const int32 InRecordIndex, const FMinesweeperBoard& InBoard, const FMinesweeperBoardMetrics& InMetrics,
+	const FMinesweeperBoardRating& InRating, const int32 InFirstClickIndex, const int32 InSeed, const bool bInNoGuess)
+{
+	FSectionData& section = Sections[InSectionIndex];
+	check(InRecordIndex >= 0 && InRecordIndex < section.NumRecords);
+	check(InBoard.Num() == section.Difficulty.TotalCells());
+
+	FMinesweeperPuzzleRecord* record = reinterpret_cast<FMinesweeperPuzzleRecord*>(section.Records.GetData() + ((int64)InRecordIndex * section.RecordSize));
+	record->ThreeBV = (uint16)FMath::Min(InMetrics.ThreeBV, (int32)MAX_uint16);
+	record->Openings = (uint16)FMath::Min(InMetrics.Openings, (int32)MAX_uint16);
+	record->Islands = (uint16)FMath::Min(InMetrics.Islands, (int32)MAX_uint16);
+	record->ZiNi = (uint16)FMath::Min(InMetrics.ZiNi, (int32)MAX_uint16);
+	record->FirstClickIndex = (uint16)InFirstClickIndex;
+	record->Flags = bInNoGuess ? FMinesweeperPuzzleRecord::NoGuess : 0;
+	record->DeductionDepth = (uint8)FMath::Clamp(InRating.DeductionDepth, 0, (int32)MAX_uint8);
+	record->Seed = InSeed;
+	record->Guesses = (uint16)FMath::Clamp(InRating.Guesses, 0, (int32)MAX_uint16);
+	record->MaxComponentSize = (uint16)FMath::Clamp(InRating.MaxComponentSize, 0, (int32)MAX_uint16);
+
+	MinesweeperPuzzleDatabase::PackMines(InBoard, record->GetMineBits());
+
+	section.Hashes[InRecordIndex] = FMinesweeperBoardHash::ComputeCanonical(InBoard);
+}
+
+
+bool FMinesweeperPuzzleDatabaseWriter::Save(const FString& InFilename) const
+{
+	using namespace MinesweeperPuzzleDatabase;
+
+	// layout: file header, section table, then each section's records, record index and hash index, each starting aligned
+	FMinesweeperPuzzleFileHeader fileHeader;
+	fileHeader.Magic = Magic;
+	fileHeader.Version = Version;
+	fileHeader.NumSections = Sections.Num();
+	fileHeader.SectionTableOffset = sizeof(FMinesweeperPuzzleFileHeader);
+
+	TArray<TArray<int32>> sectionKeptRecords;
+	TArray<TArray<FMinesweeperPuzzleIndexEntry>> sectionIndexes;
+	TArray<TArray<FMinesweeperPuzzleHashEntry>> sectionHashIndexes;
+
+	for (const FSectionData& sectionData : Sections)
+	{
+		// rotations and reflections of a stored board share its canonical hash and are dropped
+		TArray<int32>& keptRecords = sectionKeptRecords.AddDefaulted_GetRef();
+		TSet<FMinesweeperBoardHash> seenHashes;
+		seenHashes.Reserve(sectionData.NumRecords);
+
+		for (int32 recordIndex = 0; recordIndex < sectionData.NumRecords; ++recordIndex)
+		{
+			bool bIsDuplicate = false;
+			seenHashes.Add(sectionData.Hashes[recordIndex], &bIsDuplicate);
+			if (!bIsDuplicate)
+			{
+				keptRecords.Add(recordIndex);
+			}
+		}
+
+		if (keptRecords.Num() < sectionData.NumRecords)
+		{
+			UE_LOG(LogMinesweeperRuntime, Display, TEXT("Dropped %d duplicate %dx%d boards."), sectionData.NumRecords - keptRecords.Num(), sectionData.Difficulty.Width, sectionData.Difficulty.Height);
+		}
+
+		// index entries sorted by no-guess flag and 3BV so range queries are a binary search, hash entries sorted by short key
+		TArray<FMinesweeperPuzzleIndexEntry>& sectionIndex = sectionIndexes.AddDefaulted_GetRef();
+		TArray<FMinesweeperPuzzleHashEntry>& sectionHashIndex = sectionHashIndexes.AddDefaulted_GetRef();
+		sectionIndex.SetNumUninitialized(keptRecords.Num());
+		sectionHashIndex.SetNumUninitialized(keptRecords.Num());
+
+		for (int32 keptIndex = 0; keptIndex < keptRecords.Num(); ++keptIndex)
+		{
+			const int32 recordIndex = keptRecords[keptIndex];
+			const FMinesweeperPuzzleRecord* record = reinterpret_cast<const FMinesweeperPuzzleRecord*>(sectionData.Records.GetData() + ((int64)recordIndex * sectionData.RecordSize));
+
+			sectionIndex[keptIndex].SortKey = FMinesweeperPuzzleIndexEntry::MakeSortKey(record->IsNoGuess(), record->ThreeBV);
+			sectionIndex[keptIndex].RecordIndex = keptIndex;
+
+			sectionHashIndex[keptIndex].ShortKey = sectionData.Hashes[recordIndex].GetShortKey();
+			sectionHashIndex[keptIndex].RecordIndex = keptIndex;
+			sectionHashIndex[keptIndex].Reserved = 0;
+		}
+
+		sectionIndex.Sort();
+		sectionHashIndex.Sort();
+	}
+
+	TArray<FMinesweeperPuzzleSection> sectionTable;
+	uint64 nextOffset = Align(sizeof(FMinesweeperPuzzleFileHeader) + (sizeof(FMinesweeperPuzzleSection) * Sections.Num()), SectionAlignment);
+
+	for (int32 sectionIndex = 0; sectionIndex < Sections.Num(); ++sectionIndex)
+	{
+		const FSectionData& sectionData = Sections[sectionIndex];
+		const uint64 numKeptRecords = sectionKeptRecords[sectionIndex].Num();
+
+		FMinesweeperPuzzleSection& section = sectionTable.AddDefaulted_GetRef();
+		section.Width = sectionData.Difficulty.Width;
+		section.Height = sectionData.Difficulty.Height;
+		section.MineCount = sectionData.Difficulty.MineCount;
+		section.RecordSize = sectionData.RecordSize;
+		section.NumRecords = numKeptRecords;
+
+		section.RecordsOffset = nextOffset;
+		nextOffset = Align(nextOffset + (numKeptRecords * sectionData.RecordSize), SectionAlignment);
+
+		section.IndexOffset = nextOffset;
+		nextOffset = Align(nextOffset + (sizeof(FMinesweeperPuzzleIndexEntry) * numKeptRecords), SectionAlignment);
+
+		section.HashIndexOffset = nextOffset;
+		nextOffset = Align(nextOffset + (sizeof(FMinesweeperPuzzleHashEntry) * numKeptRecords), SectionAlignment);
+	}
+
+	TUniquePtr<FArchive> fileWriter(IFileManager::Get().CreateFileWriter(*InFilename));
+	if (!fileWriter)
+	{
+		UE_LOG(LogMinesweeperRuntime, Error, TEXT("Could not open puzzle database '%s' for writing."), *InFilename);
+		return false;
+	}
+
+	static const uint8 zeroPadding[SectionAlignment] = { };
+	auto writePadding = [&](const uint64 InOffset)
+	{
+		const int64 paddingSize = (int64)InOffset - fileWriter->Tell();
+		check(paddingSize >= 0 && paddingSize < SectionAlignment);
+		fileWriter->Serialize((void*)zeroPadding, paddingSize);
+	};
+
+	fileWriter->Serialize(&fileHeader, sizeof(fileHeader));
+	fileWriter->Serialize(sectionTable.GetData(), sectionTable.Num() * sizeof(FMinesweeperPuzzleSection));
+
+	for (int32 sectionIndex = 0; sectionIndex < Sections.Num(); ++sectionIndex)
+	{
+		const FSectionData& sectionData = Sections[sectionIndex];
+
+		writePadding(sectionTable[sectionIndex].RecordsOffset);
+		for (const int32 recordIndex : sectionKeptRecords[sectionIndex])
+		{
+			fileWriter->Serialize((void*)(sectionData.Records.GetData() + ((int64)recordIndex * sectionData.RecordSize)), sectionData.RecordSize);
+		}
+
+		writePadding(sectionTable[sectionIndex].IndexOffset);
+		fileWriter->Serialize(sectionIndexes[sectionIndex].GetData(), sectionIndexes[sectionIndex].Num() * sizeof(FMinesweeperPuzzleIndexEntry));
+
+		writePadding(sectionTable[sectionIndex].HashIndexOffset);
+		fileWriter->Serialize(sectionHashIndexes[sectionIndex].GetData(), sectionHashIndexes[sectionIndex].Num() * sizeof(FMinesweeperPuzzleHashEntry));
+	}
+
+	return fileWriter->Close() && !fileWriter->IsError();
+}
+
+
+
+
+FMinesweeperPuzzleDatabase::FMinesweeperPuzzleDatabase()
+{ }
+
+FMinesweeperPuzzleDatabase::~FMinesweeperPuzzleDatabase()
+{
+	Close();
+}
+
+
+bool FMinesweeperPuzzleDatabase::Open(const FString& InFilename)
+{
+	Close();
+
+	MappedFile.Reset(FPlatformFileManager::Get().GetPlatformFile().OpenMapped(*InFilename));
+	if (MappedFile)
+	{
+		MappedRegion.Reset(MappedFile->MapRegion(0, MappedFile->GetFileSize()));
+	}
+
+	if (MappedRegion)
+	{
+		Data = MappedRegion->GetMappedPtr();
+		DataSize = MappedRegion->GetMappedSize();
+	}
+	else
+	{
+		MappedFile.Reset();
+		if (!FFileHelper::LoadFileToArray(LoadedData, *InFilename, FILEREAD_Silent))
+		{
+			UE_LOG(LogMinesweeperRuntime, Error, TEXT("Could not open puzzle database '%s'."), *InFilename);
+			return false;
+		}
+		Data = LoadedData.GetData();
+		DataSize = LoadedData.Num();
+	}
+
+	if (!ValidateAndBind(InFilename))
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void FMinesweeperPuzzleDatabase::Close()
+{
+	Sections.Reset();
+	Data = nullptr;
+	DataSize = 0;
+
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	LoadedData.Empty();
+}
+
+bool FMinesweeperPuzzleDatabase::ValidateAndBind(const FString& InFilename)
+{
+	using namespace MinesweeperPuzzleDatabase;
+
+	auto fail = [&InFilename](const TCHAR* InReason)
+	{
+		UE_LOG(LogMinesweeperRuntime, Error, TEXT("Puzzle database '%s' is invalid: %s."), *InFilename, InReason);
+		return false;
+	};
+
+	auto isInFile = [this](const uint64 InOffset, const uint64 InSize)
+	{
+		return InOffset <= (uint64)DataSize && InSize <= (uint64)DataSize - InOffset;
+	};
+
+	if (!isInFile(0, sizeof(FMinesweeperPuzzleFileHeader))) return fail(TEXT("file too small"));
+
+	const FMinesweeperPuzzleFileHeader* fileHeader = reinterpret_cast<const FMinesweeperPuzzleFileHeader*>(Data);
+	if (fileHeader->Magic != Magic) return fail(TEXT("not a puzzle database"));
+	if (fileHeader->Version != Version) return fail(TEXT("unsupported version"));
+	if (!isInFile(fileHeader->SectionTableOffset, (uint64)fileHeader->NumSections * sizeof(FMinesweeperPuzzleSection))) return fail(TEXT("section table out of bounds"));
+
+	const FMinesweeperPuzzleSection* sectionTable = reinterpret_cast<const FMinesweeperPuzzleSection*>(Data + fileHeader->SectionTableOffset);
+	for (uint32 sectionIndex = 0; sectionIndex < fileHeader->NumSections; ++sectionIndex)
+	{
+		const FMinesweeperPuzzleSection& section = sectionTable[sectionIndex];
+		const FMinesweeperDifficulty difficulty(section.Width, section.Height, section.MineCount);
+
+		if (section.Width <= 0 || section.Height <= 0 || difficulty.TotalCells() > MAX_uint16) return fail(TEXT("bad section size"));
+		if (section.RecordSize < (uint32)GetRecordSize(difficulty) || section.NumRecords > MAX_int32) return fail(TEXT("bad record layout"));
+		if (!isInFile(section.RecordsOffset, section.NumRecords * section.RecordSize)) return fail(TEXT("records out of bounds"));
+		if (section.IndexOffset != 0 && !isInFile(section.IndexOffset, section.NumRecords * sizeof(FMinesweeperPuzzleIndexEntry))) return fail(TEXT("index out of bounds"));
+		if (section.HashIndexOffset != 0 && !isInFile(section.HashIndexOffset, section.NumRecords * sizeof(FMinesweeperPuzzleHashEntry))) return fail(TEXT("hash index out of bounds"));
+		if (!IsAligned(section.RecordsOffset, SectionAlignment) || !IsAligned(section.IndexOffset, SectionAlignment) || !IsAligned(section.HashIndexOffset, SectionAlignment)) return fail(TEXT("misaligned section"));
+
+		// lookups turn index entries straight into records, so an entry past the records would read outside the section
+		if (section.IndexOffset != 0)
+		{
+			const FMinesweeperPuzzleIndexEntry* sectionIndex = reinterpret_cast<const FMinesweeperPuzzleIndexEntry*>(Data + section.IndexOffset);
+			for (uint64 entryIndex = 0; entryIndex < section.NumRecords; ++entryIndex)
+			{
+				if (sectionIndex[entryIndex].RecordIndex >= section.NumRecords) return fail(TEXT("index entry out of range"));
+			}
+		}
+		if (section.HashIndexOffset != 0)
+		{
+			const FMinesweeperPuzzleHashEntry* hashIndex = reinterpret_cast<const FMinesweeperPuzzleHashEntry*>(Data + section.HashIndexOffset);
+			for (uint64 entryIndex = 0; entryIndex < section.NumRecords; ++entryIndex)
+			{
+				if (hashIndex[entryIndex].RecordIndex >= section.NumRecords) return fail(TEXT("hash index entry out of range"));
+			}
+		}
+
+		Sections.Add(&section);
+	}
+
+	return true;
+}
+
+
+int32 FMinesweeperPuzzleDatabase::FindSection(const FMinesweeperDifficulty& InDifficulty) const
+{
+	for (int32 sectionIndex = 0; sectionIndex < Sections.Num(); ++sectionIndex)
+	{
+		if (GetSectionDifficulty(sectionIndex) == InDifficulty)
+		{
+			return sectionIndex;
+		}
+	}
+	return INDEX_NONE;
+}
+
+const FMinesweeperPuzzleRecord* FMinesweeperPuzzleDatabase::GetRecord(const int64 InPuzzleId) const
+{
+	const int32 sectionIndex = MinesweeperPuzzleDatabase::GetSectionIndex(InPuzzleId);
+	const int32 recordIndex = MinesweeperPuzzleDatabase::GetRecordIndex(InPuzzleId);
+	if (!Sections.IsValidIndex(sectionIndex) || recordIndex < 0 || (uint64)recordIndex >= Sections[sectionIndex]->NumRecords) return nullptr;
+
+	const FMinesweeperPuzzleSection& section = *Sections[sectionIndex];
+	return reinterpret_cast<const FMinesweeperPuzzleRecord*>(Data + section.RecordsOffset + ((uint64)recordIndex * section.RecordSize));
+}
+
+
+TArrayView<const FMinesweeperPuzzleIndexEntry> FMinesweeperPuzzleDatabase::FindRecords(const int32 InSectionIndex, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV) const
+{
+	if (!Sections.IsValidIndex(InSectionIndex) || Sections[InSectionIndex]->IndexOffset == 0 || InMinThreeBV > InMaxThreeBV) return TArrayView<const FMinesweeperPuzzleIndexEntry>();
+
+	const FMinesweeperPuzzleSection& section = *Sections[InSectionIndex];
+	const TArrayView<const FMinesweeperPuzzleIndexEntry> sectionIndex(reinterpret_cast<const FMinesweeperPuzzleIndexEntry*>(Data + section.IndexOffset), (int32)section.NumRecords);
+
+	const uint32 minKey = FMinesweeperPuzzleIndexEntry::MakeSortKey(bInNoGuess, InMinThreeBV);
+	const uint32 maxKey = FMinesweeperPuzzleIndexEntry::MakeSortKey(bInNoGuess, InMaxThreeBV);
+
+	const int32 startIndex = Algo::LowerBoundBy(sectionIndex, minKey, &FMinesweeperPuzzleIndexEntry::SortKey);
+	const int32 endIndex = Algo::UpperBoundBy(sectionIndex, maxKey, &FMinesweeperPuzzleIndexEntry::SortKey);
+
+	return sectionIndex.Slice(startIndex, FMath::Max(endIndex - startIndex, 0));
+}
+
+int64 FMinesweeperPuzzleDatabase::FindPuzzleByShortKey(const uint64 InShortKey) const
+{
+	for (int32 sectionIndex = 0; sectionIndex < Sections.Num(); ++sectionIndex)
+	{
+		const FMinesweeperPuzzleSection& section = *Sections[sectionIndex];
+		if (section.HashIndexOffset == 0) continue;
+
+		const TArrayView<const FMinesweeperPuzzleHashEntry> hashIndex(reinterpret_cast<const FMinesweeperPuzzleHashEntry*>(Data + section.HashIndexOffset), (int32)section.NumRecords);
+
+		const int32 entryIndex = Algo::LowerBoundBy(hashIndex, InShortKey, &FMinesweeperPuzzleHashEntry::ShortKey);
+		if (hashIndex.IsValidIndex(entryIndex) && hashIndex[entryIndex].ShortKey == InShortKey)
+		{
+			return MinesweeperPuzzleDatabase::MakePuzzleId(sectionIndex, hashIndex[entryIndex].RecordIndex);
+		}
+	}
+	return INDEX_NONE;
+}
+
+int64 FMinesweeperPuzzleDatabase::FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV, FMinesweeperRandomStream& InRandStream) const
+{
+	const int32 sectionIndex = FindSection(InDifficulty);
+	const TArrayView<const FMinesweeperPuzzleIndexEntry> matchingEntries = FindRecords(sectionIndex, bInNoGuess, InMinThreeBV, InMaxThreeBV);
+	if (matchingEntries.Num() == 0) return INDEX_NONE;
+
+	const FMinesweeperPuzzleIndexEntry& entry = matchingEntries[(int32)InRandStream.NextBounded(matchingEntries.Num())];
+	return MinesweeperPuzzleDatabase::MakePuzzleId(sectionIndex, entry.RecordIndex);
+}
+
+int64 FMinesweeperPuzzleDatabase::FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV,
+	const FMinesweeperBoardRating& InMinRating, const FMinesweeperBoardRating& InMaxRating, FMinesweeperRandomStream& InRandStream) const
+{
+	const int32 sectionIndex = FindSection(InDifficulty);
+	const TArrayView<const FMinesweeperPuzzleIndexEntry> matchingEntries = FindRecords(sectionIndex, bInNoGuess, InMinThreeBV, InMaxThreeBV);
+
+	// reservoir sampling picks uniformly among the matches in a single pass without gathering them
+	int64 puzzleId = INDEX_NONE;
+	uint32 numMatches = 0;
+	for (const FMinesweeperPuzzleIndexEntry& entry : matchingEntries)
+	{
+		const int64 entryPuzzleId = MinesweeperPuzzleDatabase::MakePuzzleId(sectionIndex, entry.RecordIndex);
+		const FMinesweeperPuzzleRecord* record = GetRecord(entryPuzzleId);
+		if (!record || !record->GetRating().IsWithin(InMinRating, InMaxRating)) continue;
+
+		if (InRandStream.NextBounded(++numMatches) == 0)
+		{
+			puzzleId = entryPuzzleId;
+		}
+	}
+	return puzzleId;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -1,6 +1,7 @@
 // Copyright 2022 Brad Monahan. All Rights Reserved.
 
 #include "MinesweeperRuntimeModule.h"
+#include "MinesweeperBoardPool.h"
 
 
 #define LOCTEXT_NAMESPACE "Minesweeper"
@@ -17,7 +18,7 @@ void FMinesweeperRuntimeModule::StartupModule()
 
 void FMinesweeperRuntimeModule::ShutdownModule()
 {
-
+	FMinesweeperBoardPool::Get().Shutdown();
 }
 
 
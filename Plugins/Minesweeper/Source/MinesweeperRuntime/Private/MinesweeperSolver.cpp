@@ -0,0 +1,372 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperSolver.h"
+#include "MinesweeperPatterns.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void FMinesweeperSolver::Init(const int32 InWidth, const int32 InHeight, const int32 InMineCount)
+{
+	Width = FMath::Max(InWidth, 0);
+	Height = FMath::Max(InHeight, 0);
+	MineCount = InMineCount;
+
+	States.SetNumUninitialized(Num());
+	Numbers.SetNumUninitialized(Num());
+	IsQueued.SetNumUninitialized(Num());
+
+	Reset();
+}
+
+void FMinesweeperSolver::Reset()
+{
+	FMemory::Memzero(States.GetData(), States.Num());
+	FMemory::Memzero(Numbers.GetData(), Numbers.Num());
+	FMemory::Memzero(IsQueued.GetData(), IsQueued.Num());
+
+	DirtyCells.Reset();
+	DeferredCells.Reset();
+	SafeCells.Reset();
+	KnownMines.Reset();
+
+	NumUnknown = Num();
+	NumOpened = 0;
+
+	PatternLookups = 0;
+	PatternHits = 0;
+	HardestRule = NoRule;
+}
+
+
+void FMinesweeperSolver::RevealCell(const int32 InCellIndex, const int32 InNeighborMineCount)
+{
+	const uint8 state = States[InCellIndex];
+	if (state == Opened) return;
+
+	// a revealed mine means the player lost, nothing more to deduce from it
+	if (state == Unknown) --NumUnknown;
+
+	States[InCellIndex] = Opened;
+	Numbers[InCellIndex] = (uint8)InNeighborMineCount;
+	++NumOpened;
+
+	Queue(InCellIndex);
+	QueueAffected(InCellIndex);
+}
+
+
+void FMinesweeperSolver::Solve()
+{
+	while (true)
+	{
+		// the single point rule runs on every changed number before the costlier rules run on any, so the hardest rule used is one the position needs
+		while (DirtyCells.Num() > 0 || DeferredCells.Num() > 0)
+		{
+			if (DirtyCells.Num() > 0)
+			{
+				const int32 cellIndex = DirtyCells.Pop(false);
+				IsQueued[cellIndex] &= ~QueuedDirty;
+
+				if (ApplySinglePoint(cellIndex))
+				{
+					HardestRule = FMath::Max(HardestRule, (uint8)SinglePointRule);
+				}
+				else if (!(IsQueued[cellIndex] & QueuedDeferred))
+				{
+					IsQueued[cellIndex] |= QueuedDeferred;
+					DeferredCells.Add(cellIndex);
+				}
+				continue;
+			}
+
+			const int32 cellIndex = DeferredCells.Pop(false);
+			IsQueued[cellIndex] &= ~QueuedDeferred;
+
+			if (ApplySubset(cellIndex)) HardestRule = FMath::Max(HardestRule, (uint8)SubsetRule);
+			else if (ApplyPatterns(cellIndex)) HardestRule = FMath::Max(HardestRule, (uint8)PatternRule);
+		}
+
+		// the global rule only runs once local rules are exhausted, and only resolves anything near the end of a game
+		const int32 numSafeCells = SafeCells.Num();
+		if (!ApplyGlobal()) break;
+
+		// marking the last unknown cells as mines leaves nothing to open, which takes no reasoning
+		if (SafeCells.Num() > numSafeCells) HardestRule = GlobalRule;
+	}
+}
+
+
+int32 FMinesweeperSolver::GetNextSafeCell()
+{
+	while (SafeCells.Num() > 0 && States[SafeCells.Last()] != Safe)
+	{
+		SafeCells.Pop(false);
+	}
+	return SafeCells.Num() > 0 ? SafeCells.Last() : INDEX_NONE;
+}
+
+int32 FMinesweeperSolver::PopSafeCell()
+{
+	const int32 cellIndex = GetNextSafeCell();
+	if (cellIndex != INDEX_NONE)
+	{
+		SafeCells.Pop(false);
+	}
+	return cellIndex;
+}
+
+
+int32 FMinesweeperSolver::GatherUnknowns(const int32 InCellIndex, int32 OutUnknowns[8], int32& OutNumUnknowns) const
+{
+	int32 missingMines = Numbers[InCellIndex];
+	OutNumUnknowns = 0;
+	ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+		{
+			if (States[InNeighborIndex] == Unknown) OutUnknowns[OutNumUnknowns++] = InNeighborIndex;
+			else if (States[InNeighborIndex] == Mine) --missingMines;
+		});
+	return missingMines;
+}
+
+bool FMinesweeperSolver::Resolve(const int32* InCells, const int32 InNumCells, const bool bInAsMines)
+{
+	bool bProgress = false;
+	for (int32 i = 0; i < InNumCells; ++i)
+	{
+		const int32 cellIndex = InCells[i];
+		if (States[cellIndex] != Unknown) continue;
+
+		--NumUnknown;
+		if (bInAsMines)
+		{
+			States[cellIndex] = Mine;
+			KnownMines.Add(cellIndex);
+		}
+		else
+		{
+			States[cellIndex] = Safe;
+			SafeCells.Add(cellIndex);
+		}
+
+		QueueAffected(cellIndex);
+		bProgress = true;
+	}
+	return bProgress;
+}
+
+
+void FMinesweeperSolver::Queue(const int32 InCellIndex)
+{
+	if (IsQueued[InCellIndex] & QueuedDirty) return;
+
+	IsQueued[InCellIndex] |= QueuedDirty;
+	DirtyCells.Add(InCellIndex);
+}
+
+void FMinesweeperSolver::QueueAffected(const int32 InCellIndex)
+{
+	ForEachNeighbor(InCellIndex, [&](const int32 InNeighborIndex)
+		{
+			if (States[InNeighborIndex] == Opened)
+			{
+				Queue(InNeighborIndex);
+			}
+		});
+}
+
+
+bool FMinesweeperSolver::ApplySinglePoint(const int32 InCellIndex)
+{
+	int32 unknowns[8];
+	int32 numUnknowns = 0;
+	const int32 missingMines = GatherUnknowns(InCellIndex, unknowns, numUnknowns);
+	if (numUnknowns == 0) return false;
+
+	if (missingMines == 0) return Resolve(unknowns, numUnknowns, false);
+	if (missingMines == numUnknowns) return Resolve(unknowns, numUnknowns, true);
+	return false;
+}
+
+bool FMinesweeperSolver::ApplySubset(const int32 InCellIndex)
+{
+	int32 unknownsA[8], unknownsB[8], difference[8];
+	int32 numUnknownsA = 0, numUnknownsB = 0;
+
+	const int32 missingMinesA = GatherUnknowns(InCellIndex, unknownsA, numUnknownsA);
+	if (numUnknownsA == 0) return false;
+
+	// returns the cells of InSuperset missing from InSubset, or -1 if InSubset is not a subset
+	auto subtract = [&difference](const int32* InSubset, const int32 InNumSubset, const int32* InSuperset, const int32 InNumSuperset) -> int32
+	{
+		int32 numDifference = 0;
+		int32 numShared = 0;
+		for (int32 b = 0; b < InNumSuperset; ++b)
+		{
+			bool bShared = false;
+			for (int32 a = 0; a < InNumSubset; ++a)
+			{
+				if (InSubset[a] == InSuperset[b]) { bShared = true; break; }
+			}
+			if (bShared) ++numShared;
+			else difference[numDifference++] = InSuperset[b];
+		}
+		return numShared == InNumSubset ? numDifference : -1;
+	};
+
+	// numbers sharing an unknown neighbor are at most two cells apart
+	const int32 cellX = InCellIndex % Width;
+	const int32 cellY = InCellIndex / Width;
+	for (int32 y = FMath::Max(cellY - 2, 0); y <= FMath::Min(cellY + 2, Height - 1); ++y)
+	{
+		for (int32 x = FMath::Max(cellX - 2, 0); x <= FMath::Min(cellX + 2, Width - 1); ++x)
+		{
+			const int32 cellIndexB = (Width * y) + x;
+			if (cellIndexB == InCellIndex || States[cellIndexB] != Opened) continue;
+
+			const int32 missingMinesB = GatherUnknowns(cellIndexB, unknownsB, numUnknownsB);
+			if (numUnknownsB == 0 || numUnknownsB == numUnknownsA) continue;
+
+			// whichever constraint is smaller must be a subset of the other, its extra cells hold the difference in missing mines
+			const bool bAIsSubset = numUnknownsA < numUnknownsB;
+			const int32 numDifference = bAIsSubset
+				? subtract(unknownsA, numUnknownsA, unknownsB, numUnknownsB)
+				: subtract(unknownsB, numUnknownsB, unknownsA, numUnknownsA);
+			if (numDifference <= 0) continue;
+
+			const int32 differenceMines = bAIsSubset ? missingMinesB - missingMinesA : missingMinesA - missingMinesB;
+			if (differenceMines == 0) return Resolve(difference, numDifference, false);
+			if (differenceMines == numDifference) return Resolve(difference, numDifference, true);
+		}
+	}
+
+	return false;
+}
+
+bool FMinesweeperSolver::ApplyPatterns(const int32 InCellIndex)
+{
+	using namespace MinesweeperPatterns;
+
+	if (!bUsePatterns) return false;
+
+	// run direction and the side the cells lie on: cells above and below rows, left and right of columns
+	static const int32 orientations[4][4] = { { 1, 0, 0, -1 }, { 1, 0, 0, 1 }, { 0, 1, -1, 0 }, { 0, 1, 1, 0 } };
+
+	const int32 cellX = InCellIndex % Width;
+	const int32 cellY = InCellIndex / Width;
+
+	// most numbers have unknowns on more than one side and fit no run at all, which is cheap to tell from their own unknowns. Numbers
+	// without unknowns are left to the other numbers of their runs, which are queued by the same changes.
+	int32 unknowns[8];
+	int32 numUnknowns = 0;
+	GatherUnknowns(InCellIndex, unknowns, numUnknowns);
+	if (numUnknowns == 0) return false;
+
+	uint32 orientationMask = 0xF;
+	for (int32 i = 0; i < numUnknowns; ++i)
+	{
+		const int32 offsetX = (unknowns[i] % Width) - cellX;
+		const int32 offsetY = (unknowns[i] / Width) - cellY;
+		if (offsetY != -1) orientationMask &= ~0x1u;
+		if (offsetY != 1) orientationMask &= ~0x2u;
+		if (offsetX != -1) orientationMask &= ~0x4u;
+		if (offsetX != 1) orientationMask &= ~0x8u;
+	}
+
+	for (int32 orientationIndex = 0; orientationIndex < 4; ++orientationIndex)
+	{
+		if (!(orientationMask & (1u << orientationIndex))) continue;
+
+		const int32 runX = orientations[orientationIndex][0], runY = orientations[orientationIndex][1];
+		const int32 sideX = orientations[orientationIndex][2], sideY = orientations[orientationIndex][3];
+
+		// the number may be any of the three in a run, only the numbers next to a changed cell are queued again
+		for (int32 position = 0; position < NumRunNumbers; ++position)
+		{
+			const int32 startX = cellX - (position * runX);
+			const int32 startY = cellY - (position * runY);
+
+			int32 runCells[NumRunCells];
+			uint32 unknownMask = 0;
+			for (int32 cell = 0; cell < NumRunCells; ++cell)
+			{
+				const int32 x = startX + ((cell - 1) * runX) + sideX;
+				const int32 y = startY + ((cell - 1) * runY) + sideY;
+				runCells[cell] = (Width * y) + x;
+
+				if (x >= 0 && y >= 0 && x < Width && y < Height && States[runCells[cell]] == Unknown)
+				{
+					unknownMask |= 1u << cell;
+				}
+			}
+			if (unknownMask == 0) continue;
+
+			uint32 key = unknownMask;
+			for (int32 number = 0; number < NumRunNumbers; ++number)
+			{
+				const int32 x = startX + (number * runX);
+				const int32 y = startY + (number * runY);
+				if (x < 0 || y < 0 || x >= Width || y >= Height || States[(Width * y) + x] != Opened)
+				{
+					key = 0;
+					break;
+				}
+
+				// the number only fits the pattern if every unknown it sees is one of the three run cells next to it
+				int32 numberUnknowns[8];
+				int32 numNumberUnknowns = 0;
+				const int32 missingMines = GatherUnknowns((Width * y) + x, numberUnknowns, numNumberUnknowns);
+				if (numNumberUnknowns != FMath::CountBits((unknownMask >> number) & 0x7) || missingMines < 0 || missingMines > 3)
+				{
+					key = 0;
+					break;
+				}
+				key |= (uint32)missingMines << (NumRunCells + (number * 2));
+			}
+			if (key == 0) continue;
+
+			++PatternLookups;
+			const uint16 entry = PatternTable[key];
+			if (entry == 0) continue;
+
+			int32 safeCells[NumRunCells], mineCells[NumRunCells];
+			int32 numSafeCells = 0, numMineCells = 0;
+			for (int32 cell = 0; cell < NumRunCells; ++cell)
+			{
+				if (GetSafeCells(entry) & (1u << cell)) safeCells[numSafeCells++] = runCells[cell];
+				if (GetMineCells(entry) & (1u << cell)) mineCells[numMineCells++] = runCells[cell];
+			}
+
+			// entries only name unknown cells, so every hit makes progress
+			++PatternHits;
+			Resolve(safeCells, numSafeCells, false);
+			Resolve(mineCells, numMineCells, true);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+bool FMinesweeperSolver::ApplyGlobal()
+{
+	if (NumUnknown == 0) return false;
+
+	const int32 minesRemaining = MineCount - KnownMines.Num();
+	if (minesRemaining != 0 && minesRemaining != NumUnknown) return false;
+
+	bool bProgress = false;
+	for (int32 cellIndex = 0; cellIndex < Num(); ++cellIndex)
+	{
+		bProgress |= Resolve(&cellIndex, 1, minesRemaining > 0);
+	}
+	return bProgress;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
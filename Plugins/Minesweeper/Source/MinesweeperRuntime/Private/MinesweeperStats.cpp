@@ -0,0 +1,65 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperStats.h"
+#include "Misc/ScopeLock.h"
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+FMinesweeperLatencyTracker::FMinesweeperLatencyTracker(const int32 InMaxSamples)
+	: MaxSamples(FMath::Max(InMaxSamples, 1))
+{
+	Samples.Reserve(MaxSamples);
+}
+
+
+void FMinesweeperLatencyTracker::AddSample(const double InSeconds)
+{
+	FScopeLock scopeLock(&SamplesLock);
+
+	if (Samples.Num() < MaxSamples)
+	{
+		Samples.Add(InSeconds);
+	}
+	else
+	{
+		Samples[NextSampleIndex] = InSeconds;
+	}
+	NextSampleIndex = (NextSampleIndex + 1) % MaxSamples;
+}
+
+double FMinesweeperLatencyTracker::GetPercentile(const float InPercentile) const
+{
+	TArray<double> sortedSamples;
+	{
+		FScopeLock scopeLock(&SamplesLock);
+		sortedSamples = Samples;
+	}
+	if (sortedSamples.Num() == 0) return 0.0;
+
+	sortedSamples.Sort();
+
+	const int32 rank = FMath::CeilToInt32((FMath::Clamp(InPercentile, 0.0f, 100.0f) / 100.0f) * sortedSamples.Num()) - 1;
+	return sortedSamples[FMath::Clamp(rank, 0, sortedSamples.Num() - 1)];
+}
+
+int32 FMinesweeperLatencyTracker::Num() const
+{
+	FScopeLock scopeLock(&SamplesLock);
+	return Samples.Num();
+}
+
+void FMinesweeperLatencyTracker::Reset()
+{
+	FScopeLock scopeLock(&SamplesLock);
+	Samples.Reset();
+	NextSampleIndex = 0;
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -0,0 +1,144 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+
+#include "MinesweeperSweep.h"
+
+#if PLATFORM_CPU_X86_FAMILY && PLATFORM_ENABLE_VECTORINTRINSICS
+#include <emmintrin.h>
+#define MINESWEEPER_SWEEP_SSE2 1
+#else
+#define MINESWEEPER_SWEEP_SSE2 0
+#endif
+
+
+#define LOCTEXT_NAMESPACE "Minesweeper"
+
+
+
+
+void FMinesweeperSweep::Sweep(const int32 InWidth, const int32 InHeight, TArrayView<const uint8> InOpened, TArrayView<const uint8> InNumbers, TArrayView<const uint8> InFlagged)
+{
+	SafeCells.Reset();
+	MineCells.Reset();
+
+	const int32 totalCellCount = FMath::Max(InWidth, 0) * FMath::Max(InHeight, 0);
+	if (totalCellCount == 0 || InOpened.Num() < totalCellCount || InNumbers.Num() < totalCellCount || InFlagged.Num() < totalCellCount) return;
+
+	ClosedPlane.SetNumUninitialized(totalCellCount);
+	ClosedSums.SetNumUninitialized(totalCellCount);
+	FlaggedSums.SetNumUninitialized(totalCellCount);
+	SafeSources.SetNumUninitialized(totalCellCount);
+	MineSources.SetNumUninitialized(totalCellCount);
+
+	// the per cell passes are branch free so the compiler vectorizes them, only the stencils need intrinsics
+	const uint8* opened = InOpened.GetData();
+	const uint8* numbers = InNumbers.GetData();
+	const uint8* flagged = InFlagged.GetData();
+
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		ClosedPlane[cellIndex] = opened[cellIndex] ^ 1;
+	}
+
+	SumNeighbors(ClosedPlane.GetData(), InWidth, InHeight, ClosedSums.GetData());
+	SumNeighbors(flagged, InWidth, InHeight, FlaggedSums.GetData());
+
+	// closed neighbors include the flagged ones, a number with unflagged closed neighbors is satisfied by its flags or needs all of them
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		const uint8 closedCount = ClosedSums[cellIndex];
+		const uint8 flaggedCount = FlaggedSums[cellIndex];
+		const uint8 isActive = opened[cellIndex] & (uint8)(closedCount > flaggedCount);
+
+		SafeSources[cellIndex] = isActive & (uint8)(flaggedCount == numbers[cellIndex]);
+		MineSources[cellIndex] = isActive & (uint8)(closedCount == numbers[cellIndex]);
+	}
+
+	// the neighbor counts are done with, so the second stencil writes over them
+	uint8* safeSums = ClosedSums.GetData();
+	uint8* mineSums = FlaggedSums.GetData();
+	SumNeighbors(SafeSources.GetData(), InWidth, InHeight, safeSums);
+	SumNeighbors(MineSources.GetData(), InWidth, InHeight, mineSums);
+
+	for (int32 cellIndex = 0; cellIndex < totalCellCount; ++cellIndex)
+	{
+		if (!ClosedPlane[cellIndex] || flagged[cellIndex]) continue;
+
+		// both at once only happens when flags are wrong, neither answer can be trusted then
+		const bool bIsSafe = safeSums[cellIndex] > 0;
+		const bool bIsMine = mineSums[cellIndex] > 0;
+		if (bIsSafe == bIsMine) continue;
+
+		if (bIsSafe) SafeCells.Add(cellIndex);
+		else MineCells.Add(cellIndex);
+	}
+}
+
+
+void FMinesweeperSweep::SumNeighbors(const uint8* InPlane, const int32 InWidth, const int32 InHeight, uint8* OutSums, const bool bInAllowVector)
+{
+	const int32 totalCellCount = InWidth * InHeight;
+	if (totalCellCount <= 0) return;
+
+	// horizontal pass: sum of each cell and its left and right neighbor
+	TArray<uint8, TInlineAllocator<1024>> rowSums;
+	rowSums.SetNumUninitialized(totalCellCount);
+
+	for (int32 y = 0; y < InHeight; ++y)
+	{
+		const uint8* planeRow = InPlane + (InWidth * y);
+		uint8* sumRow = rowSums.GetData() + (InWidth * y);
+
+		int32 x = 0;
+#if MINESWEEPER_SWEEP_SSE2
+		if (bInAllowVector && InWidth > 1)
+		{
+			sumRow[0] = planeRow[0] + planeRow[1];
+			for (x = 1; x + 17 <= InWidth; x += 16)
+			{
+				const __m128i left = _mm_loadu_si128((const __m128i*)(planeRow + x - 1));
+				const __m128i center = _mm_loadu_si128((const __m128i*)(planeRow + x));
+				const __m128i right = _mm_loadu_si128((const __m128i*)(planeRow + x + 1));
+				_mm_storeu_si128((__m128i*)(sumRow + x), _mm_add_epi8(_mm_add_epi8(left, center), right));
+			}
+		}
+#endif
+		for (; x < InWidth; ++x)
+		{
+			sumRow[x] = planeRow[x] + (x > 0 ? planeRow[x - 1] : 0) + (x < InWidth - 1 ? planeRow[x + 1] : 0);
+		}
+	}
+
+	// vertical pass: sum the row sums above, at and below each cell then remove the cell itself
+	for (int32 y = 0; y < InHeight; ++y)
+	{
+		const uint8* sumAbove = y > 0 ? rowSums.GetData() + (InWidth * (y - 1)) : nullptr;
+		const uint8* sumRow = rowSums.GetData() + (InWidth * y);
+		const uint8* sumBelow = y < InHeight - 1 ? rowSums.GetData() + (InWidth * (y + 1)) : nullptr;
+		const uint8* planeRow = InPlane + (InWidth * y);
+		uint8* outRow = OutSums + (InWidth * y);
+
+		int32 x = 0;
+#if MINESWEEPER_SWEEP_SSE2
+		if (bInAllowVector)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			for (; x + 16 <= InWidth; x += 16)
+			{
+				const __m128i above = sumAbove ? _mm_loadu_si128((const __m128i*)(sumAbove + x)) : zero;
+				const __m128i below = sumBelow ? _mm_loadu_si128((const __m128i*)(sumBelow + x)) : zero;
+				const __m128i center = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)(sumRow + x)), _mm_loadu_si128((const __m128i*)(planeRow + x)));
+				_mm_storeu_si128((__m128i*)(outRow + x), _mm_add_epi8(_mm_add_epi8(above, below), center));
+			}
+		}
+#endif
+		for (; x < InWidth; ++x)
+		{
+			outRow[x] = sumRow[x] - planeRow[x] + (sumAbove ? sumAbove[x] : 0) + (sumBelow ? sumBelow[x] : 0);
+		}
+	}
+}
+
+
+
+
+#undef LOCTEXT_NAMESPACE
@@ -16,6 +16,8 @@ void FMinesweeperVisualTheme::CopyIfNotNull(const FMinesweeperVisualTheme& CopyF
 	CopyObjectsIfNotNull(CopyFrom);
 	HoverCellValidColor = CopyFrom.HoverCellValidColor;
 	HoverCellInvalidColor = CopyFrom.HoverCellInvalidColor;
+	ProbabilityOverlaySafeColor = CopyFrom.ProbabilityOverlaySafeColor;
+	ProbabilityOverlayMineColor = CopyFrom.ProbabilityOverlayMineColor;
 }
 
 void FMinesweeperVisualTheme::CopyObjectsIfNotNull(const FMinesweeperVisualTheme& CopyFrom)
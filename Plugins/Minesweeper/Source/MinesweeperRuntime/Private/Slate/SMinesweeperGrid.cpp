@@ -35,8 +35,11 @@ void SMinesweeperGrid::SetupGridCanvas(UMinesweeperGame* InGame, const FMineswee
 	float cellDrawSize = InVisualTheme.CellDrawSize > -1.0f ? InVisualTheme.CellDrawSize : UMinesweeperStatics::DefaultCellDrawSize();
 	cellDrawSize = FMath::Clamp(cellDrawSize, UMinesweeperStatics::MinCellDrawSize(), UMinesweeperStatics::MaxCellDrawSize());
 
+	// grids larger than the view, like endless ones, are drawn through a window scrolled with the mouse wheel
 	const FIntVector2 gridSize = InGame->GetDifficulty().GridSize();
-	const FVector2D gridCanvasSize(gridSize.X * cellDrawSize, gridSize.Y * cellDrawSize);
+	const FVector2D gridCanvasSize(
+		FMath::Min(gridSize.X, UMinesweeperGridCanvas::MaxViewCellCount) * cellDrawSize,
+		FMath::Min(gridSize.Y, UMinesweeperGridCanvas::MaxViewCellCount) * cellDrawSize);
 
 	if (!GridCanvas.IsValid())
 	{
@@ -127,6 +130,18 @@ void SMinesweeperGrid::UpdateResource()
 	GridCanvas->UpdateResource();
 }
 
+void SMinesweeperGrid::SetShowProbabilityOverlay(const bool bInShow)
+{
+	if (!GridCanvas.IsValid()) return;
+	GridCanvas->SetShowProbabilityOverlay(bInShow);
+}
+
+void SMinesweeperGrid::UpdateProbabilityOverlay(const float InBudgetMilliseconds)
+{
+	if (!GridCanvas.IsValid()) return;
+	GridCanvas->UpdateProbabilityOverlay(InBudgetMilliseconds);
+}
+
 
 FVector2D SMinesweeperGrid::ComputeDesiredSize(float InLayoutScaleMultiplier) const
 {
@@ -170,6 +185,24 @@ FReply SMinesweeperGrid::OnMouseButtonDown(const FGeometry& InMyGeometry, const
 	return FReply::Handled();
 }
 
+FReply SMinesweeperGrid::OnMouseWheel(const FGeometry& InMyGeometry, const FPointerEvent& InMouseEvent)
+{
+	if (!GridCanvas.IsValid()) return FReply::Unhandled();
+
+	// scrolls the view window by a few cells, sideways while shift is held
+	const int32 scrollCells = -FMath::RoundToInt(InMouseEvent.GetWheelDelta() * 3.0f);
+	if (InMouseEvent.IsShiftDown())
+	{
+		GridCanvas->ScrollView(scrollCells, 0);
+	}
+	else
+	{
+		GridCanvas->ScrollView(0, scrollCells);
+	}
+
+	return OnMouseMove(InMyGeometry, InMouseEvent);
+}
+
 void SMinesweeperGrid::OnMouseEnter(const FGeometry& InMyGeometry, const FPointerEvent& InMouseEvent)
 {
 	if (!GridCanvas.IsValid()) return;
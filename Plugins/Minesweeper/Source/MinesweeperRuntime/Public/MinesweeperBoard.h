@@ -0,0 +1,141 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperDifficulty.h"
+
+
+
+
+/**
+ * Rotations and reflections of a board. The first four keep the board dimensions and apply to every board, the rest only to square boards.
+ */
+enum class EMinesweeperBoardSymmetry : uint8
+{
+	Identity,
+	FlipX,
+	FlipY,
+	Rotate180,
+	Rotate90,
+	Rotate270,
+	Transpose,
+	AntiTranspose
+};
+
+
+/**
+ * Mine layout of a Minesweeper grid stored as flat byte planes. Plain data so boards can be generated and analyzed on worker threads.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperBoard
+{
+	/** Width of the board in cells. */
+	int32 Width = 0;
+
+	/** Height of the board in cells. */
+	int32 Height = 0;
+
+	/** Number of mines placed on the board. */
+	int32 MineCount = 0;
+
+	/** 1 for every cell that contains a mine, 0 otherwise. */
+	TArray<uint8> Mines;
+
+	/** Number of mines surrounding each cell. Valid after ComputeNeighborMineCounts(). */
+	TArray<uint8> NeighborMineCounts;
+
+	/**
+	 * Opening id of each cell, valid after ComputeOpenings(). Zero cells hold the id of the opening they belong to,
+	 * numbered cells the id of an opening they border, all other cells 0. Ids start at 1.
+	 */
+	TArray<uint16> OpeningIds;
+
+	/** Start of each opening's cells in OpeningCells, followed by the total. Opening N spans [OpeningCellOffsets[N - 1], OpeningCellOffsets[N]). */
+	TArray<int32> OpeningCellOffsets;
+
+	/** Zero cells and numbered border cells of every opening stored back to back. Border cells are listed once for each opening they touch. */
+	TArray<int32> OpeningCells;
+
+
+	/** Sizes the board for a difficulty and removes all mines. */
+	void Init(const FMinesweeperDifficulty& InDifficulty);
+
+	/** Removes all mines from the board. */
+	void ClearMines();
+
+	/** Recalculates NeighborMineCounts from Mines with a 3x3 box sum over the mine plane, see FMinesweeperSweep::SumNeighbors(). */
+	void ComputeNeighborMineCounts();
+
+	/**
+	 * Labels every opening, a connected region of zero cells plus its numbered border, with a union-find pass. Needs NeighborMineCounts.
+	 * Returns false and leaves the board unlabeled if it has more openings than a uint16 id can hold.
+	 */
+	bool ComputeOpenings();
+
+	/** Removes all opening labels. */
+	void ClearOpenings();
+
+
+	/** Number of symmetries that map the board onto itself: 8 for square boards, 4 for rectangular boards. */
+	FORCEINLINE int32 NumSymmetries() const { return Width == Height ? 8 : 4; }
+
+	/** Returns where a cell of this board ends up after applying a symmetry. */
+	int32 TransformIndex(const EMinesweeperBoardSymmetry InSymmetry, const int32 InCellIndex) const;
+
+	/** Writes this board with a symmetry applied into OutBoard. */
+	void Transform(const EMinesweeperBoardSymmetry InSymmetry, FMinesweeperBoard& OutBoard) const;
+
+	/** Returns the lowest cell index a cell maps to under any symmetry of the board. Cells sharing a canonical index behave identically as a first click. */
+	int32 GetCanonicalCellIndex(const int32 InCellIndex) const;
+
+
+	FORCEINLINE int32 Num() const { return Width * Height; }
+	FORCEINLINE FMinesweeperDifficulty GetDifficulty() const { return FMinesweeperDifficulty(Width, Height, MineCount); }
+
+	FORCEINLINE bool IsValidIndex(const int32 InCellIndex) const { return InCellIndex >= 0 && InCellIndex < Num(); }
+	FORCEINLINE bool IsValidCoord(const int32 InCellX, const int32 InCellY) const { return InCellX >= 0 && InCellY >= 0 && InCellX < Width && InCellY < Height; }
+	FORCEINLINE int32 CoordToIndex(const int32 InCellX, const int32 InCellY) const { return (Width * InCellY) + InCellX; }
+	FORCEINLINE FIntVector2 IndexToCoord(const int32 InCellIndex) const { return FIntVector2(InCellIndex % Width, InCellIndex / Width); }
+
+	FORCEINLINE bool HasMine(const int32 InCellIndex) const { return Mines[InCellIndex] != 0; }
+	FORCEINLINE int32 GetNeighborMineCount(const int32 InCellIndex) const { return NeighborMineCounts[InCellIndex]; }
+
+	/** True if the cell is safe and has no neighboring mines, so opening it opens its whole opening. */
+	FORCEINLINE bool IsZeroCell(const int32 InCellIndex) const { return Mines[InCellIndex] == 0 && NeighborMineCounts[InCellIndex] == 0; }
+
+	FORCEINLINE bool HasOpeningLabels() const { return Num() > 0 && OpeningIds.Num() == Num(); }
+	FORCEINLINE int32 GetNumOpenings() const { return FMath::Max(OpeningCellOffsets.Num() - 1, 0); }
+	FORCEINLINE int32 GetOpeningId(const int32 InCellIndex) const { return OpeningIds[InCellIndex]; }
+
+	/** Returns the zero cells and numbered border cells of an opening. */
+	FORCEINLINE TArrayView<const int32> GetOpeningCells(const int32 InOpeningId) const
+	{
+		const int32 startIndex = OpeningCellOffsets[InOpeningId - 1];
+		return MakeArrayView(OpeningCells.GetData() + startIndex, OpeningCellOffsets[InOpeningId] - startIndex);
+	}
+
+
+	/** Calls InFunc(NeighborIndex) for each of the up to 8 cells surrounding a cell. */
+	template <typename FuncType>
+	FORCEINLINE void ForEachNeighbor(const int32 InCellIndex, FuncType&& InFunc) const
+	{
+		const int32 cellX = InCellIndex % Width;
+		const int32 cellY = InCellIndex / Width;
+		const int32 minX = FMath::Max(cellX - 1, 0);
+		const int32 maxX = FMath::Min(cellX + 1, Width - 1);
+		const int32 minY = FMath::Max(cellY - 1, 0);
+		const int32 maxY = FMath::Min(cellY + 1, Height - 1);
+
+		for (int32 y = minY; y <= maxY; ++y)
+		{
+			for (int32 x = minX; x <= maxX; ++x)
+			{
+				const int32 neighborIndex = (Width * y) + x;
+				if (neighborIndex != InCellIndex)
+				{
+					InFunc(neighborIndex);
+				}
+			}
+		}
+	}
+
+};
@@ -0,0 +1,99 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperDifficulty.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperRandom.h"
+#include "MinesweeperBoardGenerator.generated.h"
+
+class FMinesweeperLatencyTracker;
+
+
+
+
+/**
+ * How mines are placed when a new game is started.
+ */
+UENUM(BlueprintType)
+enum class EMinesweeperGenerationMode : uint8
+{
+	/** Mines are placed randomly anywhere except the first clicked cell. */
+	Random,
+
+	/** Only boards that can be cleared by pure logic from the first click are accepted. */
+	NoGuess,
+
+	/**
+	 * Mines are defined by a hash of seed and cell coordinate instead of a stored board, so grids far larger than the standard maximum
+	 * can be played in constant memory. Mine count is treated as a density over the grid and the game has no win condition.
+	 * The board generator treats it like Random.
+	 */
+	Endless
+};
+
+
+/**
+ * Input settings for generating a single board.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperGenerationParams
+{
+	FMinesweeperDifficulty Difficulty;
+
+	/** The cell the player clicked first. This cell never contains a mine. */
+	int32 FirstClickIndex = 0;
+
+	/** Boards are reproducible bit for bit from seed, difficulty and first click on every platform. */
+	int32 Seed = 0;
+
+	EMinesweeperGenerationMode Mode = EMinesweeperGenerationMode::Random;
+
+	/** Maximum candidate boards tried in no-guess mode before falling back to a random board. */
+	int32 MaxAttempts = 20000;
+
+	/** Worker threads used for no-guess generation. 0 uses all available task graph workers. */
+	int32 NumWorkers = 0;
+};
+
+
+/**
+ * Outcome of generating a single board.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperGenerationResult
+{
+	/** False if no candidate satisfied the generation mode and a random board was used instead. */
+	bool bSuccess = false;
+
+	/** Number of candidate boards generated and verified. */
+	int32 Attempts = 0;
+
+	/** Wall clock time spent generating in seconds. */
+	double Seconds = 0.0;
+};
+
+
+/**
+ * Generates Minesweeper boards. All functions are thread safe.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperBoardGenerator
+{
+public:
+	/** Generates a board for the params. No-guess candidates are generated and verified on multiple workers and the first success stops all workers. */
+	static FMinesweeperGenerationResult Generate(const FMinesweeperGenerationParams& InParams, FMinesweeperBoard& OutBoard);
+
+	/**
+	 * Randomly places mines on the board. The first click cell, and its neighbors if bInClearNeighbors is set and there is room for all mines, stay free.
+	 * @param InOutScratch Reused storage for candidate cells to avoid allocations when generating many boards.
+	 */
+	static void PlaceMines(FMinesweeperBoard& OutBoard, const FMinesweeperDifficulty& InDifficulty, const int32 InFirstClickIndex, const bool bInClearNeighbors, FMinesweeperRandomStream& InRandStream, TArray<int32>& InOutScratch);
+
+	/** Returns the random stream for one generation attempt. Every attempt of every (seed, difficulty, first click) gets an independent stream. */
+	static FMinesweeperRandomStream MakeAttemptStream(const FMinesweeperGenerationParams& InParams, const int32 InAttemptIndex);
+
+	/** Returns true if opening the first click cell and applying deterministic logic rules clears every safe cell on the board. */
+	static bool IsSolvableWithoutGuessing(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex);
+
+	/** Latency of every Generate() call made in this session. */
+	static FMinesweeperLatencyTracker& GetLatencyTracker();
+
+};
@@ -0,0 +1,52 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperBoard.h"
+
+
+
+
+/**
+ * 128 bit hash of a board's dimensions and bit-packed mine layout.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperBoardHash
+{
+	/** Number of characters in a short code. */
+	static const int32 ShortCodeLength = 12;
+
+	uint64 Low = 0;
+	uint64 High = 0;
+
+
+	/** Hash of the board exactly as laid out. */
+	static FMinesweeperBoardHash Compute(const FMinesweeperBoard& InBoard);
+
+	/**
+	 * Hash of the board's canonical form: the smallest bit-packed layout over all symmetries that keep it a valid board of the same shape,
+	 * 8 for square boards and 4 for rectangular ones. Boards that are rotations or reflections of each other share a canonical hash.
+	 * @param OutSymmetry Optional, receives the symmetry that turns this board into its canonical form.
+	 */
+	static FMinesweeperBoardHash ComputeCanonical(const FMinesweeperBoard& InBoard, EMinesweeperBoardSymmetry* OutSymmetry = nullptr);
+
+	/** MurmurHash3 x64 128 over a block of bytes. */
+	static FMinesweeperBoardHash HashBytes(const uint8* InData, const int32 InNumBytes, const uint64 InSeed = 0);
+
+
+	/** Returns the lowest 60 bits as 12 Crockford base32 characters, for sharing boards. */
+	FString ToShortCode() const;
+
+	/** Parses a short code into the 60 bit key it encodes. Case insensitive, and O, I and L are read as 0, 1 and 1. */
+	static bool ParseShortCode(const FString& InCode, uint64& OutShortKey);
+
+	/** The bits of the hash a short code holds. */
+	FORCEINLINE uint64 GetShortKey() const { return Low & ((1ull << (5 * ShortCodeLength)) - 1); }
+
+
+	FORCEINLINE bool IsZero() const { return Low == 0 && High == 0; }
+
+	FORCEINLINE bool operator == (const FMinesweeperBoardHash& InOther) const { return Low == InOther.Low && High == InOther.High; }
+	FORCEINLINE bool operator != (const FMinesweeperBoardHash& InOther) const { return !(*this == InOther); }
+
+	friend FORCEINLINE uint32 GetTypeHash(const FMinesweeperBoardHash& InHash) { return (uint32)InHash.Low; }
+};
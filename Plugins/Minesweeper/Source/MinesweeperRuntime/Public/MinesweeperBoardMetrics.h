@@ -0,0 +1,58 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperBoardMetrics.generated.h"
+
+
+
+
+/**
+ * Difficulty metrics of a generated board.
+ */
+USTRUCT(BlueprintType)
+struct MINESWEEPERRUNTIME_API FMinesweeperBoardMetrics
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Bechtel's Board Benchmark Value: the minimum number of left clicks needed to clear the board without chording. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MinesweeperBoardMetrics")
+		int32 ThreeBV = 0;
+
+	/** Number of connected zero regions, each cleared by a single click. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MinesweeperBoardMetrics")
+		int32 Openings = 0;
+
+	/** Number of connected groups of numbered cells that do not border an opening. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MinesweeperBoardMetrics")
+		int32 Islands = 0;
+
+	/** Estimated minimum number of clicks to clear the board with flags and chords, from the greedy ZiNi estimator. 0 if not estimated. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MinesweeperBoardMetrics")
+		int32 ZiNi = 0;
+
+	/** Number of cells without a mine. */
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "MinesweeperBoardMetrics")
+		int32 SafeCells = 0;
+
+
+	/**
+	 * Computes the metrics in linear time from the board's opening labels. Boards without labels are labeled on a copy first,
+	 * so label boards up front with FMinesweeperBoard::ComputeOpenings() when computing metrics in bulk.
+	 */
+	static FMinesweeperBoardMetrics Compute(const FMinesweeperBoard& InBoard);
+
+	/**
+	 * Greedy ZiNi: clicks every opening, then repeatedly chords the numbered cell with the highest premium (cells revealed minus flags
+	 * placed minus the chord click), and clicks a remaining cell directly when no chord saves clicks. Uses the board's opening labels.
+	 */
+	static int32 EstimateZiNi(const FMinesweeperBoard& InBoard);
+
+	/**
+	 * Computes metrics for many boards on worker threads. Boards should already carry opening labels.
+	 * @param InNumWorkers Worker threads to split the boards over. 0 uses all available task graph workers.
+	 */
+	static void ComputeBatch(TArrayView<const FMinesweeperBoard> InBoards, TArrayView<FMinesweeperBoardMetrics> OutMetrics, const bool bInEstimateZiNi = true, const int32 InNumWorkers = 0);
+
+};
@@ -0,0 +1,110 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperDifficulty.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperBoardGenerator.h"
+#include "Tasks/Task.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+
+
+
+/**
+ * Keeps a small number of pre-generated boards per difficulty, generation mode and first click class so expensive boards are ready on the first click.
+ * Boards are generated for the canonical cell of a click class and rotated or mirrored onto the actual clicked cell when taken.
+ * Refills run asynchronously as background tasks. Thread safe.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperBoardPool
+{
+public:
+	/** Number of ready boards kept per difficulty, mode and click class. */
+	static const int32 BoardsPerClass = 2;
+
+	/** Maximum number of click classes tracked across all difficulties. The least recently requested class is dropped first. */
+	static const int32 MaxClasses = 32;
+
+
+	static FMinesweeperBoardPool& Get();
+
+	~FMinesweeperBoardPool();
+
+
+	/**
+	 * Takes a ready board matching the params, transformed so InParams.FirstClickIndex is the safe first click.
+	 * Returns false on a miss, in which case the caller generates the board itself. Hits and misses both schedule a refill.
+	 */
+	bool TryTake(const FMinesweeperGenerationParams& InParams, FMinesweeperBoard& OutBoard);
+
+	/** Starts filling the pool for a first click cell ahead of time. */
+	void Prefetch(const FMinesweeperDifficulty& InDifficulty, const EMinesweeperGenerationMode InMode, const int32 InFirstClickIndex);
+
+	/** Stops all refills and waits for running ones to finish. Called on module shutdown. */
+	void Shutdown();
+
+
+	/** Fraction of TryTake() calls that returned a ready board. */
+	float GetHitRate() const;
+
+	FORCEINLINE int32 GetNumHits() const { return NumHits.load(); }
+	FORCEINLINE int32 GetNumMisses() const { return NumMisses.load(); }
+
+
+private:
+	FMinesweeperBoardPool();
+
+	struct FPoolKey
+	{
+		FMinesweeperDifficulty Difficulty;
+		EMinesweeperGenerationMode Mode = EMinesweeperGenerationMode::Random;
+		int32 CanonicalCellIndex = 0;
+
+		bool operator == (const FPoolKey& InOther) const
+		{
+			return Difficulty == InOther.Difficulty && Mode == InOther.Mode && CanonicalCellIndex == InOther.CanonicalCellIndex;
+		}
+
+		friend uint32 GetTypeHash(const FPoolKey& InKey)
+		{
+			uint32 hash = HashCombine(GetTypeHash(InKey.Difficulty.Width), GetTypeHash(InKey.Difficulty.Height));
+			hash = HashCombine(hash, GetTypeHash(InKey.Difficulty.MineCount));
+			hash = HashCombine(hash, GetTypeHash((uint8)InKey.Mode));
+			return HashCombine(hash, GetTypeHash(InKey.CanonicalCellIndex));
+		}
+	};
+
+	struct FPoolEntry
+	{
+		TArray<FMinesweeperBoard> ReadyBoards;
+		bool bRefillInFlight = false;
+		double LastRequestTime = 0.0;
+	};
+
+
+	FPoolKey MakeKey(const FMinesweeperDifficulty& InDifficulty, const EMinesweeperGenerationMode InMode, const int32 InFirstClickIndex) const;
+
+	/** Adds an entry for the key if needed and launches a refill task when it is not full. Must be called with PoolLock held. */
+	void RequestRefill_Locked(const FPoolKey& InKey);
+
+	void EvictOldestEntry_Locked();
+
+	void Refill(const FPoolKey InKey);
+
+
+	mutable FCriticalSection PoolLock;
+
+	TMap<FPoolKey, FPoolEntry> Entries;
+
+	TArray<UE::Tasks::FTask> RefillTasks;
+
+	/** Source of seeds for background boards, separate from game seeds. */
+	std::atomic<int32> NextSeed { 0 };
+
+	std::atomic<bool> bIsShutdown { false };
+
+	std::atomic<int32> NumHits { 0 };
+	std::atomic<int32> NumMisses { 0 };
+
+};
@@ -0,0 +1,78 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperBoardRating.generated.h"
+
+
+
+
+/**
+ * Difficulty of a board by the solver work it takes to clear it from its first click, next to the click counts of FMinesweeperBoardMetrics.
+ */
+USTRUCT(BlueprintType)
+struct MINESWEEPERRUNTIME_API FMinesweeperBoardRating
+{
+	GENERATED_USTRUCT_BODY()
+
+	/** Times logic runs out before the board is cleared, each needing a guess. 0 for boards that can be cleared without guessing. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperBoardRating")
+		int32 Guesses = 0;
+
+	/** Frontier cells in the largest component whose solutions had to be enumerated, 0 if the rules alone clear the board. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperBoardRating")
+		int32 MaxComponentSize = 0;
+
+	/**
+	 * Hardest reasoning the board needs: 1 single point, 2 subset, 3 line patterns, 4 the global mine count, 5 enumerating solutions.
+	 * 0 if the first click clears the board.
+	 */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperBoardRating")
+		int32 DeductionDepth = 0;
+
+
+	/** Deduction depth of boards that need solutions enumerated, one past the hardest solver rule. */
+	static const int32 EnumerationDepth = FMinesweeperSolver::GlobalRule + 1;
+
+	/** True if every field lies within the fields of InMin and InMax. */
+	FORCEINLINE bool IsWithin(const FMinesweeperBoardRating& InMin, const FMinesweeperBoardRating& InMax) const
+	{
+		return Guesses >= InMin.Guesses && Guesses <= InMax.Guesses
+			&& MaxComponentSize >= InMin.MaxComponentSize && MaxComponentSize <= InMax.MaxComponentSize
+			&& DeductionDepth >= InMin.DeductionDepth && DeductionDepth <= InMax.DeductionDepth;
+	}
+
+};
+
+
+/**
+ * Rates boards by playing them like a player who never guesses blindly: the solver rules first, then exact probabilities when the rules
+ * are stuck, opening a cell with no chance of a mine. Only when there is none it guesses, opening the safest cell that is free of a mine,
+ * as if the guess came off, so every board is rated through to the end.
+ *
+ * Keeps its solver, frontier and probability engine between boards. Plain data, one instance per thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperBoardRater
+{
+public:
+	/** Rates a board with opening labels from a first click. */
+	FMinesweeperBoardRating Rate(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex);
+
+	/**
+	 * Rates many boards on worker threads, one rater per worker.
+	 * @param InNumWorkers Worker threads to split the boards over. 0 uses all available task graph workers.
+	 */
+	static void RateBatch(TArrayView<const FMinesweeperBoard> InBoards, TArrayView<const int32> InFirstClickIndices, TArrayView<FMinesweeperBoardRating> OutRatings, const int32 InNumWorkers = 0);
+
+
+private:
+	FMinesweeperSolver Solver;
+	FMinesweeperFrontier Frontier;
+	FMinesweeperProbabilityEngine ProbabilityEngine;
+
+};
+
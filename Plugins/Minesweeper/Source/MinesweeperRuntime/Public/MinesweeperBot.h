@@ -0,0 +1,76 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperGuess.h"
+
+class UMinesweeperGame;
+
+
+
+
+/**
+ * Outcome of one game played by the bot.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperBotResult
+{
+	bool bWon = false;
+
+	/** Cells clicked, including the first click and the losing click. */
+	int32 NumMoves = 0;
+
+	/** Clicks on a cell that might hold a mine. Cells proven safe by the rules or by enumerating solutions are no guess. */
+	int32 NumGuesses = 0;
+
+	/** Wall clock time spent playing in seconds. */
+	double Seconds = 0.0;
+};
+
+
+/**
+ * Plays Minesweeper without a player or a viewport. Opens every cell the solver proves safe, and when logic is stuck opens the
+ * guess FMinesweeperGuessEvaluator picks, or the closed cell with the lowest exact mine probability if guess search is off.
+ *
+ * Play() works on a board directly and is safe to run on worker threads with one bot per thread. PlayGame() drives a game object
+ * through its public API and must run on the game thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperBot
+{
+public:
+	/** Plays a board with opening labels from the first click until it is won or a mine is opened. */
+	FMinesweeperBotResult Play(const FMinesweeperBoard& InBoard, const int32 InFirstClickIndex);
+
+	/**
+	 * Plays a game that has been set up but not started, from the first click until it ends. Endless games are not played.
+	 * The game is ticked by InSecondsPerMove after every click in place of the frames a player would take.
+	 */
+	static FMinesweeperBotResult PlayGame(UMinesweeperGame* InGame, const int32 InFirstCellX, const int32 InFirstCellY, const float InSecondsPerMove = 0.1f,
+		const bool bInUseGuessSearch = true);
+
+	/** Returns the closed, unflagged cell with the lowest mine probability, the lowest index on ties. INDEX_NONE if there is none. */
+	static int32 FindBestGuess(const FMinesweeperFrontier& InFrontier, const FMinesweeperProbabilityEngine& InProbabilityEngine);
+
+	/** Picks guesses with FMinesweeperGuessEvaluator rather than by mine probability alone. On by default. */
+	FORCEINLINE void SetUseGuessSearch(const bool bInUseGuessSearch) { bUseGuessSearch = bInUseGuessSearch; }
+
+	/** Limits of the guess search. Play() always searches on the calling thread. */
+	FORCEINLINE void SetGuessSettings(const FMinesweeperGuessSettings& InGuessSettings) { GuessSettings = InGuessSettings; }
+
+
+private:
+	/** Opens a cell that holds no mine, together with the rest of its opening if it is a zero cell. */
+	void RevealCell(const FMinesweeperBoard& InBoard, const int32 InCellIndex);
+
+
+	FMinesweeperSolver Solver;
+	FMinesweeperFrontier Frontier;
+	FMinesweeperProbabilityEngine ProbabilityEngine;
+
+	FMinesweeperGuessSettings GuessSettings;
+	bool bUseGuessSearch = true;
+
+};
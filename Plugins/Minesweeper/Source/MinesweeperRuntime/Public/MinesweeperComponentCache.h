@@ -0,0 +1,93 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "HAL/CriticalSection.h"
+#include <atomic>
+
+
+
+
+/**
+ * Enumerated solution counts of one frontier component, independent of where on the board the component was found.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperComponentCacheEntry
+{
+	/** Offsets of the component's cells from its lowest cell index, ascending. */
+	TArray<int32> CellOffsets;
+
+	/** Solutions with more mines than this were not counted. */
+	int32 MaxMines = 0;
+
+	/** Number of solutions with k mines, for k in [0, CellOffsets.Num()]. */
+	TArray<double> SolutionCounts;
+
+	/** Number of solutions with k mines that put a mine on each cell, in CellOffsets order, (CellOffsets.Num() + 1) slots per cell. */
+	TArray<double> CellMineCounts;
+
+	SIZE_T GetAllocatedSize() const
+	{
+		return sizeof(*this) + CellOffsets.GetAllocatedSize() + SolutionCounts.GetAllocatedSize() + CellMineCounts.GetAllocatedSize();
+	}
+};
+
+
+/**
+ * Transposition cache of enumerated frontier components, keyed by a Zobrist style hash of the component's constraints. Bots, hints and
+ * generators meet the same local number patterns over and over, within a game where most components survive a click unchanged and
+ * across games where small patterns repeat anywhere on the board. Bounded by memory, the oldest entries are evicted first. Thread safe.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperComponentCache
+{
+public:
+	static const SIZE_T DefaultMaxBytes = 32 * 1024 * 1024;
+
+	static FMinesweeperComponentCache& Get();
+
+
+	/** Copies the entry for a hash if it counts solutions with up to InMaxMines mines. Counts a hit or a miss. */
+	bool Find(const uint64 InHash, const int32 InMaxMines, FMinesweeperComponentCacheEntry& OutEntry);
+
+	/** Adds or widens the entry for a hash and evicts the oldest entries beyond the memory cap. */
+	void Add(const uint64 InHash, FMinesweeperComponentCacheEntry&& InEntry);
+
+	/** Removes every entry and resets the hit counters. */
+	void Reset();
+
+
+	/** Sets the memory cap and evicts entries beyond it right away. */
+	void SetMaxBytes(const SIZE_T InMaxBytes);
+
+	SIZE_T GetMaxBytes() const;
+	SIZE_T GetAllocatedBytes() const;
+	int32 Num() const;
+
+	/** Fraction of Find() calls that returned an entry. */
+	float GetHitRate() const;
+
+	FORCEINLINE int64 GetNumHits() const { return NumHits.load(); }
+	FORCEINLINE int64 GetNumMisses() const { return NumMisses.load(); }
+
+
+private:
+	FMinesweeperComponentCache() = default;
+
+	/** Evicts the oldest entries until the cache fits its memory cap. Must be called with the write lock held. */
+	void Trim_Locked();
+
+
+	mutable FRWLock CacheLock;
+
+	TMap<uint64, FMinesweeperComponentCacheEntry> Entries;
+
+	/** Hashes in the order they were added. Entries before OldestInsertion have been evicted. */
+	TArray<uint64> InsertionOrder;
+	int32 OldestInsertion = 0;
+
+	SIZE_T AllocatedBytes = 0;
+	SIZE_T MaxBytes = DefaultMaxBytes;
+
+	std::atomic<int64> NumHits { 0 };
+	std::atomic<int64> NumMisses { 0 };
+
+};
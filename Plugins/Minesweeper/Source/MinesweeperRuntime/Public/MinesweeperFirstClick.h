@@ -0,0 +1,126 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperDifficulty.h"
+
+
+
+
+/**
+ * File header of a first click table, followed directly by NumEntries FMinesweeperFirstClickEntry. All values are little endian.
+ */
+struct FMinesweeperFirstClickFileHeader
+{
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 NumEntries = 0;
+	uint32 Reserved = 0;
+};
+
+/**
+ * Simulated first click of one difficulty.
+ */
+struct FMinesweeperFirstClickEntry
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 MineCount = 0;
+
+	/** Cell the solver bot won most often from. */
+	uint16 BestCellIndex = 0;
+
+	/** Cell most likely to open a zero, the top left corner. */
+	uint16 OpeningCellIndex = 0;
+
+	/** Fraction of games the bot won from BestCellIndex. */
+	float WinRate = 0.0f;
+
+	/** Chance BestCellIndex opens a zero. */
+	float BestCellOpeningProbability = 0.0f;
+
+	/** Chance OpeningCellIndex opens a zero, the highest of any cell. */
+	float OpeningCellOpeningProbability = 0.0f;
+
+	/** Games simulated from every cell of the difficulty. */
+	uint32 NumGamesPerCell = 0;
+};
+
+static_assert(sizeof(FMinesweeperFirstClickFileHeader) == 16, "First click table header layout changed.");
+static_assert(sizeof(FMinesweeperFirstClickEntry) == 32, "First click table entry layout changed.");
+
+namespace MinesweeperFirstClickTable
+{
+	/** "MSFC" */
+	static const uint32 Magic = 0x4346534D;
+	static const uint32 Version = 1;
+}
+
+
+/**
+ * First click recommended for a difficulty.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperFirstClick
+{
+	/** Cell to open first, INDEX_NONE for an empty board. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** Chance the cell opens a zero, and with it an opening. */
+	float OpeningProbability = 0.0f;
+
+	/** Fraction of simulated games the solver bot won from the cell, -1 if the difficulty is not in the table. */
+	float WinRate = -1.0f;
+
+	FORCEINLINE bool IsSimulated() const { return WinRate >= 0.0f; }
+};
+
+
+/**
+ * First clicks with the best win rate for each difficulty, simulated offline by the MinesweeperFirstClick commandlet and shipped
+ * with the plugin in Resources. Difficulties missing from the table get the cell most likely to open a zero, a corner, so callers
+ * never search at runtime.
+ *
+ * The shipped table is loaded on first use. Thread safe, except for Load().
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperFirstClickTable
+{
+public:
+	static FMinesweeperFirstClickTable& Get();
+
+	/** Returns the first click for a difficulty, from the table in O(1) or from the opening probability otherwise. */
+	FMinesweeperFirstClick Find(const FMinesweeperDifficulty& InDifficulty) const;
+
+	/** Replaces the table with the contents of a file. Returns false and keeps the table empty if the file is missing or invalid. */
+	bool Load(const FString& InFilename);
+
+	FORCEINLINE int32 Num() const { return Entries.Num(); }
+
+	/** Writes a table file. Returns false if the file could not be written. */
+	static bool Save(const FString& InFilename, TArrayView<const FMinesweeperFirstClickEntry> InEntries);
+
+	/** Location of the table shipped with the plugin. */
+	static FString GetDefaultFilename();
+
+	/**
+	 * Chance that a first click opens a zero. Mines are placed after the first click on any other cell, so every neighbor must be
+	 * left free: C(others - neighbors, mines) / C(others, mines).
+	 */
+	static float ComputeOpeningProbability(const FMinesweeperDifficulty& InDifficulty, const int32 InCellIndex);
+
+	/**
+	 * Returns the cell with the highest opening probability in O(1): the top left corner, which has the fewest neighbors of any cell and so
+	 * the fewest that must be free. Other corners tie with it. INDEX_NONE for an empty board.
+	 */
+	static int32 FindBestOpeningCell(const FMinesweeperDifficulty& InDifficulty);
+
+
+private:
+	static FORCEINLINE uint64 MakeKey(const int32 InWidth, const int32 InHeight, const int32 InMineCount)
+	{
+		return ((uint64)(uint16)InWidth << 48) | ((uint64)(uint16)InHeight << 32) | (uint32)InMineCount;
+	}
+
+	TMap<uint64, FMinesweeperFirstClickEntry> Entries;
+
+};
+
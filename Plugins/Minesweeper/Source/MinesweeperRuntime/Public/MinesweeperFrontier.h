@@ -0,0 +1,176 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+
+/**
+ * Set of cell indices with constant time add, remove and membership tests and dense iteration (Briggs and Torczon sparse set).
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperCellSet
+{
+public:
+	/** Sizes the set for a number of cells and empties it. */
+	void Init(const int32 InNumCells)
+	{
+		Positions.Init(INDEX_NONE, InNumCells);
+		Cells.Reset();
+	}
+
+	/** Empties the set in time proportional to its size. */
+	void Reset()
+	{
+		for (const int32 cellIndex : Cells)
+		{
+			Positions[cellIndex] = INDEX_NONE;
+		}
+		Cells.Reset();
+	}
+
+	FORCEINLINE bool Contains(const int32 InCellIndex) const { return Positions[InCellIndex] != INDEX_NONE; }
+
+	FORCEINLINE void Add(const int32 InCellIndex)
+	{
+		if (Contains(InCellIndex)) return;
+
+		Positions[InCellIndex] = Cells.Add(InCellIndex);
+	}
+
+	FORCEINLINE void Remove(const int32 InCellIndex)
+	{
+		const int32 position = Positions[InCellIndex];
+		if (position == INDEX_NONE) return;
+
+		const int32 lastCellIndex = Cells.Last();
+		Cells[position] = lastCellIndex;
+		Positions[lastCellIndex] = position;
+		Cells.Pop(false);
+		Positions[InCellIndex] = INDEX_NONE;
+	}
+
+	FORCEINLINE int32 Num() const { return Cells.Num(); }
+
+	/** Cells in no particular order. Invalidated by Add() and Remove(). */
+	FORCEINLINE TArrayView<const int32> GetCells() const { return Cells; }
+
+
+private:
+	TArray<int32> Cells;
+
+	/** Position of each cell in Cells, INDEX_NONE if it is not in the set. */
+	TArray<int32> Positions;
+
+};
+
+
+/**
+ * The boundary between opened and closed cells of a game, updated from each changed cell in constant time.
+ *
+ * Closed cells are the unflagged closed cells next to at least one opened cell. Active numbers are the opened cells that still
+ * have closed unflagged neighbors. Every opened cell also keeps its remaining mines (number minus flagged neighbors) and remaining
+ * unknowns (closed unflagged neighbors), so analysis never has to look at cells away from the frontier. Flags are taken as placed
+ * by the player and may be wrong, in which case remaining mines can drop below zero.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperFrontier
+{
+public:
+	/** Sizes the frontier for a board with every cell closed. Reuses allocations when the size does not change. */
+	void Init(const int32 InWidth, const int32 InHeight);
+
+	/** Closes every cell again. */
+	void Reset();
+
+	/** Opens a closed or flagged cell showing InNeighborMineCount. */
+	void OpenCell(const int32 InCellIndex, const int32 InNeighborMineCount);
+
+	/** Flags or unflags a closed cell. */
+	void SetFlagged(const int32 InCellIndex, const bool bInFlagged);
+
+
+	/** Closed unflagged cells next to at least one opened cell. */
+	FORCEINLINE const FMinesweeperCellSet& GetClosedCells() const { return ClosedCells; }
+
+	/** Opened cells with at least one closed unflagged neighbor. */
+	FORCEINLINE const FMinesweeperCellSet& GetActiveNumbers() const { return ActiveNumbers; }
+
+	FORCEINLINE bool IsOpened(const int32 InCellIndex) const { return States[InCellIndex] == Opened; }
+	FORCEINLINE bool IsFlagged(const int32 InCellIndex) const { return States[InCellIndex] == Flagged; }
+
+	/** Number of an opened cell minus its flagged neighbors. */
+	FORCEINLINE int32 GetRemainingMines(const int32 InCellIndex) const { return RemainingMines[InCellIndex]; }
+
+	/** Closed unflagged neighbors of an opened cell. */
+	FORCEINLINE int32 GetRemainingUnknowns(const int32 InCellIndex) const { return RemainingUnknowns[InCellIndex]; }
+
+	FORCEINLINE int32 GetWidth() const { return Width; }
+	FORCEINLINE int32 GetHeight() const { return Height; }
+	FORCEINLINE int32 Num() const { return Width * Height; }
+
+	FORCEINLINE int32 NumOpenedCells() const { return NumOpened; }
+	FORCEINLINE int32 NumFlaggedCells() const { return NumFlagged; }
+
+
+	/** Calls InFunc(NeighborIndex) for each of the up to 8 cells surrounding a cell. */
+	template <typename FuncType>
+	FORCEINLINE void ForEachNeighbor(const int32 InCellIndex, FuncType&& InFunc) const
+	{
+		const int32 cellX = InCellIndex % Width;
+		const int32 cellY = InCellIndex / Width;
+		for (int32 y = FMath::Max(cellY - 1, 0); y <= FMath::Min(cellY + 1, Height - 1); ++y)
+		{
+			for (int32 x = FMath::Max(cellX - 1, 0); x <= FMath::Min(cellX + 1, Width - 1); ++x)
+			{
+				const int32 neighborIndex = (Width * y) + x;
+				if (neighborIndex != InCellIndex)
+				{
+					InFunc(neighborIndex);
+				}
+			}
+		}
+	}
+
+
+private:
+	enum ECellState : uint8
+	{
+		Closed = 0,
+		Flagged = 1,
+		Opened = 2
+	};
+
+	/** Moves an opened cell in or out of ActiveNumbers after its remaining unknowns changed. */
+	FORCEINLINE void UpdateActiveNumber(const int32 InCellIndex)
+	{
+		if (RemainingUnknowns[InCellIndex] > 0) ActiveNumbers.Add(InCellIndex);
+		else ActiveNumbers.Remove(InCellIndex);
+	}
+
+	/** Moves a cell in or out of ClosedCells after its state or opened neighbors changed. */
+	FORCEINLINE void UpdateClosedCell(const int32 InCellIndex)
+	{
+		if (States[InCellIndex] == Closed && OpenedNeighbors[InCellIndex] > 0) ClosedCells.Add(InCellIndex);
+		else ClosedCells.Remove(InCellIndex);
+	}
+
+
+	int32 Width = 0;
+	int32 Height = 0;
+
+	/** ECellState of each cell. */
+	TArray<uint8> States;
+
+	/** Opened neighbors of each cell. */
+	TArray<uint8> OpenedNeighbors;
+
+	TArray<int8> RemainingMines;
+	TArray<uint8> RemainingUnknowns;
+
+	FMinesweeperCellSet ClosedCells;
+	FMinesweeperCellSet ActiveNumbers;
+
+	int32 NumOpened = 0;
+	int32 NumFlagged = 0;
+
+};
@@ -4,8 +4,20 @@
 #include "CoreMinimal.h"
 #include "UObject/NoExportTypes.h"
 #include "MinesweeperDifficulty.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperBoardGenerator.h"
+#include "MinesweeperHashedMineField.h"
+#include "MinesweeperBoardMetrics.h"
+#include "MinesweeperBoardRating.h"
+#include "MinesweeperBoardHash.h"
+#include "MinesweeperSolver.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+#include "MinesweeperHintService.h"
 #include "MinesweeperGame.generated.h"
 
+class FMinesweeperPuzzleDatabase;
+
 
 
 
@@ -48,6 +60,11 @@ struct MINESWEEPERRUNTIME_API FMinesweeperCell
 DECLARE_MULTICAST_DELEGATE_ThreeParams(FMinesweeperGameOverDelegated, const bool, const float, const int32);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_ThreeParams(FMinesweeperGameOverDelegate, const bool, Won, const float, Time, const int32, Clicks);
 
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_FourParams(FMinesweeperHintDelegate, const int32, CellX, const int32, CellY, const bool, IsSafe, const float, MineProbability);
+
+/** Indices of the cells opened or flagged by one action. */
+DECLARE_MULTICAST_DELEGATE_OneParam(FMinesweeperCellsChangedDelegate, TArrayView<const int32>);
+
 
 /**
  * Minesweeper game logic.
@@ -64,6 +81,19 @@ public:
 	static const int32 MinMineCount = 1;
 	static const int32 MaxMineCount = 400;
 
+	/** Largest side length of an endless grid. Cell indices are int32, so the grid must stay below 2^31 cells. */
+	static const int32 MaxEndlessGridSize = 46340;
+
+	/**
+	 * Bounds of the mine density of endless games. The mine count of the difficulty is meaningless on an endless grid, and below about 10%
+	 * the zero cells join up into openings that span the whole grid.
+	 */
+	static constexpr float MinEndlessMineDensity = 0.12f;
+	static constexpr float MaxEndlessMineDensity = 0.5f;
+
+	/** Most cells one click opens on an endless grid. Clicking an opened zero cell at the edge of a cut off opening carries on from there. */
+	static const int32 MaxEndlessOpenCells = 65536;
+
 
 	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
 		void SetupGame(const FMinesweeperDifficulty& InDifficulty);
@@ -87,6 +117,12 @@ public:
 	//UPROPERTY(BlueprintAssignable, Category = "Minesweeper")
 		FMinesweeperGameOverDelegated OnGameOvered;
 
+	/** Broadcast once after every action with the cells it opened or flagged. */
+	FMinesweeperCellsChangedDelegate OnCellsChanged;
+
+	/** Broadcast after a probability update with the cells whose mine probability moved noticeably since they were last broadcast. */
+	FMinesweeperCellsChangedDelegate OnMineProbabilitiesChanged;
+
 
 	UFUNCTION(BlueprintPure, Category = "Minesweeper")
 		FORCEINLINE FMinesweeperDifficulty GetDifficulty() const { return Difficulty; }
@@ -120,7 +156,7 @@ public:
 		FORCEINLINE bool IsGameOver() const { return !IsActive && GameTime > 0.0f; }
 
 	UFUNCTION(BlueprintPure, Category = "Minesweeper")
-		FORCEINLINE bool HasWon() const { return GameTime > 0.0f && NumClosedCells == Difficulty.MineCount; }
+		FORCEINLINE bool HasWon() const { return GameTime > 0.0f && !IsEndless() && NumClosedCells == Difficulty.MineCount; }
 
 
 	UFUNCTION(BlueprintPure, Category = "Minesweeper")
@@ -131,6 +167,175 @@ public:
 		FORCEINLINE int32 GetFlagsRemaining() const { return FlagsRemaining; }
 
 
+	/** Opens the puzzle database used by FindRandomPuzzle() and SetupPuzzle(). The file is memory mapped, not loaded. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool OpenPuzzleDatabase(const FString& Filename);
+
+	/** Returns a random puzzle id of a difficulty with 3BV in [MinThreeBV, MaxThreeBV], or -1 if the open database has none. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		int64 FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bNoGuess, const int32 MinThreeBV, const int32 MaxThreeBV);
+
+	/**
+	 * Returns a random puzzle id like FindRandomPuzzle(), limited to boards whose solver effort rating lies within [MinRating, MaxRating]
+	 * field by field. Ratings are stored in the database, nothing is analyzed. Returns -1 if no puzzle matches.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		int64 FindRandomRatedPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bNoGuess, const int32 MinThreeBV, const int32 MaxThreeBV,
+			const FMinesweeperBoardRating& MinRating, const FMinesweeperBoardRating& MaxRating);
+
+	/**
+	 * Sets up a game with a board from the open puzzle database instead of generating one. Puzzles are played from the cell they
+	 * were generated for, so the first click of a puzzle always opens its start cell. Not available in endless mode.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool SetupPuzzle(const int64 PuzzleId);
+
+	/** Sets up the puzzle shared with a board code, see GetBoardCode(). Works for boards in the open puzzle database. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool SetupPuzzleByCode(const FString& BoardCode);
+
+	/** Returns a short code for the current board, the same for all its rotations and reflections. Empty until the first cell has been opened. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FString GetBoardCode() const;
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE bool IsPuzzle() const { return PuzzleId != INDEX_NONE; }
+
+	/** Returns the cell the first click of the current puzzle opens, or -1 if the game is not a puzzle. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE int32 GetPuzzleStartCellIndex() const { return IsPuzzle() ? PuzzleStartIndex : INDEX_NONE; }
+
+
+	/**
+	 * Returns the cell the first click should open, from the first click table shipped with the plugin without any search. Puzzles
+	 * return their start cell, endless games -1.
+	 */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		int32 GetRecommendedFirstClickIndex() const;
+
+	/** Opens the recommended first click. Returns false if the game has already started. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool OpenRecommendedFirstClick();
+
+
+	/** Returns the difficulty metrics of the current board. All zero until the first cell has been opened, and in endless mode. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE FMinesweeperBoardMetrics GetBoardMetrics() const { return BoardMetrics; }
+
+	/** Returns the solver effort rating of the current puzzle, read from the puzzle database. All zero for generated boards, which are not rated. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE FMinesweeperBoardRating GetBoardRating() const { return BoardRating; }
+
+	/** Returns the board's 3BV cleared per second of game time. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE float GetThreeBVPerSecond() const { return GameTime > 0.0f ? BoardMetrics.ThreeBV / GameTime : 0.0f; }
+
+	/** Returns the estimated minimum clicks (ZiNi) divided by the clicks used so far. Values near 1 mean near optimal play. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE float GetClickEfficiency() const { return TotalClicks > 0 ? (float)BoardMetrics.ZiNi / (float)TotalClicks : 0.0f; }
+
+
+	/** Finds a closed cell that is provably safe from the opened cells. Returns false if none can be found without guessing. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool GetHintCell(int32& CellX, int32& CellY);
+
+	/**
+	 * Finds a hint on a background task without blocking the game thread and answers through OnHintReady. If the board changes
+	 * before the answer, the hint is restarted from the new position. Logic stuck positions are answered with the best guess, and a
+	 * game that has not started with its recommended first click. Returns false if the game is over or endless.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool RequestHint();
+
+	/** Drops the pending hint request without an answer. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		void CancelHint();
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE bool IsHintPending() const { return HintService.IsValid() && HintService->IsPending(); }
+
+	/** Broadcast on the game thread with the answer to RequestHint(). IsSafe is false for guesses, CellX and CellY are -1 if no cell can be hinted. */
+	UPROPERTY(BlueprintAssignable, Category = "Minesweeper")
+		FMinesweeperHintDelegate OnHintReady;
+
+	/** Flags every closed cell that is provably a mine and returns the number of new flags. Does not count as a click. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		int32 AutoFlagKnownMines();
+
+	/** Computes the exact mine probability of every closed cell for GetMineProbability(). Returns false if flags contradict the numbers. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool UpdateMineProbabilities();
+
+	/**
+	 * Works on mine probabilities for at most BudgetMilliseconds, for calling every frame. Small components are exact right away, large
+	 * ones are sampled and get more accurate with every call until the position changes. Returns true once probabilities are available.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		bool UpdateMineProbabilitiesWithin(const float BudgetMilliseconds = 1.0f);
+
+	/** Returns the mine probability of a cell from the last update, or -1 if there is none. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		float GetMineProbability(const int32 CellX, const int32 CellY) const;
+
+	/** Returns the standard error of a cell's mine probability, 0 if it is exact. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		float GetMineProbabilityError(const int32 CellX, const int32 CellY) const;
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE bool AreMineProbabilitiesExact() const { return ProbabilityEngine.HasProbabilities() && ProbabilityEngine.IsExact(); }
+
+	/** Returns the mine probabilities of the last update. */
+	FORCEINLINE const FMinesweeperProbabilityEngine& GetProbabilityEngine() const { return ProbabilityEngine; }
+
+	/** Returns the solver that follows the current game. Not updated in endless mode. */
+	FORCEINLINE const FMinesweeperSolver& GetSolver() const { return Solver; }
+
+	/** Returns the boundary between opened and closed cells of the current game. Not updated in endless mode. */
+	FORCEINLINE const FMinesweeperFrontier& GetFrontier() const { return Frontier; }
+
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE EMinesweeperGenerationMode GetGenerationMode() const { return GenerationMode; }
+
+	/** Sets how mines are placed for the next game. Takes effect on the first click of a new game. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		FORCEINLINE void SetGenerationMode(const EMinesweeperGenerationMode Mode) { GenerationMode = Mode; }
+
+	/**
+	 * Uses a fixed seed for all following games. Boards are reproducible bit for bit from seed, difficulty and first click.
+	 * Fixed seeds also bypass the background board pool, whose boards are generated from their own seeds.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		void SetGridRandomSeed(const int32 Seed);
+
+	/** Goes back to a new random seed for every game. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		void ClearGridRandomSeed();
+
+	/** Returns the seed used for the current game. */
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE int32 GetGridRandomSeed() const { return GridRandomSeed; }
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE bool HasFixedGridRandomSeed() const { return HasFixedSeed; }
+
+	/** Returns the mine layout of the current game. Holds no mines until the first cell has been opened, and stays empty in endless mode. */
+	FORCEINLINE const FMinesweeperBoard& GetBoard() const { return Board; }
+
+	/** Returns the mine layout of the current endless game. */
+	FORCEINLINE const FMinesweeperHashedMineField& GetMineField() const { return MineField; }
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE bool IsEndless() const { return GenerationMode == EMinesweeperGenerationMode::Endless; }
+
+	UFUNCTION(BlueprintPure, Category = "Minesweeper")
+		FORCEINLINE float GetEndlessMineDensity() const { return EndlessMineDensity; }
+
+	/** Sets the fraction of cells holding a mine in endless games, used in place of the difficulty's mine count. Takes effect on the first click of a new game. */
+	UFUNCTION(BlueprintCallable, Category = "Minesweeper")
+		void SetEndlessMineDensity(const float Density);
+
+
 protected:
 	//~ Begin FTickableGameObject Interface
 	virtual TStatId GetStatId() const override { RETURN_QUICK_DECLARE_CYCLE_STAT(UMinesweeperGame, STATGROUP_Tickables); }
@@ -143,9 +348,55 @@ protected:
 
 
 	int32 GridRandomSeed = 0;
+	bool HasFixedSeed = false;
+
+	EMinesweeperGenerationMode GenerationMode = EMinesweeperGenerationMode::Random;
+
+	/** Mine density of endless games, about that of Intermediate. */
+	float EndlessMineDensity = 0.16f;
 
 	FMinesweeperDifficulty Difficulty;
 
+	/** Mine layout generated on the first click. */
+	FMinesweeperBoard Board;
+
+	/** Difficulty metrics of Board, computed once when it is generated. */
+	FMinesweeperBoardMetrics BoardMetrics;
+
+	/** Solver effort rating of Board, only known for puzzles. */
+	FMinesweeperBoardRating BoardRating;
+
+	/** Canonical hash of Board, computed once when it is generated. */
+	FMinesweeperBoardHash BoardHash;
+
+	TSharedPtr<FMinesweeperPuzzleDatabase> PuzzleDatabase;
+
+	/** Puzzle the current game was set up from, INDEX_NONE for generated games. */
+	int64 PuzzleId = INDEX_NONE;
+	int32 PuzzleStartIndex = INDEX_NONE;
+
+	/** Deduces safe cells and mines from what the player has opened. Fed the changed cells after every action. */
+	FMinesweeperSolver Solver;
+
+	/** Opened and flagged cells as the player sees them, updated with the solver. */
+	FMinesweeperFrontier Frontier;
+
+	/** Mine probabilities of the position, computed on request from Frontier. */
+	FMinesweeperProbabilityEngine ProbabilityEngine;
+
+	/** Finds hints off the game thread, created by the first RequestHint(). */
+	TSharedPtr<FMinesweeperHintService, ESPMode::ThreadSafe> HintService;
+
+	/** True if the position changed since the anytime estimate was started. */
+	bool IsProbabilityEstimateStale = true;
+
+	/** Cells opened or flagged by the current action. */
+	TArray<int32> ChangedCells;
+
+	/** Mine layout of endless games, set up on the first click. */
+	FMinesweeperHashedMineField MineField;
+
+	/** All grid cells. Endless games only hold the cells that have been queried, the rest are created on demand by GetCell(). */
 	TMap<int32, TSharedRef<FMinesweeperCell>> CellMap;
 
 	bool IsActive = false;
@@ -172,10 +423,40 @@ public:
 	TArray<TSharedRef<FMinesweeperCell>> GetNeighborCells(const int32 InCellIndex);
 
 private:
+	/** Picks a new seed for the next game unless a fixed seed is set. */
+	void UpdateGridRandomSeed();
+
+	/** Copies mines and neighbor mine counts from the generated board into the grid cells. */
+	void ApplyBoard();
+
+	/** Unpacks the current puzzle's board and metrics from the database. */
+	void LoadPuzzleBoard();
+
+	/** True once mines have been placed by the first click. */
+	FORCEINLINE bool HasPlacedMines() const { return IsActive || GameTime > 0.0f; }
+
+	/** Sets a cell's mine and neighbor mine count from the endless mine field. */
+	void ApplyMineField(FMinesweeperCell& InCell, const int32 InCellIndex) const;
+
 	void OpenCell(TSharedPtr<FMinesweeperCell> InCell, const int32 InCellIndex);
 	void OpenNeighbors(TSharedPtr<FMinesweeperCell> InCell, const int32 InCellIndex);
 
+	/** Passes the cells changed by the current action to the frontier, the solver and OnCellsChanged. */
+	void FlushChangedCells();
+
+	/** Copies what the player can see of the board for the hint service. */
+	FMinesweeperHintSnapshot MakeHintSnapshot() const;
+
+	void HandleHintReady(const FMinesweeperHint& InHint);
+
+	/** Passes the cells whose mine probability changed to OnMineProbabilitiesChanged. */
+	void FlushChangedProbabilities();
+
 public:
+	/** Calls InFunc for every grid cell. Endless cells that were never queried are passed as temporary copies and changes to them are discarded. */
 	void ForEachCell(TFunctionRef<void(TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)> InFunc);
 
+	/** Like ForEachCell(), but only for the cells from InMinCoord up to and excluding InMaxCoord, clipped to the grid. Use this to visit part of an endless grid. */
+	void ForEachCellInRect(const FIntVector2& InMinCoord, const FIntVector2& InMaxCoord, TFunctionRef<void(TSharedRef<FMinesweeperCell> InCell, const int32 InCellIndex, const FVector2D InCellCoord)> InFunc);
+
 };
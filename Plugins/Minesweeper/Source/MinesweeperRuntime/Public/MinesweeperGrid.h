@@ -75,6 +75,14 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "MinesweeperGrid")
 		void UpdateResource();
 
+	/** Tints closed cells by their mine probability. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGrid")
+		void SetShowProbabilityOverlay(const bool Show);
+
+	/** Works on mine probabilities for at most BudgetMilliseconds and redraws the cells whose probability changed. Call every frame while the overlay is shown. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGrid")
+		void UpdateProbabilityOverlay(const float BudgetMilliseconds = 1.0f);
+
 
 	/** Removes all hovered cell drawing visualizations. */
 	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
@@ -7,6 +7,7 @@
 #include "MinesweeperGridCanvas.generated.h"
 
 class UMinesweeperGame;
+struct FMinesweeperCell;
 
 
 
@@ -23,6 +24,10 @@ public:
 	UMinesweeperGridCanvas();
 
 
+	/** Most cells drawn along each side. Larger grids, like endless ones, are drawn through a view window moved by SetViewOrigin(). */
+	static const int32 MaxViewCellCount = 64;
+
+
 	/** Returns the Minesweeper game logic object used to draw the grid. */
 	UFUNCTION(BlueprintPure, Category = "MinesweeperGrid")
 		FORCEINLINE UMinesweeperGame* GetGame() const { return Game; }
@@ -47,6 +52,23 @@ public:
 		void SetCellDrawSize(const float Size);
 
 
+	/** Returns the grid coordinate of the top left cell drawn. */
+	UFUNCTION(BlueprintPure, Category = "MinesweeperGridCanvas")
+		FORCEINLINE FIntPoint GetViewOrigin() const { return ViewOrigin; }
+
+	/** Moves the view window so CellX, CellY is the top left cell drawn, clamped to the grid. Redraws the whole view. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
+		void SetViewOrigin(const int32 CellX, const int32 CellY);
+
+	/** Moves the view window by a number of cells. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
+		void ScrollView(const int32 DeltaX, const int32 DeltaY);
+
+	/** Returns the number of cells drawn along each side, the render target size over the cell draw size. */
+	UFUNCTION(BlueprintPure, Category = "MinesweeperGridCanvas")
+		FIntPoint GetViewCellCount() const;
+
+
 	/** Returns the grid cell index based on a position on the grid and the cell draw size. Returns -1 if the grid position is invalid (off the grid). */
 	UFUNCTION(BlueprintPure, Category = "MinesweeperGridCanvas")
 		int32 GridPositionToCellIndex(const FVector2D& GridPosition) const;
@@ -73,6 +95,25 @@ public:
 		void SetHoverCellCoord(const int32 CellX, const int32 CellY); // FIntVector2 not supported in blueprints
 
 
+	/** Tints closed cells by their mine probability from the game's probability updates. Redraws the whole grid. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
+		void SetShowProbabilityOverlay(const bool Show);
+
+	UFUNCTION(BlueprintPure, Category = "MinesweeperGridCanvas")
+		FORCEINLINE bool IsProbabilityOverlayShown() const { return ShowProbabilityOverlay; }
+
+	/**
+	 * Works on the game's mine probabilities for at most BudgetMilliseconds and redraws only the cells whose probability changed.
+	 * Call every frame while the overlay is shown, large boards keep getting more accurate between clicks.
+	 */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
+		void UpdateProbabilityOverlay(const float BudgetMilliseconds = 1.0f);
+
+	/** Redraws only the cells marked dirty since the last draw on top of the current texture. UpdateResource() redraws every cell. */
+	UFUNCTION(BlueprintCallable, Category = "MinesweeperGridCanvas")
+		void RedrawDirtyCells();
+
+
 	/** Override this function to set your own colors for the neighboring mine count text. */
 	UFUNCTION(BlueprintNativeEvent, BlueprintCallable, Category = "MinesweeperGridCanvas")
 		FSlateColor GetNeighborMineCountColor(const int32 MineCount);
@@ -88,7 +129,29 @@ protected:
 
 	UPROPERTY() int32 HoverCellIndex = -1;
 
+	/** Grid coordinate of the top left cell drawn. */
+	UPROPERTY() FIntPoint ViewOrigin = FIntPoint::ZeroValue;
+
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "MinesweeperGridCanvas")
+		bool ShowProbabilityOverlay = false;
+
+	/** Cells to draw on the next RedrawDirtyCells(). Cleared by every full redraw. */
+	TArray<int32> DirtyCells;
+
+	/** True while RedrawDirtyCells() draws over the current texture instead of clearing it. */
+	bool IsRedrawingDirtyCells = false;
+
+	FDelegateHandle MineProbabilitiesChangedHandle;
+
 
 	UFUNCTION() virtual void UpdateCanvas(UCanvas* InCanvas, const int32 InWidth, const int32 InHeight);
 
+	/** Draws one cell with everything on top of it. */
+	void DrawGridCell(UCanvas* InCanvas, const FMinesweeperCell& InCell, const int32 InCellIndex, const FVector2D& InCellCoord);
+
+	void DrawCellTexture(UCanvas* InCanvas, const FVector2D& InPosition, const UTexture2D* InTexture, const FLinearColor& InColor = FLinearColor::White) const;
+
+	void HandleMineProbabilitiesChanged(TArrayView<const int32> InCellIndices);
+
 };
@@ -0,0 +1,102 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperFrontier.h"
+#include "MinesweeperProbability.h"
+
+
+
+
+/**
+ * Limits of a guess search.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperGuessSettings
+{
+	/** Closed cells scored at the top of the search, the least likely to hold a mine first. */
+	int32 MaxCandidates = 8;
+
+	/** Closed cells scored for each guess looked ahead. */
+	int32 MaxChildCandidates = 4;
+
+	/** Cells whose mine probability is further than this above the lowest are never candidates. */
+	float MaxProbabilityMargin = 0.1f;
+
+	/**
+	 * Guesses looked ahead after a guess that shows a number proving nothing. 0 scores such a number by the safest cell it leaves,
+	 * every level above multiplies the cost by about MaxChildCandidates times the numbers a cell can show.
+	 */
+	int32 Depth = 0;
+
+	/** Wall clock time the search may take. Candidates not fully scored by then are dropped, the safest cell is kept if none was. */
+	double BudgetSeconds = 0.05;
+
+	/**
+	 * Enumeration nodes each candidate may spend over every position it opens, 0 for no limit. Candidates over it are dropped like
+	 * those past BudgetSeconds, but the same ones on every machine and run, so searches can be compared. The positions are then
+	 * enumerated without the component cache, whose hits depend on what was computed before.
+	 */
+	int64 MaxNodes = 0;
+
+	/** 1 scores every candidate on the calling thread, any other value spreads candidates over the task graph workers. */
+	int32 NumWorkers = 0;
+};
+
+
+/**
+ * Outcome of a guess search.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperGuess
+{
+	/** Closed cell to open, INDEX_NONE if the position has no closed cell left or no probabilities. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** Mine probability of the cell. */
+	float MineProbability = 1.0f;
+
+	/** Chance to survive the guess and every guess looked ahead and come out with a provably safe cell or a won game. */
+	float ProgressProbability = 0.0f;
+
+	/** Candidates scored within the budget, out of those considered. */
+	int32 NumScored = 0;
+	int32 NumCandidates = 0;
+
+	/** Probability computations of positions after a guess. */
+	int32 NumPositions = 0;
+
+	/** Enumeration nodes spent on positions after a guess. */
+	int64 NumNodes = 0;
+
+	/** True if the time or node budget ran out or the search was cancelled before every candidate was scored. */
+	bool bTimedOut = false;
+
+	/** Wall clock time spent searching in seconds. */
+	double Seconds = 0.0;
+};
+
+
+/**
+ * Picks the guess most likely to lead somewhere when no cell is provably safe. The safest cell is not always best: a cell that is
+ * slightly more likely to hold a mine can be far more likely to show a number that proves its neighbors safe, while the safest cell
+ * often shows a number that proves nothing and forces another guess.
+ *
+ * Each candidate is opened in turn with every number it could show. The odds of each number are the ratio of the solution counts
+ * of the position after and before, and each outcome counts as a success if it leaves a provably safe cell, or is scored by the
+ * best guess it leaves otherwise, either the safest cell or a search of Depth more levels. Candidates are scored in parallel
+ * within a time or node budget, reusing the component cache for the positions they share.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperGuessEvaluator
+{
+public:
+	/**
+	 * Searches for the best guess in a position whose exact probabilities InProbabilityEngine holds. Falls back to the safest cell
+	 * for anytime estimates, which have no solution counts. Returns early with the best guess so far once InIsCancelled returns true.
+	 * @param InMineCount Total mines on the board, flagged or not.
+	 */
+	static FMinesweeperGuess FindBestGuess(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const FMinesweeperProbabilityEngine& InProbabilityEngine,
+		const FMinesweeperGuessSettings& InSettings, TFunctionRef<bool()> InIsCancelled);
+
+	static FMinesweeperGuess FindBestGuess(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const FMinesweeperProbabilityEngine& InProbabilityEngine,
+		const FMinesweeperGuessSettings& InSettings = FMinesweeperGuessSettings());
+
+};
@@ -0,0 +1,71 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperRandom.h"
+
+
+
+
+/**
+ * Mine layout defined by a pure function of seed and cell coordinate: a cell holds a mine when hash(seed, x, y) is below the density.
+ * Nothing is stored per cell, so fields of any size use constant memory and neighbor counts are computed on demand.
+ * Cells within SafeRadius of the first click never hold a mine. Plain data and thread safe.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperHashedMineField
+{
+	/** Key derived from the seed. */
+	uint64 Key = 0;
+
+	/** A cell holds a mine when its 32 bit hash is below this value. 0 means no mines at all. */
+	uint32 DensityThreshold = 0;
+
+	/** Center of the first click safe zone. */
+	int32 SafeX = 0;
+	int32 SafeY = 0;
+
+	/** Chebyshev radius of the first click safe zone. 1 keeps the first click and its neighbors free so it always opens an area. */
+	int32 SafeRadius = 1;
+
+
+	/** Sets up the field for a seed and a mine density in [0, 1] with the safe zone centered on the first click. */
+	void Init(const int32 InSeed, const double InDensity, const int32 InFirstClickX, const int32 InFirstClickY);
+
+	/** Removes all mines. */
+	void Reset();
+
+	/** Fraction of cells outside the safe zone that hold a mine on average. */
+	double GetDensity() const;
+
+
+	FORCEINLINE bool IsInSafeZone(const int32 InCellX, const int32 InCellY) const
+	{
+		return FMath::Abs(InCellX - SafeX) <= SafeRadius && FMath::Abs(InCellY - SafeY) <= SafeRadius;
+	}
+
+	FORCEINLINE bool HasMine(const int32 InCellX, const int32 InCellY) const
+	{
+		if (IsInSafeZone(InCellX, InCellY)) return false;
+
+		const uint64 coordKey = ((uint64)(uint32)InCellX << 32) | (uint64)(uint32)InCellY;
+		return (uint32)MinesweeperRandom::CombineKey(Key, coordKey) < DensityThreshold;
+	}
+
+	/** Number of mines surrounding a cell. Cells outside InWidth x InHeight are ignored so fields can be bounded by a grid. */
+	FORCEINLINE int32 GetNeighborMineCount(const int32 InCellX, const int32 InCellY, const int32 InWidth, const int32 InHeight) const
+	{
+		int32 neighborMineCount = 0;
+		for (int32 y = FMath::Max(InCellY - 1, 0); y <= FMath::Min(InCellY + 1, InHeight - 1); ++y)
+		{
+			for (int32 x = FMath::Max(InCellX - 1, 0); x <= FMath::Min(InCellX + 1, InWidth - 1); ++x)
+			{
+				if ((x != InCellX || y != InCellY) && HasMine(x, y))
+				{
+					++neighborMineCount;
+				}
+			}
+		}
+		return neighborMineCount;
+	}
+
+};
@@ -0,0 +1,90 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include <atomic>
+
+class FMinesweeperLatencyTracker;
+
+
+
+
+/**
+ * What the player can see of a board: opened numbers and flags, never the mines.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperHintSnapshot
+{
+	static const int8 ClosedCell = -1;
+	static const int8 FlaggedCell = -2;
+
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 MineCount = 0;
+
+	/** Neighbor mine count of every opened cell, ClosedCell or FlaggedCell for the rest. */
+	TArray<int8> Cells;
+};
+
+
+/**
+ * Answer to a hint request.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperHint
+{
+	/** Closed cell to open next, INDEX_NONE if the position has no closed cell left or contradicts itself. */
+	int32 CellIndex = INDEX_NONE;
+
+	/** True if the cell is provably safe. Otherwise it is the guess FMinesweeperGuessEvaluator picks. */
+	bool bIsSafe = false;
+
+	/** Mine probability of the cell, 0 for safe cells. */
+	float MineProbability = 0.0f;
+
+	/** Time from the request to the answer in seconds, including restarts. */
+	double Seconds = 0.0;
+};
+
+DECLARE_DELEGATE_OneParam(FMinesweeperHintReadyDelegate, const FMinesweeperHint&);
+
+
+/**
+ * Finds hints off the game thread. Each request solves a snapshot of the board on a background task, falling back to a guess search
+ * over exact mine probabilities when logic alone finds no safe cell. A new request cancels the running one, so a board that changes while a hint
+ * is pending restarts the hint from the new position. Answers are delivered on the game thread.
+ *
+ * Must be created with MakeShared and used from the game thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperHintService : public TSharedFromThis<FMinesweeperHintService, ESPMode::ThreadSafe>
+{
+public:
+	/** Called on the game thread with the answer to the latest request. Never called for cancelled requests. */
+	FMinesweeperHintReadyDelegate OnHintReady;
+
+	/** Starts finding a hint for the snapshot and cancels the pending request, whose latency carries over to this one. */
+	void Request(FMinesweeperHintSnapshot&& InSnapshot);
+
+	/** Drops the pending request without an answer. */
+	void Cancel();
+
+	/** True from Request() until OnHintReady is called or the request is cancelled. */
+	FORCEINLINE bool IsPending() const { return bIsPending; }
+
+	/** Finds a hint on the calling thread. Returns early without a hint once InIsCancelled returns true. */
+	static FMinesweeperHint FindHint(const FMinesweeperHintSnapshot& InSnapshot, TFunctionRef<bool()> InIsCancelled);
+
+	/** Request to answer latency of every hint delivered in this session. */
+	static FMinesweeperLatencyTracker& GetLatencyTracker();
+
+
+private:
+	/** Called on the game thread when the task of a request finishes. */
+	void Complete(const int32 InRequestId, const FMinesweeperHint& InHint);
+
+
+	/** Id of the latest request. Running tasks of older requests stop at their next cancellation check. */
+	std::atomic<int32> CurrentRequestId { 0 };
+
+	bool bIsPending = false;
+	double RequestStartTime = 0.0;
+
+};
@@ -0,0 +1,201 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperSolver.h"
+
+
+
+
+/**
+ * Bit parallel variant of FMinesweeperSolver with the same interface. Unknown, mine and opened cells are kept as bit rows, and every
+ * rule works on the 7x7 window around the number being evaluated, which holds the unknown neighbors of that number and of every
+ * number sharing one with it. Each constraint is then a 49 bit mask over the window, so subset, superset and intersection reasoning
+ * are AND, ANDNOT and popcount on a single word, and resolved cells are visited by walking the set bits.
+ *
+ * Rules: single point, pairs of overlapping numbers (which covers the scalar subset rule and also resolves the cells only one of two
+ * intersecting numbers can see) and the global mine count once nothing else applies. Plain data, one instance per thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperMaskSolver
+{
+public:
+	using ECellState = FMinesweeperSolver::ECellState;
+
+
+	/** Sizes the solver for a board and forgets everything. Reuses allocations when the size does not change. */
+	void Init(const int32 InWidth, const int32 InHeight, const int32 InMineCount);
+
+	/** Forgets everything about the current board. */
+	void Reset();
+
+	/** Tells the solver a cell has been opened and shows InNeighborMineCount. Takes effect on the next Solve(). */
+	void RevealCell(const int32 InCellIndex, const int32 InNeighborMineCount);
+
+	/** Applies the rules to every number affected since the last call until no rule makes progress. */
+	void Solve();
+
+
+	/** Returns a known safe cell that has not been opened yet, or INDEX_NONE. Does not remove it. */
+	int32 GetNextSafeCell();
+
+	/** Returns the next known safe cell that has not been opened yet and removes it, or INDEX_NONE. */
+	int32 PopSafeCell();
+
+	/** All cells known to hold a mine, in the order they were found. */
+	FORCEINLINE const TArray<int32>& GetKnownMines() const { return KnownMines; }
+
+	FORCEINLINE ECellState GetCellState(const int32 InCellIndex) const { return (ECellState)States[InCellIndex]; }
+	FORCEINLINE bool IsKnownSafe(const int32 InCellIndex) const { return States[InCellIndex] == ECellState::Safe || States[InCellIndex] == ECellState::Opened; }
+	FORCEINLINE bool IsKnownMine(const int32 InCellIndex) const { return States[InCellIndex] == ECellState::Mine; }
+
+	FORCEINLINE int32 GetWidth() const { return Width; }
+	FORCEINLINE int32 GetHeight() const { return Height; }
+	FORCEINLINE int32 GetMineCount() const { return MineCount; }
+	FORCEINLINE int32 Num() const { return Width * Height; }
+
+	FORCEINLINE int32 NumUnknownCells() const { return NumUnknown; }
+	FORCEINLINE int32 NumOpenedCells() const { return NumOpened; }
+
+	/** Number shown by an opened cell. */
+	FORCEINLINE int32 GetNumber(const int32 InCellIndex) const { return Numbers[InCellIndex]; }
+
+
+private:
+	/** Cells on each side of the window center, and empty rows and columns padding the bit rows so windows never leave them. */
+	static const int32 WindowRadius = 3;
+	static const int32 WindowSize = (WindowRadius * 2) + 1;
+
+	/** Bit of the window centered on a cell that holds the cell at offset (InX, InY) from the center. */
+	static FORCEINLINE int32 WindowBit(const int32 InX, const int32 InY) { return ((InY + WindowRadius) * WindowSize) + InX + WindowRadius; }
+
+	/** Window bits of the 8 neighbors of the window cell at offset (InX, InY), which must be at most 2 cells from the center. */
+	static FORCEINLINE uint64 NeighborMask(const int32 InX, const int32 InY)
+	{
+		const int32 topLeft = WindowBit(InX - 1, InY - 1);
+		return (0x7ull << topLeft) | (0x5ull << (topLeft + WindowSize)) | (0x7ull << (topLeft + (WindowSize * 2)));
+	}
+
+	/** Gathers the 7x7 window centered on a cell from one set of bit rows. */
+	uint64 GetWindow(const TArray<uint64>& InRows, const int32 InCellIndex) const;
+
+	void SetBit(TArray<uint64>& InOutRows, const int32 InCellIndex, const bool bInValue);
+
+	/** Marks the unknown cells of a window mask as safe or mines. Returns true if any cell changed. */
+	bool ResolveWindow(const int32 InCenterIndex, uint64 InMask, const bool bInAsMines);
+	void ResolveCell(const int32 InCellIndex, const bool bInAsMine);
+
+	/** Queues the opened cells whose constraints include a cell that just changed. */
+	void QueueAffected(const int32 InCellIndex);
+	void Queue(const int32 InCellIndex);
+
+	bool ApplySinglePoint(const int32 InCellIndex);
+	bool ApplyPairs(const int32 InCellIndex);
+	bool ApplyGlobal();
+
+
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 MineCount = 0;
+
+	/** Words per bit row, with WindowRadius padding columns on the left and at least one spare word on the right. */
+	int32 RowWords = 0;
+
+	/** One bit per cell, Height + 2 * WindowRadius rows of RowWords words. */
+	TArray<uint64> UnknownRows;
+	TArray<uint64> MineRows;
+	TArray<uint64> OpenedRows;
+
+	/** ECellState of each cell. */
+	TArray<uint8> States;
+
+	/** Numbers shown by opened cells. */
+	TArray<uint8> Numbers;
+
+	/** 1 for each opened cell waiting in DirtyCells. */
+	TArray<uint8> IsQueued;
+
+	/** Opened cells whose constraint changed since they were last evaluated. */
+	TArray<int32> DirtyCells;
+
+	/** Cells found safe, consumed by PopSafeCell(). May contain cells opened since. */
+	TArray<int32> SafeCells;
+
+	TArray<int32> KnownMines;
+
+	int32 NumUnknown = 0;
+	int32 NumOpened = 0;
+
+};
+
+
+/**
+ * Counts the solutions of a frontier component of up to 64 cells with every constraint kept as a bit mask over the component's cells.
+ * The search branches on whole constraints rather than single cells, taking them in the order of their lowest cell so it follows the
+ * component outward, and Gosper's hack walks the placements of a constraint's missing mines among its unassigned cells. Only the
+ * constraints sharing a cell with the branched one are checked, by popcount against the assigned and mine masks instead of keeping
+ * per constraint counters.
+ *
+ * Counts land in the raw count layout of FMinesweeperProbabilityEngine, which uses this for small enough components when
+ * SetUseMaskEnumeration() is on. Plain data, one instance per thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperMaskEnumerator
+{
+public:
+	static const int32 MaxCells = 64;
+
+
+	/** Sizes the enumerator for a component of InNumCells cells and forgets every constraint. */
+	void Init(const int32 InNumCells);
+
+	/** Adds a constraint: exactly InMines of the cells in InCellMask hold a mine. */
+	void AddConstraint(const uint64 InCellMask, const int32 InMines);
+
+	/**
+	 * Counts solutions with at most InMaxMines mines: OutSolutionCounts[k] solutions have k mines, OutCellMineCounts[(cell * (cells + 1)) + k]
+	 * of them put a mine on the cell. Returns false and leaves the counts empty if the search needs more than InMaxNodes nodes or
+	 * InShouldAbort, if set, returns true.
+	 */
+	bool Enumerate(const int32 InMaxMines, const int64 InMaxNodes, TArray<double>& OutSolutionCounts, TArray<double>& OutCellMineCounts, const TFunctionRef<bool()>* InShouldAbort = nullptr);
+
+	FORCEINLINE int32 NumCells() const { return CellCount; }
+	FORCEINLINE int32 NumConstraints() const { return ConstraintMasks.Num(); }
+
+	/** Search nodes the last Enumerate() visited. */
+	FORCEINLINE int64 NumNodes() const { return NodeCount; }
+
+
+private:
+	void Search(const int32 InOrderIndex, const uint64 InAssigned, const uint64 InMines);
+
+	/** False if a constraint sharing a cell with InConstraintIndex can no longer be met once its cells are assigned. */
+	bool IsConsistent(const int32 InConstraintIndex, const uint64 InAssigned, const uint64 InMines) const;
+
+	void Record(const uint64 InMines);
+
+
+	int32 CellCount = 0;
+
+	TArray<uint64> ConstraintMasks;
+	TArray<int32> ConstraintMines;
+
+	/** Constraints in the order the search branches on them. */
+	TArray<int32> ConstraintOrder;
+
+	/** Constraints of each cell, 8 slots per cell. */
+	TArray<int32> CellConstraints;
+	TArray<uint8> NumCellConstraints;
+
+	/** Constraints sharing a cell with each constraint, from OverlapStarts[constraint] up to OverlapStarts[constraint + 1]. */
+	TArray<int32> Overlaps;
+	TArray<int32> OverlapStarts;
+
+	/** Search state of the running Enumerate(). */
+	int32 MaxMines = 0;
+	int64 NodesLeft = 0;
+	int64 NodeCount = 0;
+	bool bAborted = false;
+	const TFunctionRef<bool()>* ShouldAbort = nullptr;
+	TArray<double>* SolutionCounts = nullptr;
+	TArray<double>* CellMineCounts = nullptr;
+
+};
@@ -0,0 +1,287 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperRandom.h"
+#include "MinesweeperFrontier.h"
+
+
+
+
+/**
+ * Outcome of computing mine probabilities for a position.
+ */
+struct MINESWEEPERRUNTIME_API FMinesweeperProbabilityResult
+{
+	/** False if no mine layout agrees with the opened numbers, flags and mine count, for example because a flag is wrong. */
+	bool bSuccess = false;
+
+	/** Closed cells next to an opened number. */
+	int32 NumFrontierCells = 0;
+
+	/** Closed cells away from every opened number. */
+	int32 NumInteriorCells = 0;
+
+	/** Independent groups of frontier cells that share no number. */
+	int32 NumComponents = 0;
+
+	/** Frontier cells in the largest component, which dominates the cost. */
+	int32 LargestComponent = 0;
+
+	/** True if every probability is exact. False while an anytime estimate still samples components. */
+	bool bExact = false;
+
+	/** True if Compute() was told to abort before every component was enumerated. bSuccess is false and there are no probabilities. */
+	bool bAborted = false;
+
+	/** Components too large to enumerate within the anytime node limit, estimated by sampling instead. */
+	int32 NumSampledComponents = 0;
+
+	/** Random probes taken so far over all sampled components. */
+	int64 NumProbes = 0;
+
+	/** Search nodes Compute() spent enumerating components, aborted ones included. Components found in the cache take none. */
+	int64 NumNodes = 0;
+
+	/** Wall clock time spent computing in seconds. */
+	double Seconds = 0.0;
+};
+
+
+/**
+ * Computes the exact probability of every closed cell holding a mine, given the opened numbers, the flags (taken as mines) and the
+ * total mine count. All layouts that agree with the position are equally likely.
+ *
+ * Frontier cells are split into components that share no number, the solutions of each component are enumerated on worker threads
+ * and counted by their number of mines, and the components are combined with the remaining interior cells, which hold the rest of the
+ * mines in C(interior, rest) ways. Enumeration is exponential in the size of the largest component, which stays small in practice.
+ *
+ * For per frame use there is also an anytime mode working within a time budget on the calling thread. Components are enumerated
+ * exactly up to a node limit, larger ones are estimated with Knuth's random probe estimator, and every call refines the estimate.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperProbabilityEngine
+{
+public:
+	/**
+	 * Computes probabilities for the position tracked by a frontier.
+	 * @param InMineCount Total mines on the board, flagged or not.
+	 * @param InNumWorkers 1 enumerates every component on the calling thread, any other value spreads components over the task graph workers.
+	 */
+	FMinesweeperProbabilityResult Compute(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const int32 InNumWorkers = 0);
+
+	/**
+	 * Compute() that gives up once InShouldAbort returns true, polled every AbortCheckNodes search nodes from the threads enumerating,
+	 * or once its components have searched InMaxNodes nodes between them. Keeps a dense position from blocking a caller that has to
+	 * stop, such as a cancelled hint. On one worker and without the component cache the node limit cuts off at the same place every run.
+	 */
+	FMinesweeperProbabilityResult Compute(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const int32 InNumWorkers, TFunctionRef<bool()> InShouldAbort,
+		const int64 InMaxNodes = MAX_int64);
+
+	/**
+	 * Starts an anytime estimate for a position and works on it for up to InBudgetSeconds. Probabilities are available once every
+	 * component has been enumerated or sampled at least once, which can take more than one call on a tight budget.
+	 * The frontier must not change until the next BeginEstimate().
+	 */
+	FMinesweeperProbabilityResult BeginEstimate(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, const double InBudgetSeconds, const int32 InSeed = 0);
+
+	/** Continues the estimate started by BeginEstimate() for up to InBudgetSeconds, at least one step. Does nothing once it is exact. */
+	FMinesweeperProbabilityResult RefineEstimate(const FMinesweeperFrontier& InFrontier, const double InBudgetSeconds);
+
+	/** Forgets the last computed probabilities. */
+	void Reset();
+
+	/** True if the last Compute() succeeded. */
+	FORCEINLINE bool HasProbabilities() const { return bHasProbabilities; }
+
+	FORCEINLINE bool IsValidIndex(const int32 InCellIndex) const { return Probabilities.IsValidIndex(InCellIndex); }
+
+	/** Mine probability of a cell: 0 for opened cells, 1 for flagged cells. */
+	FORCEINLINE float GetMineProbability(const int32 InCellIndex) const { return Probabilities[InCellIndex]; }
+
+	/** Mine probabilities of every cell from the last successful Compute(). */
+	FORCEINLINE TArrayView<const float> GetProbabilities() const { return Probabilities; }
+
+	/** Mine probability shared by all interior cells. */
+	FORCEINLINE float GetInteriorProbability() const { return InteriorProbability; }
+
+	/** True if the probabilities are exact rather than an anytime estimate that is still being refined. */
+	FORCEINLINE bool IsExact() const { return bIsExact; }
+
+	/**
+	 * Natural log of the number of mine layouts that agree with the position, only meaningful for exact probabilities. Comparing it
+	 * between positions gives the odds of each, such as how likely a guess is to show each number.
+	 */
+	FORCEINLINE double GetLogSolutionCount() const { return LogSolutionCount; }
+
+	/** Standard error of a cell's mine probability, 0 for exact probabilities. The true value lies within two errors 95% of the time. */
+	FORCEINLINE float GetMineProbabilityError(const int32 InCellIndex) const { return Errors.IsValidIndex(InCellIndex) ? Errors[InCellIndex] : 0.0f; }
+
+	/**
+	 * Cells whose mine probability moved by more than ProbabilityChangeTolerance since they were last listed, gathered over every
+	 * update since ClearChangedCells(). Every cell is listed after the first update of a position of a new size or after Reset().
+	 */
+	FORCEINLINE TArrayView<const int32> GetChangedCells() const { return ChangedCells.GetCells(); }
+
+	/** Empties the change list once its cells have been consumed. */
+	void ClearChangedCells();
+
+	/** Mine probability of a cell when it was last listed as changed, -1 if it never was. Within ProbabilityChangeTolerance of GetMineProbability(). */
+	FORCEINLINE float GetTrackedMineProbability(const int32 InCellIndex) const { return TrackedProbabilities.IsValidIndex(InCellIndex) ? TrackedProbabilities[InCellIndex] : -1.0f; }
+
+	/** Smallest move of a cell's mine probability that puts it on the change list. */
+	static constexpr float ProbabilityChangeTolerance = 1.0f / 256.0f;
+
+	/** Search nodes an anytime estimate spends on enumerating a component exactly before it samples the component instead. */
+	static const int64 AnytimeExactNodeLimit = 16384;
+
+	/** Search nodes between polls of the abort callback of Compute(). */
+	static const int64 AbortCheckNodes = 1024;
+
+	/** Random probes taken per sampled component between time checks. */
+	static const int32 AnytimeProbeBatchSize = 16;
+
+	/** Components with fewer cells are enumerated every time, looking them up costs about as much as counting them. */
+	static const int32 MinCachedComponentCells = 16;
+
+	/** Looks components up in FMinesweeperComponentCache before enumerating them and stores what was enumerated. On by default. */
+	FORCEINLINE void SetUseComponentCache(const bool bInUseComponentCache) { bUseComponentCache = bInUseComponentCache; }
+
+	/** Enumerates components of up to FMinesweeperMaskEnumerator::MaxCells cells with bit masks instead of the scalar search. Off by default. */
+	FORCEINLINE void SetUseMaskEnumeration(const bool bInUseMaskEnumeration) { bUseMaskEnumeration = bInUseMaskEnumeration; }
+
+
+private:
+	/** Number shown by an opened cell, limited to the frontier cells of one component. */
+	struct FConstraint
+	{
+		int32 RemainingMines = 0;
+		int32 NumCells = 0;
+
+		/** Positions of the constraint's cells in the component's cell order. */
+		int32 Cells[8];
+	};
+
+	enum class EComponentState : uint8
+	{
+		/** Not yet enumerated or sampled. */
+		Pending,
+
+		/** Solutions counted exactly. */
+		Exact,
+
+		/** Solutions estimated from random probes. */
+		Sampled
+	};
+
+	/** Frontier cells connected by shared numbers, enumerated independently of every other component. */
+	struct FComponent
+	{
+		EComponentState State = EComponentState::Pending;
+
+		/** Zobrist style hash of the constraints over cell offsets from BaseCell, the same wherever the component lies on the board. Rebuilt by every Decompose(). */
+		uint64 Hash = 0;
+
+		/** Lowest cell index of the component. */
+		int32 BaseCell = 0;
+
+		/** Search nodes of its last enumeration, 0 if its counts came from the component cache. */
+		int64 NumNodes = 0;
+
+		TArray<int32> Cells;
+		TArray<FConstraint> Constraints;
+
+		/** Constraints of each cell, 8 slots per cell. */
+		TArray<int32> CellConstraints;
+		TArray<uint8> NumCellConstraints;
+
+		/** Number of solutions with k mines, for k in [0, Cells.Num()]. Sums of probe weights for sampled components. */
+		TArray<double> RawSolutionCounts;
+
+		/** Number of solutions with k mines that put a mine on each cell, (Cells.Num() + 1) slots per cell. */
+		TArray<double> RawCellMineCounts;
+
+		/** Raw counts scaled as described in FinalizeCounts(), used to combine components. */
+		TArray<double> SolutionCounts;
+		TArray<double> CellMineCounts;
+
+		/** Log of what FinalizeCounts() divided the counts by. */
+		double LogCountScale = 0.0;
+
+		/** Probe statistics of sampled components. Weights are relative to exp(ReferenceLogWeight). */
+		int64 NumProbes = 0;
+		double SumWeights = 0.0;
+		double SumSquaredWeights = 0.0;
+		double ReferenceLogWeight = 0.0;
+
+		/** Effective number of independent samples behind the estimate of a sampled component. */
+		FORCEINLINE double GetEffectiveSamples() const { return SumSquaredWeights > 0.0 ? (SumWeights * SumWeights) / SumSquaredWeights : 0.0; }
+	};
+
+	/** Splits the frontier into components and sets up the global mine counts. Returns false if the position has no solution. */
+	bool Decompose(const FMinesweeperFrontier& InFrontier, const int32 InMineCount, FMinesweeperProbabilityResult& OutResult);
+
+	/** Combines the finalized counts of every component with the interior into probabilities. */
+	bool Combine(const FMinesweeperFrontier& InFrontier, FMinesweeperProbabilityResult& OutResult);
+
+	/** Anytime work loop shared by BeginEstimate() and RefineEstimate(). */
+	FMinesweeperProbabilityResult RunEstimate(const FMinesweeperFrontier& InFrontier, const double InStartTime, const double InBudgetSeconds);
+
+	/**
+	 * Counts the solutions of a component with at most InMaxMines mines into its raw counts by depth first search with constraint
+	 * bound pruning. Returns false and leaves the raw counts empty if the search needs more than InMaxNodes nodes or InShouldAbort,
+	 * if set, returns true.
+	 */
+	static bool Enumerate(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort = nullptr);
+
+	/** Enumerate() or the bit mask enumerator, whichever is enabled and fits the component. Same results either way. */
+	bool EnumerateComponent(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort) const;
+
+	/** EnumerateComponent() through the component cache. Hits fill the raw counts without a search, successful searches are stored. */
+	bool EnumerateCached(FComponent& InOutComponent, const int32 InMaxMines, const int64 InMaxNodes, const TFunctionRef<bool()>* InShouldAbort = nullptr) const;
+
+	/**
+	 * Adds random probes to a component's raw counts. Each probe walks down the search tree taking a random viable branch at every cell
+	 * and weighs the solution it reaches by the product of the branch counts, an unbiased estimate of the solution counts (Knuth 1975).
+	 */
+	static void Sample(FComponent& InOutComponent, const int32 InMaxMines, const int32 InNumProbes, FMinesweeperRandomStream& InOutRandStream);
+
+	/** Scales raw counts with k mines by exp(k * InLogMineOdds) and normalizes them so the largest is 1, keeping the log of the divisor. */
+	static void FinalizeCounts(FComponent& InOutComponent, const double InLogMineOdds);
+
+	/** Sets a cell's probability and lists the cell as changed if it moved too far from its tracked probability. */
+	void TrackProbability(const int32 InCellIndex, const float InProbability);
+
+	/** Reorders a component's cells breadth first over shared constraints, so constraints complete early and prune early. */
+	static void OrderCells(FComponent& InOutComponent);
+
+
+	TArray<float> Probabilities;
+	TArray<float> Errors;
+	float InteriorProbability = 0.0f;
+	double LogSolutionCount = 0.0;
+	bool bHasProbabilities = false;
+	bool bIsExact = false;
+	bool bUseComponentCache = true;
+	bool bUseMaskEnumeration = false;
+
+	/** Probabilities as of each cell's last listing in ChangedCells. */
+	TArray<float> TrackedProbabilities;
+	FMinesweeperCellSet ChangedCells;
+
+	/** Position being computed, set up by Decompose(). */
+	int32 RemainingMines = 0;
+	int32 NumInteriorCells = 0;
+	double LogMineOdds = 0.0;
+
+	/** Anytime estimate in progress, set up by BeginEstimate(). */
+	FMinesweeperProbabilityResult EstimateResult;
+	FMinesweeperRandomStream RandStream = FMinesweeperRandomStream(0);
+
+	/** Scratch storage reused between calls. */
+	TArray<FComponent> Components;
+	TArray<int32> CellComponents;
+	TArray<int32> CellPositions;
+	TArray<int32> FrontierCells;
+	TArray<int32> Parents;
+
+};
@@ -0,0 +1,268 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "MinesweeperDifficulty.h"
+#include "MinesweeperBoard.h"
+#include "MinesweeperBoardMetrics.h"
+#include "MinesweeperBoardRating.h"
+#include "MinesweeperRandom.h"
+#include "MinesweeperBoardHash.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+
+
+
+/**
+ * File header of a puzzle database. A database holds one section per difficulty, each an array of fixed size records.
+ * All values are little endian and every section starts aligned, so records can be read in place from a mapped file.
+ */
+struct FMinesweeperPuzzleFileHeader
+{
+	uint32 Magic = 0;
+	uint32 Version = 0;
+	uint32 NumSections = 0;
+
+	/** Offset of the section table, an array of NumSections FMinesweeperPuzzleSection. */
+	uint32 SectionTableOffset = 0;
+};
+
+/**
+ * Location and layout of all records of one difficulty.
+ */
+struct FMinesweeperPuzzleSection
+{
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 MineCount = 0;
+
+	/** Size of one record in bytes: the record header followed by the bit-packed mine layout, padded to 8 bytes. */
+	uint32 RecordSize = 0;
+
+	uint64 NumRecords = 0;
+	uint64 RecordsOffset = 0;
+
+	/** Offset of the record index, NumRecords FMinesweeperPuzzleIndexEntry sorted by key, or 0 if the section has none. */
+	uint64 IndexOffset = 0;
+
+	/** Offset of the hash index, NumRecords FMinesweeperPuzzleHashEntry sorted by short key, or 0 if the section has none. */
+	uint64 HashIndexOffset = 0;
+};
+
+/**
+ * Header of a single puzzle record. The mine layout follows directly, one bit per cell in cell index order, lowest bit first.
+ */
+struct FMinesweeperPuzzleRecord
+{
+	enum EFlags : uint8
+	{
+		/** The board can be cleared from FirstClickIndex without guessing. */
+		NoGuess = 1 << 0
+	};
+
+	uint16 ThreeBV = 0;
+	uint16 Openings = 0;
+	uint16 Islands = 0;
+	uint16 ZiNi = 0;
+
+	/** The cell the board was generated for. It and its neighbors are free of mines when room allows. */
+	uint16 FirstClickIndex = 0;
+
+	uint8 Flags = 0;
+
+	/** Solver effort, see FMinesweeperBoardRating. */
+	uint8 DeductionDepth = 0;
+
+	/** Seed the board was generated from. */
+	int32 Seed = 0;
+
+	uint16 Guesses = 0;
+	uint16 MaxComponentSize = 0;
+	uint32 Reserved = 0;
+
+	FORCEINLINE bool IsNoGuess() const { return (Flags & NoGuess) != 0; }
+
+	FORCEINLINE FMinesweeperBoardRating GetRating() const
+	{
+		FMinesweeperBoardRating rating;
+		rating.Guesses = Guesses;
+		rating.MaxComponentSize = MaxComponentSize;
+		rating.DeductionDepth = DeductionDepth;
+		return rating;
+	}
+
+	FORCEINLINE const uint8* GetMineBits() const { return reinterpret_cast<const uint8*>(this + 1); }
+	FORCEINLINE uint8* GetMineBits() { return reinterpret_cast<uint8*>(this + 1); }
+};
+
+/**
+ * Entry of a section's record index. Entries are sorted by the no-guess flag, then 3BV, then record index.
+ */
+struct FMinesweeperPuzzleIndexEntry
+{
+	uint32 SortKey = 0;
+	uint32 RecordIndex = 0;
+
+	static FORCEINLINE uint32 MakeSortKey(const bool bInNoGuess, const int32 InThreeBV)
+	{
+		return ((bInNoGuess ? 1u : 0u) << 16) | (uint32)FMath::Clamp(InThreeBV, 0, (int32)MAX_uint16);
+	}
+
+	FORCEINLINE bool operator < (const FMinesweeperPuzzleIndexEntry& InOther) const
+	{
+		return SortKey != InOther.SortKey ? SortKey < InOther.SortKey : RecordIndex < InOther.RecordIndex;
+	}
+};
+
+/**
+ * Entry of a section's hash index, mapping the short code key of a board's canonical hash to its record.
+ */
+struct FMinesweeperPuzzleHashEntry
+{
+	uint64 ShortKey = 0;
+	uint32 RecordIndex = 0;
+	uint32 Reserved = 0;
+
+	FORCEINLINE bool operator < (const FMinesweeperPuzzleHashEntry& InOther) const
+	{
+		return ShortKey != InOther.ShortKey ? ShortKey < InOther.ShortKey : RecordIndex < InOther.RecordIndex;
+	}
+};
+
+static_assert(sizeof(FMinesweeperPuzzleFileHeader) == 16, "Puzzle database file header layout changed.");
+static_assert(sizeof(FMinesweeperPuzzleSection) == 48, "Puzzle database section layout changed.");
+static_assert(sizeof(FMinesweeperPuzzleRecord) == 24, "Puzzle database record layout changed.");
+static_assert(sizeof(FMinesweeperPuzzleIndexEntry) == 8, "Puzzle database index layout changed.");
+static_assert(sizeof(FMinesweeperPuzzleHashEntry) == 16, "Puzzle database hash index layout changed.");
+
+
+namespace MinesweeperPuzzleDatabase
+{
+	/** "MSPZ" */
+	static const uint32 Magic = 0x5A50534D;
+	static const uint32 Version = 3;
+
+	static const uint32 SectionAlignment = 16;
+
+	FORCEINLINE int32 GetMineBitsSize(const FMinesweeperDifficulty& InDifficulty) { return (InDifficulty.TotalCells() + 7) / 8; }
+	FORCEINLINE int32 GetRecordSize(const FMinesweeperDifficulty& InDifficulty) { return Align((int32)sizeof(FMinesweeperPuzzleRecord) + GetMineBitsSize(InDifficulty), 8); }
+
+	/** Writes the board's mines as bits, GetMineBitsSize() bytes. */
+	MINESWEEPERRUNTIME_API void PackMines(const FMinesweeperBoard& InBoard, uint8* OutBits);
+
+	/** Rebuilds a full board, including neighbor counts and opening labels, from bit-packed mines. */
+	MINESWEEPERRUNTIME_API void UnpackMines(const uint8* InBits, const FMinesweeperDifficulty& InDifficulty, FMinesweeperBoard& OutBoard);
+
+	/** Puzzle ids combine a section index and a record index. */
+	FORCEINLINE int64 MakePuzzleId(const int32 InSectionIndex, const int32 InRecordIndex) { return ((int64)InSectionIndex << 32) | (uint32)InRecordIndex; }
+	FORCEINLINE int32 GetSectionIndex(const int64 InPuzzleId) { return (int32)(InPuzzleId >> 32); }
+	FORCEINLINE int32 GetRecordIndex(const int64 InPuzzleId) { return (int32)(uint32)InPuzzleId; }
+}
+
+
+/**
+ * Builds a puzzle database in memory and saves it to a file. Records of a section can be written from multiple threads at once
+ * as long as each record index is written by one thread. Boards that are rotations or reflections of an earlier board are dropped on save.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperPuzzleDatabaseWriter
+{
+public:
+	/** Adds a section with room for InNumRecords records and returns its index. Sections with no written records hold empty boards. */
+	int32 AddSection(const FMinesweeperDifficulty& InDifficulty, const int32 InNumRecords);
+
+	/** Writes a board, its metrics and its rating as a record of a section. */
+	void WriteRecord(const int32 InSectionIndex, const int32 InRecordIndex, const FMinesweeperBoard& InBoard, const FMinesweeperBoardMetrics& InMetrics,
+		const FMinesweeperBoardRating& InRating, const int32 InFirstClickIndex, const int32 InSeed, const bool bInNoGuess);
+
+	FORCEINLINE int32 NumSections() const { return Sections.Num(); }
+	FORCEINLINE int32 NumRecords(const int32 InSectionIndex) const { return Sections[InSectionIndex].NumRecords; }
+
+	/** Writes the database to a file. Returns false if the file could not be written. */
+	bool Save(const FString& InFilename) const;
+
+
+private:
+	struct FSectionData
+	{
+		FMinesweeperDifficulty Difficulty;
+		int32 NumRecords = 0;
+		int32 RecordSize = 0;
+		TArray64<uint8> Records;
+
+		/** Canonical hash of each record's board. */
+		TArray<FMinesweeperBoardHash> Hashes;
+	};
+
+	TArray<FSectionData> Sections;
+
+};
+
+
+/**
+ * Read-only puzzle database backed by a memory mapped file. Records are used in place, opening a database only validates its tables.
+ * Thread safe once opened.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperPuzzleDatabase
+{
+public:
+	FMinesweeperPuzzleDatabase();
+	~FMinesweeperPuzzleDatabase();
+
+	/**
+	 * Maps a database file. Falls back to reading the file into memory on platforms without memory mapping. Every section and index
+	 * entry is checked against the file here, which touches each index once, so lookups can trust them.
+	 */
+	bool Open(const FString& InFilename);
+
+	void Close();
+
+	FORCEINLINE bool IsOpen() const { return Data != nullptr; }
+
+
+	FORCEINLINE int32 NumSections() const { return Sections.Num(); }
+	FORCEINLINE const FMinesweeperPuzzleSection& GetSection(const int32 InSectionIndex) const { return *Sections[InSectionIndex]; }
+	FORCEINLINE FMinesweeperDifficulty GetSectionDifficulty(const int32 InSectionIndex) const
+	{
+		return FMinesweeperDifficulty(Sections[InSectionIndex]->Width, Sections[InSectionIndex]->Height, Sections[InSectionIndex]->MineCount);
+	}
+
+	/** Returns the section holding boards of a difficulty, or INDEX_NONE. */
+	int32 FindSection(const FMinesweeperDifficulty& InDifficulty) const;
+
+	/** Returns the record for a puzzle id, or nullptr if the id is not in the database. */
+	const FMinesweeperPuzzleRecord* GetRecord(const int64 InPuzzleId) const;
+
+	/** Returns the index entries of a section with the no-guess flag and 3BV in [InMinThreeBV, InMaxThreeBV]. Binary search, O(log n). */
+	TArrayView<const FMinesweeperPuzzleIndexEntry> FindRecords(const int32 InSectionIndex, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV) const;
+
+	/** Returns the puzzle whose canonical board hash has the short key, see FMinesweeperBoardHash::ToShortCode(). INDEX_NONE if not found. */
+	int64 FindPuzzleByShortKey(const uint64 InShortKey) const;
+
+	/** Picks a uniformly random puzzle matching a query. Returns INDEX_NONE if none matches. */
+	int64 FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV, FMinesweeperRandomStream& InRandStream) const;
+
+	/**
+	 * Picks a uniformly random puzzle matching a query whose rating lies within [InMinRating, InMaxRating] field by field. Ratings are read
+	 * from the records, so the cost is a scan of the records in the 3BV range rather than any analysis.
+	 */
+	int64 FindRandomPuzzle(const FMinesweeperDifficulty& InDifficulty, const bool bInNoGuess, const int32 InMinThreeBV, const int32 InMaxThreeBV,
+		const FMinesweeperBoardRating& InMinRating, const FMinesweeperBoardRating& InMaxRating, FMinesweeperRandomStream& InRandStream) const;
+
+
+private:
+	bool ValidateAndBind(const FString& InFilename);
+
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+
+	/** File contents when memory mapping is not available. */
+	TArray64<uint8> LoadedData;
+
+	const uint8* Data = nullptr;
+	int64 DataSize = 0;
+
+	TArray<const FMinesweeperPuzzleSection*> Sections;
+
+};
@@ -0,0 +1,164 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+
+/**
+ * Counter based random engines. Each engine is a pure function of a 64 bit key and a 64 bit counter, so output never depends on
+ * platform, call history or thread, and jumping ahead is a counter addition.
+ */
+namespace MinesweeperRandom
+{
+	/** SplitMix64 finalizer, used to derive keys from seeds. */
+	FORCEINLINE uint64 Mix64(uint64 InValue)
+	{
+		InValue += 0x9E3779B97F4A7C15ull;
+		InValue = (InValue ^ (InValue >> 30)) * 0xBF58476D1CE4E5B9ull;
+		InValue = (InValue ^ (InValue >> 27)) * 0x94D049BB133111EBull;
+		return InValue ^ (InValue >> 31);
+	}
+
+	/** Combines a key with another value into a new well mixed key. */
+	FORCEINLINE uint64 CombineKey(const uint64 InKey, const uint64 InValue)
+	{
+		return Mix64(InKey ^ Mix64(InValue));
+	}
+}
+
+
+/**
+ * Philox4x32-10 (Salmon et al. 2011). Produces four 32 bit values per counter and passes BigCrush.
+ */
+struct FMinesweeperPhiloxEngine
+{
+	static const int32 BlockSize = 4;
+
+	static FORCEINLINE void Generate(const uint64 InKey, const uint64 InCounter, uint32 OutBlock[BlockSize])
+	{
+		uint32 counter[4] = { (uint32)InCounter, (uint32)(InCounter >> 32), 0u, 0u };
+		uint32 key[2] = { (uint32)InKey, (uint32)(InKey >> 32) };
+
+		for (int32 round = 0; round < 10; ++round)
+		{
+			const uint64 product0 = (uint64)0xD2511F53u * counter[0];
+			const uint64 product1 = (uint64)0xCD9E8D57u * counter[2];
+
+			const uint32 next0 = (uint32)(product1 >> 32) ^ counter[1] ^ key[0];
+			const uint32 next1 = (uint32)product1;
+			const uint32 next2 = (uint32)(product0 >> 32) ^ counter[3] ^ key[1];
+			const uint32 next3 = (uint32)product0;
+
+			counter[0] = next0;
+			counter[1] = next1;
+			counter[2] = next2;
+			counter[3] = next3;
+
+			key[0] += 0x9E3779B9u;
+			key[1] += 0xBB67AE85u;
+		}
+
+		OutBlock[0] = counter[0];
+		OutBlock[1] = counter[1];
+		OutBlock[2] = counter[2];
+		OutBlock[3] = counter[3];
+	}
+};
+
+
+/**
+ * SplitMix64 applied to key + counter. Cheaper than Philox with weaker statistical guarantees, fine for mine placement.
+ */
+struct FMinesweeperSplitMixEngine
+{
+	static const int32 BlockSize = 2;
+
+	static FORCEINLINE void Generate(const uint64 InKey, const uint64 InCounter, uint32 OutBlock[BlockSize])
+	{
+		const uint64 value = MinesweeperRandom::Mix64(InKey + (InCounter * 0x9E3779B97F4A7C15ull));
+		OutBlock[0] = (uint32)value;
+		OutBlock[1] = (uint32)(value >> 32);
+	}
+};
+
+
+/**
+ * Reproducible random stream over a counter based engine. Streams created with different stream ids from the same seed are
+ * independent, so work can be split across threads without sharing generator state.
+ */
+template <typename EngineType>
+class TMinesweeperRandomStream
+{
+public:
+	TMinesweeperRandomStream(const uint64 InSeed, const uint64 InStreamId = 0)
+		: Key(MinesweeperRandom::CombineKey(MinesweeperRandom::Mix64(InSeed), InStreamId))
+	{ }
+
+
+	/** Returns an independent stream derived from this stream's key. */
+	TMinesweeperRandomStream Split(const uint64 InStreamId) const
+	{
+		TMinesweeperRandomStream stream(0);
+		stream.Key = MinesweeperRandom::CombineKey(Key, InStreamId);
+		return stream;
+	}
+
+	/** Skips ahead by a number of engine blocks in constant time. */
+	void Jump(const uint64 InNumBlocks)
+	{
+		Counter += InNumBlocks;
+		BlockIndex = EngineType::BlockSize;
+	}
+
+
+	uint32 NextUInt32()
+	{
+		if (BlockIndex >= EngineType::BlockSize)
+		{
+			EngineType::Generate(Key, Counter++, Block);
+			BlockIndex = 0;
+		}
+		return Block[BlockIndex++];
+	}
+
+	/** Returns a uniformly distributed value in [0, InRange) using Lemire's multiply and reject method. */
+	uint32 NextBounded(const uint32 InRange)
+	{
+		if (InRange <= 1) return 0;
+
+		uint64 product = (uint64)NextUInt32() * InRange;
+		uint32 low = (uint32)product;
+		if (low < InRange)
+		{
+			const uint32 threshold = (0u - InRange) % InRange;
+			while (low < threshold)
+			{
+				product = (uint64)NextUInt32() * InRange;
+				low = (uint32)product;
+			}
+		}
+		return (uint32)(product >> 32);
+	}
+
+	/** Returns a uniformly distributed value in [InMin, InMax], matching FRandomStream::RandRange. */
+	int32 RandRange(const int32 InMin, const int32 InMax)
+	{
+		if (InMax <= InMin) return InMin;
+		return InMin + (int32)NextBounded((uint32)(InMax - InMin) + 1u);
+	}
+
+
+private:
+	uint64 Key = 0;
+	uint64 Counter = 0;
+
+	uint32 Block[EngineType::BlockSize];
+	int32 BlockIndex = EngineType::BlockSize;
+
+};
+
+
+/** Default generator for board generation. */
+typedef TMinesweeperRandomStream<FMinesweeperPhiloxEngine> FMinesweeperRandomStream;
@@ -0,0 +1,170 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+
+/**
+ * Deterministic rule based Minesweeper solver that only knows what a player sees. It is fed the cells opened by each action and
+ * re-evaluates only the number constraints those cells touch, so the steady state cost per action is proportional to the changed frontier.
+ *
+ * Rules: single point (a number is satisfied, or needs all its unknown neighbors), subset (the unknowns of one number are a subset of
+ * a nearby number's unknowns), line patterns such as 1-2-1 looked up in a compile time table (see MinesweeperPatterns.h) and the
+ * global mine count once nothing else applies. Plain data, one instance per thread.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperSolver
+{
+public:
+	enum ECellState : uint8
+	{
+		/** Nothing is known about the cell. */
+		Unknown = 0,
+
+		/** The cell is known to be safe but has not been opened. */
+		Safe = 1,
+
+		/** The cell has been opened and shows its number. */
+		Opened = 2,
+
+		/** The cell is known to hold a mine. */
+		Mine = 3
+	};
+
+	/** Rules in order of the reasoning they take, see GetHardestRule(). */
+	enum ERule : uint8
+	{
+		NoRule = 0,
+		SinglePointRule = 1,
+		SubsetRule = 2,
+		PatternRule = 3,
+		GlobalRule = 4
+	};
+
+
+	/** Sizes the solver for a board and forgets everything. Reuses allocations when the size does not change. */
+	void Init(const int32 InWidth, const int32 InHeight, const int32 InMineCount);
+
+	/** Forgets everything about the current board. */
+	void Reset();
+
+	/** Tells the solver a cell has been opened and shows InNeighborMineCount. Takes effect on the next Solve(). */
+	void RevealCell(const int32 InCellIndex, const int32 InNeighborMineCount);
+
+	/** Applies the rules to every number affected since the last call until no rule makes progress. */
+	void Solve();
+
+
+	/** Returns a known safe cell that has not been opened yet, or INDEX_NONE. Does not remove it. */
+	int32 GetNextSafeCell();
+
+	/** Returns the next known safe cell that has not been opened yet and removes it, or INDEX_NONE. */
+	int32 PopSafeCell();
+
+	/** All cells known to hold a mine, in the order they were found. */
+	FORCEINLINE const TArray<int32>& GetKnownMines() const { return KnownMines; }
+
+	FORCEINLINE ECellState GetCellState(const int32 InCellIndex) const { return (ECellState)States[InCellIndex]; }
+	FORCEINLINE bool IsKnownSafe(const int32 InCellIndex) const { return States[InCellIndex] == Safe || States[InCellIndex] == Opened; }
+	FORCEINLINE bool IsKnownMine(const int32 InCellIndex) const { return States[InCellIndex] == Mine; }
+
+	FORCEINLINE int32 GetWidth() const { return Width; }
+	FORCEINLINE int32 GetHeight() const { return Height; }
+	FORCEINLINE int32 GetMineCount() const { return MineCount; }
+	FORCEINLINE int32 Num() const { return Width * Height; }
+
+	FORCEINLINE int32 NumUnknownCells() const { return NumUnknown; }
+	FORCEINLINE int32 NumOpenedCells() const { return NumOpened; }
+
+	/** Number shown by an opened cell. */
+	FORCEINLINE int32 GetNumber(const int32 InCellIndex) const { return Numbers[InCellIndex]; }
+
+
+	/** Enables the line pattern rule. On by default. */
+	FORCEINLINE void SetUsePatterns(const bool bInUsePatterns) { bUsePatterns = bInUsePatterns; }
+
+	/** Line pattern lookups since the last Reset(), and how many of them resolved cells. */
+	FORCEINLINE int64 NumPatternLookups() const { return PatternLookups; }
+	FORCEINLINE int64 NumPatternHits() const { return PatternHits; }
+
+	/** Hardest rule that resolved a cell since the last Reset(). */
+	FORCEINLINE ERule GetHardestRule() const { return (ERule)HardestRule; }
+
+
+	/** Calls InFunc(NeighborIndex) for each of the up to 8 cells surrounding a cell. */
+	template <typename FuncType>
+	FORCEINLINE void ForEachNeighbor(const int32 InCellIndex, FuncType&& InFunc) const
+	{
+		const int32 cellX = InCellIndex % Width;
+		const int32 cellY = InCellIndex / Width;
+		for (int32 y = FMath::Max(cellY - 1, 0); y <= FMath::Min(cellY + 1, Height - 1); ++y)
+		{
+			for (int32 x = FMath::Max(cellX - 1, 0); x <= FMath::Min(cellX + 1, Width - 1); ++x)
+			{
+				const int32 neighborIndex = (Width * y) + x;
+				if (neighborIndex != InCellIndex)
+				{
+					InFunc(neighborIndex);
+				}
+			}
+		}
+	}
+
+
+private:
+	/** Gathers the unknown neighbors of an opened cell and returns the mines still missing around it. */
+	int32 GatherUnknowns(const int32 InCellIndex, int32 OutUnknowns[8], int32& OutNumUnknowns) const;
+
+	/** Marks unknown cells as safe or mines. Returns true if any cell changed. */
+	bool Resolve(const int32* InCells, const int32 InNumCells, const bool bInAsMines);
+
+	/** Queues the opened cells whose constraints include a cell that just changed. */
+	void QueueAffected(const int32 InCellIndex);
+	void Queue(const int32 InCellIndex);
+
+	bool ApplySinglePoint(const int32 InCellIndex);
+	bool ApplySubset(const int32 InCellIndex);
+	bool ApplyPatterns(const int32 InCellIndex);
+	bool ApplyGlobal();
+
+
+	int32 Width = 0;
+	int32 Height = 0;
+	int32 MineCount = 0;
+
+	/** ECellState of each cell. */
+	TArray<uint8> States;
+
+	/** Numbers shown by opened cells. */
+	TArray<uint8> Numbers;
+
+	enum EQueued : uint8
+	{
+		QueuedDirty = 1 << 0,
+		QueuedDeferred = 1 << 1
+	};
+
+	/** EQueued flags of each opened cell waiting in DirtyCells or DeferredCells. */
+	TArray<uint8> IsQueued;
+
+	/** Opened cells whose constraint changed since they were last evaluated. */
+	TArray<int32> DirtyCells;
+
+	/** Opened cells the single point rule could not resolve, waiting for the subset and pattern rules. */
+	TArray<int32> DeferredCells;
+
+	/** Cells found safe, consumed by PopSafeCell(). May contain cells opened since. */
+	TArray<int32> SafeCells;
+
+	TArray<int32> KnownMines;
+
+	int32 NumUnknown = 0;
+	int32 NumOpened = 0;
+
+	bool bUsePatterns = true;
+	int64 PatternLookups = 0;
+	int64 PatternHits = 0;
+	uint8 HardestRule = NoRule;
+
+};
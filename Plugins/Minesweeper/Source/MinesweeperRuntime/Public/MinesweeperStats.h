@@ -0,0 +1,40 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Stats/Stats.h"
+#include "HAL/CriticalSection.h"
+
+
+DECLARE_STATS_GROUP(TEXT("Minesweeper"), STATGROUP_Minesweeper, STATCAT_Advanced);
+
+
+
+
+/**
+ * Keeps a sliding window of recent latency samples and reports percentiles over them. Thread safe.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperLatencyTracker
+{
+public:
+	explicit FMinesweeperLatencyTracker(const int32 InMaxSamples = 1024);
+
+	/** Adds a latency sample in seconds, replacing the oldest sample once the window is full. */
+	void AddSample(const double InSeconds);
+
+	/** Returns the latency in seconds below which the given percent (0-100) of the samples fall. */
+	double GetPercentile(const float InPercentile) const;
+
+	/** Number of samples currently in the window. */
+	int32 Num() const;
+
+	void Reset();
+
+private:
+	mutable FCriticalSection SamplesLock;
+
+	TArray<double> Samples;
+	int32 MaxSamples = 1024;
+	int32 NextSampleIndex = 0;
+
+};
@@ -0,0 +1,52 @@
+// Copyright 2022 Brad Monahan. All Rights Reserved.
+#pragma once
+
+#include "CoreMinimal.h"
+
+
+
+
+/**
+ * Whole board pass that finds every trivially safe and trivially mined cell at once. Counts closed and flagged neighbors of every cell
+ * with the same 3x3 stencil that computes board neighbor mine counts, marks the numbers that are satisfied by their flags or need all
+ * their closed neighbors, and spreads those marks back to the closed cells with a second stencil.
+ *
+ * Unlike FMinesweeperSolver it keeps no state between calls and applies no rule beyond single numbers, so it is the fast path for
+ * bulk work on large boards: auto-resolving, bots that restart from arbitrary positions and validating positions. Plain data, one
+ * instance per thread so the scratch planes are reused.
+ */
+class MINESWEEPERRUNTIME_API FMinesweeperSweep
+{
+public:
+	/**
+	 * Sweeps a position given as byte planes of InWidth * InHeight cells. InOpened is 1 for opened cells, InNumbers holds the numbers
+	 * of opened cells and InFlagged is 1 for flagged cells, which must not be opened. Flags are trusted, numbers they contradict are
+	 * skipped, and cells that would come out both safe and mined are left out.
+	 */
+	void Sweep(const int32 InWidth, const int32 InHeight, TArrayView<const uint8> InOpened, TArrayView<const uint8> InNumbers, TArrayView<const uint8> InFlagged);
+
+	/** Closed unflagged cells next to a number whose flags are all placed, ascending. */
+	FORCEINLINE const TArray<int32>& GetSafeCells() const { return SafeCells; }
+
+	/** Closed unflagged cells next to a number that needs every closed neighbor as a mine, ascending. */
+	FORCEINLINE const TArray<int32>& GetMineCells() const { return MineCells; }
+
+
+	/**
+	 * Writes the sum of the 8 surrounding cells of every cell of a byte plane, whose values must be 0 or 1. Separable 3x3 box sum
+	 * minus the center, 16 cells per step with SSE2 where available. bInAllowVector false forces the scalar path.
+	 */
+	static void SumNeighbors(const uint8* InPlane, const int32 InWidth, const int32 InHeight, uint8* OutSums, const bool bInAllowVector = true);
+
+
+private:
+	TArray<uint8> ClosedPlane;
+	TArray<uint8> ClosedSums;
+	TArray<uint8> FlaggedSums;
+	TArray<uint8> SafeSources;
+	TArray<uint8> MineSources;
+
+	TArray<int32> SafeCells;
+	TArray<int32> MineCells;
+
+};
@@ -50,6 +50,14 @@ struct MINESWEEPERRUNTIME_API FMinesweeperVisualTheme
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperVisualTheme")
 		FLinearColor HoverCellInvalidColor;
 
+	/** Tint of closed cells that are certainly safe when the mine probability overlay is shown. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperVisualTheme")
+		FLinearColor ProbabilityOverlaySafeColor = FLinearColor(0.0f, 1.0f, 0.0f, 0.4f);
+
+	/** Tint of closed cells that are certainly mines when the mine probability overlay is shown. Other cells blend between the two tints. */
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "MinesweeperVisualTheme")
+		FLinearColor ProbabilityOverlayMineColor = FLinearColor(1.0f, 0.0f, 0.0f, 0.4f);
+
 
 	void CopyIfNotNull(const FMinesweeperVisualTheme& CopyFrom);
 	void CopyObjectsIfNotNull(const FMinesweeperVisualTheme& CopyFrom);
@@ -44,6 +44,7 @@ public:
 	//virtual FCursorReply OnCursorQuery(const FGeometry& InMyGeometry, const FPointerEvent& InCursorEvent) const override;
 	//virtual TOptional<TSharedRef<SWidget>> OnMapCursor(const FCursorReply& InCursorReply) const override;
 	virtual FReply OnMouseButtonDown(const FGeometry& InMyGeometry,const FPointerEvent& InMouseEvent) override;
+	virtual FReply OnMouseWheel(const FGeometry& InMyGeometry, const FPointerEvent& InMouseEvent) override;
 	virtual void OnMouseEnter(const FGeometry& InMyGeometry, const FPointerEvent& InMouseEvent) override;
 	virtual void OnMouseLeave(const FPointerEvent& InMouseEvent) override;
 	virtual FReply OnMouseMove(const FGeometry& InMyGeometry, const FPointerEvent& InMouseEvent) override;
@@ -74,6 +75,9 @@ public:
 
 	void UpdateResource();
 
+	void SetShowProbabilityOverlay(const bool bInShow);
+	void UpdateProbabilityOverlay(const float InBudgetMilliseconds);
+
 
 private:
 	FMinesweeperVisualTheme VisualTheme;